@@ -0,0 +1,88 @@
+/* bench-compose.c -- Measure composition frame rate versus number of layers.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "bench.h"
+
+/* Numbers of layers to measure.  */
+static const guint layers[] = {1, 2, 4, 8, 16};
+
+/* Number of frames composed per measurement.  */
+#define FRAMES  150
+
+int
+main (void)
+{
+  gsize i;
+
+  bench_json_begin ("compose");
+  for (i = 0; i < nelementsof (layers); i++)
+    {
+      lp_Scene *scene;
+      lp_Event *event;
+      lp_SceneStats before;
+      lp_SceneStats after;
+      guint64 frames;
+      gint64 elapsed;
+      gint64 t0;
+      guint j;
+
+      /* Layers are half-transparent still images covering the whole
+         scene, so that the measurement is dominated by blending rather
+         than by decoding.  */
+      scene = bench_scene_new (800, 600);
+      for (j = 0; j < layers[i]; j++)
+        {
+          lp_Media *media;
+
+          media = lp_media_new (scene, SAMPLE_PNG);
+          g_assert_nonnull (media);
+          g_object_set (media,
+                        "x", (gint) j,
+                        "y", (gint) j,
+                        "z", (gint) j + 1,
+                        "width", 800,
+                        "height", 600,
+                        "alpha", .5,
+                        NULL);
+          g_assert (lp_media_start (media));
+        }
+      for (j = 0; j < layers[i]; j++)
+        {
+          event = bench_await (scene, LP_EVENT_MASK_START);
+          g_assert_nonnull (event);
+          g_object_unref (event);
+        }
+
+      lp_scene_get_stats (scene, &before);
+      t0 = bench_now ();
+      for (j = 0; j < FRAMES; j++)
+        g_assert (lp_scene_advance (scene, BENCH_FRAME));
+      elapsed = max (bench_now () - t0, 1);
+      lp_scene_get_stats (scene, &after);
+      frames = after.frames_composed - before.frames_composed;
+
+      bench_json_result ("\"layers\":%u,\"frames\":%" G_GUINT64_FORMAT
+                         ",\"elapsed_us\":%" G_GINT64_FORMAT
+                         ",\"fps\":%.2f", layers[i], frames, elapsed,
+                         (gdouble) frames * 1e6 / (gdouble) elapsed);
+      g_object_unref (scene);
+    }
+  bench_json_end ();
+
+  exit (EXIT_SUCCESS);
+}
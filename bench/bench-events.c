@@ -0,0 +1,70 @@
+/* bench-events.c -- Measure event dispatch throughput.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "bench.h"
+
+/* Number of events per run.  */
+#define EVENTS  100000
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  bench_Stats dispatch;
+  bench_Stats receive;
+  guint i;
+
+  scene = bench_scene_new (800, 600);
+  bench_stats_init (&dispatch);
+  bench_stats_init (&receive);
+
+  for (i = 0; i < BENCH_RUNS; i++)
+    {
+      lp_Event *event;
+      gint64 t0;
+      guint n;
+
+      t0 = bench_now ();
+      for (n = 0; n < EVENTS; n++)
+        _lp_scene_dispatch (scene, LP_EVENT (_lp_event_tick_new (scene, n)));
+      bench_stats_add (&dispatch, bench_now () - t0);
+
+      t0 = bench_now ();
+      for (n = 0; n < EVENTS; n++)
+        {
+          event = bench_await (scene, LP_EVENT_MASK_TICK);
+          g_assert_nonnull (event);
+          g_object_unref (event);
+        }
+      bench_stats_add (&receive, bench_now () - t0);
+    }
+
+  bench_json_begin ("events");
+  bench_json_result ("\"phase\":\"dispatch\",\"events\":%u,"
+                     BENCH_STATS_FORMAT ",\"events_per_s\":%.0f",
+                     EVENTS, BENCH_STATS_ARGS (&dispatch),
+                     EVENTS * 1e6 / (gdouble) max (dispatch.min, 1));
+  bench_json_result ("\"phase\":\"receive\",\"events\":%u,"
+                     BENCH_STATS_FORMAT ",\"events_per_s\":%.0f",
+                     EVENTS, BENCH_STATS_ARGS (&receive),
+                     EVENTS * 1e6 / (gdouble) max (receive.min, 1));
+  bench_json_end ();
+
+  g_object_unref (scene);
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,92 @@
+/* bench-first-frame.c -- Measure time to first frame per format.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "bench.h"
+
+/* Samples by format.  */
+static const struct
+{
+  const gchar *format;
+  const gchar *uri;
+} formats[] = {
+  {"avi", SAMPLE_AVI},
+  {"gif", SAMPLE_GIF},
+  {"jpg", SAMPLE_JPG},
+  {"m4v", SAMPLE_M4V},
+  {"mp3", SAMPLE_MP3},
+  {"mp4", SAMPLE_MP4},
+  {"oga", SAMPLE_OGA},
+  {"ogv", SAMPLE_OGV},
+  {"png", SAMPLE_PNG},
+};
+
+/* Returns the time (in microseconds) between starting @uri in a fresh
+   scene and receiving its start event.  */
+
+static gint64
+first_frame (const gchar *uri)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  GObject *source;
+  gint64 t0;
+  gint64 t1;
+
+  scene = bench_scene_new (800, 600);
+  media = lp_media_new (scene, uri);
+  g_assert_nonnull (media);
+
+  t0 = bench_now ();
+  g_assert (lp_media_start (media));
+  do
+    {
+      event = bench_await (scene, LP_EVENT_MASK_START);
+      g_assert_nonnull (event);
+      source = lp_event_get_source (event);
+      g_object_unref (event);
+    }
+  while (source != G_OBJECT (media));
+  t1 = bench_now ();
+
+  g_object_unref (scene);
+  return t1 - t0;
+}
+
+int
+main (void)
+{
+  gsize i;
+
+  bench_json_begin ("first-frame");
+  for (i = 0; i < nelementsof (formats); i++)
+    {
+      bench_Stats st;
+      guint j;
+
+      bench_stats_init (&st);
+      for (j = 0; j < BENCH_RUNS; j++)
+        bench_stats_add (&st, first_frame (formats[i].uri));
+
+      bench_json_result ("\"format\":\"%s\"," BENCH_STATS_FORMAT,
+                         formats[i].format, BENCH_STATS_ARGS (&st));
+    }
+  bench_json_end ();
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,131 @@
+/* bench-net-clock.c -- Measure drift between scenes sharing a network clock.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "bench.h"
+
+/* Length of the run (seconds).  */
+#define DURATION  30
+
+/* Number of samples per second.  */
+#define RATE      10
+
+/* Maximum time for the follower clock to synchronize (seconds).  */
+#define SYNC_TIMEOUT  10
+
+/* Returns the absolute difference between the running time of @follower
+   and that of @scene, taken as the middle of two reads around the read of
+   @follower.  */
+
+static GstClockTime
+net_scene_skew (lp_Scene *scene, lp_Scene *follower)
+{
+  GstClockTime t0, t1, t;
+
+  t0 = _lp_scene_get_running_time (scene);
+  t = _lp_scene_get_running_time (follower);
+  t1 = _lp_scene_get_running_time (scene);
+
+  return (GstClockTime) ABS ((gint64) t - (gint64) (t0 + (t1 - t0) / 2));
+}
+
+/* Creates a real-time headless scene that publishes (if @follow is
+   false) or follows (otherwise) the network clock at @address:@port.  */
+
+static lp_Scene *
+net_scene_new (const gchar *address, gint port, gboolean follow)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 160,
+                                  "height", 120,
+                                  "headless", TRUE,
+                                  follow ? "net-clock-follow"
+                                  : "net-clock-publish", address,
+                                  "net-clock-port", port,
+                                  NULL));
+  g_assert_nonnull (scene);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_object_set (media, "loop", TRUE, NULL);
+  g_assert (lp_media_start (media));
+
+  while (!GST_CLOCK_TIME_IS_VALID (_lp_scene_get_running_time (scene)))
+    g_usleep (1000);            /* not started yet */
+
+  return scene;
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Scene *follower;
+  bench_Stats drift;
+  gint port = 0;
+  guint frames;
+  guint i;
+
+  scene = net_scene_new ("127.0.0.1", 0, FALSE);
+  g_object_get (scene, "net-clock-port", &port, NULL);
+  g_assert (port > 0);
+  follower = net_scene_new ("127.0.0.1", port, TRUE);
+
+  /* The follower starts at once; measure only after it has converged.  */
+  for (i = 0; i < SYNC_TIMEOUT * RATE; i++)
+    {
+      if (net_scene_skew (scene, follower) <= BENCH_FRAME)
+        break;
+      g_usleep (G_USEC_PER_SEC / RATE);
+    }
+
+  bench_stats_init (&drift);
+  frames = 0;
+  for (i = 0; i < DURATION * RATE; i++)
+    {
+      GstClockTime d;
+
+      d = net_scene_skew (scene, follower);
+      bench_stats_add (&drift, (gint64) d / 1000);
+      if (d > BENCH_FRAME)
+        frames++;
+
+      g_usleep (G_USEC_PER_SEC / RATE);
+    }
+
+  bench_json_begin ("net-clock");
+  bench_json_result ("\"seconds\":%d," BENCH_STATS_FORMAT
+                     ",\"over_one_frame\":%u",
+                     DURATION, BENCH_STATS_ARGS (&drift), frames);
+  bench_json_end ();
+
+  g_object_unref (follower);
+  g_object_unref (scene);
+
+  /* Scenes sharing a network clock must agree within one frame.  */
+  if (frames > 0)
+    {
+      g_printerr ("bench-net-clock: skew exceeded one frame %u times\n",
+                  frames);
+      exit (EXIT_FAILURE);
+    }
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,81 @@
+/* bench-seek.c -- Measure seek latency per format.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "bench.h"
+
+/* Video samples by format.  */
+static const struct
+{
+  const gchar *format;
+  const gchar *uri;
+} formats[] = {
+  {"avi", SAMPLE_AVI},
+  {"m4v", SAMPLE_M4V},
+  {"mp4", SAMPLE_MP4},
+  {"ogv", SAMPLE_OGV},
+};
+
+/* Number of seeks per format.  */
+#define SEEKS  (4 * BENCH_RUNS)
+
+int
+main (void)
+{
+  gsize i;
+
+  bench_json_begin ("seek");
+  for (i = 0; i < nelementsof (formats); i++)
+    {
+      lp_Scene *scene;
+      lp_Media *media;
+      lp_Event *event;
+      bench_Stats st;
+      guint j;
+
+      scene = bench_scene_new (800, 600);
+      media = lp_media_new (scene, formats[i].uri);
+      g_assert_nonnull (media);
+      g_assert (lp_media_start (media));
+      event = bench_await (scene, LP_EVENT_MASK_START);
+      g_assert_nonnull (event);
+      g_object_unref (event);
+
+      bench_stats_init (&st);
+      for (j = 0; j < SEEKS; j++)
+        {
+          gint64 t0;
+
+          /* Alternate among absolute positions in the first two seconds,
+             so that consecutive seeks never hit the same keyframe.  */
+          t0 = bench_now ();
+          g_assert (lp_media_seek (media, FALSE,
+                                   (gint64)(j % 4) * GST_SECOND / 2));
+          event = bench_await (scene, LP_EVENT_MASK_SEEK);
+          g_assert_nonnull (event);
+          g_object_unref (event);
+          bench_stats_add (&st, bench_now () - t0);
+        }
+
+      bench_json_result ("\"format\":\"%s\"," BENCH_STATS_FORMAT,
+                         formats[i].format, BENCH_STATS_ARGS (&st));
+      g_object_unref (scene);
+    }
+  bench_json_end ();
+
+  exit (EXIT_SUCCESS);
+}
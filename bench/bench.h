@@ -0,0 +1,163 @@
+/* bench.h -- Common declarations for benchmarks.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <config.h>
+#include "macros.h"
+#include "gx-macros.h"
+#include "gstx-macros.h"
+
+GX_INCLUDE_PROLOGUE
+#include "play.h"
+#include "play-internal.h"
+GX_INCLUDE_EPILOGUE
+
+PRAGMA_DIAG_IGNORE (-Wfloat-equal)
+PRAGMA_DIAG_IGNORE (-Winline)
+
+#include "test-samples.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+/* Duration of a single frame (nanoseconds).  */
+#define BENCH_FRAME  (GST_SECOND / 30)
+
+/* Default number of runs per measurement.  */
+#define BENCH_RUNS   5
+
+/* Returns the current monotonic time in microseconds.  */
+#define bench_now()  g_get_monotonic_time ()
+
+/* Creates a benchmark scene: lock-step mode and headless output, so that
+   results depend neither on the wall clock nor on output devices.  */
+
+static ATTR_UNUSED lp_Scene *
+bench_scene_new (gint width, gint height)
+{
+  lp_Scene *scene;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", width,
+                                  "height", height,
+                                  "lockstep", TRUE,
+                                  "headless", TRUE,
+                                  NULL));
+  g_assert_nonnull (scene);
+  return scene;
+}
+
+/* Waits for an event that matches @mask in @scene, advancing the scene
+   clock one frame whenever no event is pending.  Returns the event.  */
+
+static ATTR_UNUSED lp_Event *
+bench_await (lp_Scene *scene, guint mask)
+{
+  lp_Event *event;
+
+  for (;;)
+    {
+      event = lp_scene_receive (scene, FALSE);
+      if (event == NULL)
+        {
+          lp_scene_advance (scene, BENCH_FRAME);
+          continue;
+        }
+      if (lp_event_get_mask (event) & mask)
+        break;
+      g_object_unref (event);
+    }
+  return event;
+}
+
+/* Summary of a series of measurements.  */
+typedef struct _bench_Stats
+{
+  guint n;                      /* number of samples */
+  gint64 min;                   /* smallest sample */
+  gint64 max;                   /* largest sample */
+  gint64 sum;                   /* sum of samples */
+} bench_Stats;
+
+#define bench_stats_init(st)                    \
+  STMT_BEGIN                                    \
+  {                                             \
+    (st)->n = 0;                                \
+    (st)->min = G_MAXINT64;                     \
+    (st)->max = 0;                              \
+    (st)->sum = 0;                              \
+  }                                             \
+  STMT_END
+
+#define bench_stats_add(st, x)                  \
+  STMT_BEGIN                                    \
+  {                                             \
+    (st)->n++;                                  \
+    (st)->min = min ((st)->min, (x));           \
+    (st)->max = max ((st)->max, (x));           \
+    (st)->sum += (x);                           \
+  }                                             \
+  STMT_END
+
+#define bench_stats_mean(st)\
+  ((st)->n > 0 ? (st)->sum / (gint64)(st)->n : 0)
+
+/* JSON output.  Each benchmark writes a single object to stdout:
+   {"benchmark": NAME, "results": [RESULT, ...]}.  */
+
+static gboolean bench_json_first = TRUE;
+
+static ATTR_UNUSED void
+bench_json_begin (const gchar *name)
+{
+  printf ("{\"benchmark\":\"%s\",\"results\":[", name);
+  bench_json_first = TRUE;
+}
+
+static ATTR_UNUSED void G_GNUC_PRINTF (1, 2)
+bench_json_result (const gchar *fmt, ...)
+{
+  va_list args;
+
+  printf ("%s\n {", bench_json_first ? "" : ",");
+  va_start (args, fmt);
+  vprintf (fmt, args);
+  va_end (args);
+  printf ("}");
+  bench_json_first = FALSE;
+  fflush (stdout);
+}
+
+static ATTR_UNUSED void
+bench_json_end (void)
+{
+  printf ("]}\n");
+  fflush (stdout);
+}
+
+/* Writes the fields of @st (in microseconds) as JSON members.  */
+#define BENCH_STATS_FORMAT\
+  "\"runs\":%u,\"min_us\":%" G_GINT64_FORMAT\
+  ",\"mean_us\":%" G_GINT64_FORMAT ",\"max_us\":%" G_GINT64_FORMAT
+
+#define BENCH_STATS_ARGS(st)\
+  (st)->n, (st)->min, bench_stats_mean ((st)), (st)->max
+
+#endif /* BENCH_H */
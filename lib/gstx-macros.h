@@ -36,8 +36,12 @@ along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
 
 GSTX_INCLUDE_PROLOGUE
 #include <gst/gst.h>
+#include <gst/base/gstbasesrc.h>
+#include <gst/audio/audio.h>
 #include <gst/audio/gstaudiobasesink.h>
 #include <gst/video/navigation.h>
+#include <gst/video/video.h>
+#include <gst/net/net.h>
 GSTX_INCLUDE_EPILOGUE
 
 
@@ -166,6 +170,34 @@ gstx_element_get_clock_time (GstElement *elt)
   }                                                             \
   STMT_END
 
+/* Queries the latency upstream of @pad.  Returns the minimum latency if
+   successful, or zero otherwise.  If @live is non-NULL, stores in it
+   whether the upstream elements are live.  */
+
+static GstClockTime ATTR_UNUSED
+gstx_pad_query_latency (GstPad *pad, gboolean *live)
+{
+  GstQuery *query;
+  GstClockTime min;
+  gboolean is_live;
+
+  min = 0;
+  is_live = FALSE;
+
+  query = gst_query_new_latency ();
+  g_assert_nonnull (query);
+  if (gst_pad_query (pad, query))
+    {
+      gst_query_parse_latency (query, &is_live, &min, NULL);
+      if (!GST_CLOCK_TIME_IS_VALID (min))
+        min = 0;
+    }
+  gst_query_unref (query);
+
+  set_if_nonnull (live, is_live);
+  return min;
+}
+
 
 /* Returns the value of pointer @field in structure @st.
    Aborts if there is no such field of if it does not contain a pointer.  */
@@ -61,6 +61,12 @@ GX_INCLUDE_EPILOGUE
   G_DEFINE_TYPE (TN, t_n, T_P)                  \
   GX_INCLUDE_EPILOGUE
 
+/* Warning-free G_DEFINE_TYPE_WITH_CODE wrapper.  */
+#define GX_DEFINE_TYPE_WITH_CODE(TN, t_n, T_P, _C_)     \
+  GX_INCLUDE_PROLOGUE                                   \
+  G_DEFINE_TYPE_WITH_CODE (TN, t_n, T_P, _C_)           \
+  GX_INCLUDE_EPILOGUE
+
 
 /* Gets the #GParamSpec of property @name of @obj.   */
 #define gx_object_find_property(obj, name)\
@@ -79,4 +85,81 @@ gx_object_find_property_type (GObject *obj, const gchar *name)
   return G_PARAM_SPEC_VALUE_TYPE (pspec);
 }
 
+
+/* 64-bit atomic access, for counters that would overflow a 32-bit gsize.
+   GLib has no 64-bit atomics, so these use the compiler builtins.  */
+#define gx_atomic_uint64_add(p, n)\
+  ((void) __atomic_fetch_add ((p), (guint64)(n), __ATOMIC_RELAXED))
+#define gx_atomic_uint64_get(p)  __atomic_load_n ((p), __ATOMIC_RELAXED)
+#define gx_atomic_uint64_set(p, v)\
+  __atomic_store_n ((p), (guint64)(v), __ATOMIC_RELAXED)
+
+
+/* Sequence lock.  Writers must be serialized by some other lock; readers
+   never block, they retry if a write happened while they were reading.
+   The sequence number is odd while a write is in progress.  The protected
+   fields are plain memory, so the fences order them against the sequence
+   number: a release fence after the writer makes it odd and before it
+   makes it even again, and an acquire fence before the reader re-reads
+   it.  */
+typedef struct _gx_seqlock_t
+{
+  gint seq;                     /* sequence number */
+} gx_seqlock_t;
+
+#define gx_seqlock_init(sl)  g_atomic_int_set (&(sl)->seq, 0)
+
+#define gx_seqlock_write_begin(sl)                      \
+  STMT_BEGIN                                            \
+  {                                                     \
+    g_atomic_int_inc (&(sl)->seq);                      \
+    __atomic_thread_fence (__ATOMIC_RELEASE);           \
+  }                                                     \
+  STMT_END
+
+#define gx_seqlock_write_end(sl)                        \
+  STMT_BEGIN                                            \
+  {                                                     \
+    __atomic_thread_fence (__ATOMIC_RELEASE);           \
+    g_atomic_int_inc (&(sl)->seq);                      \
+  }                                                     \
+  STMT_END
+
+/* Returns the sequence number to be passed to gx_seqlock_read_retry().  */
+
+static ATTR_UNUSED gint
+gx_seqlock_read_begin (gx_seqlock_t *sl)
+{
+  gint seq;
+
+  while ((seq = g_atomic_int_get (&sl->seq)) & 1)
+    ;                           /* write in progress */
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return seq;
+}
+
+/* Returns true if @sl was written since gx_seqlock_read_begin() returned
+   @seq, in which case the values read must be discarded.  */
+
+static ATTR_UNUSED gboolean
+gx_seqlock_read_retry (gx_seqlock_t *sl, gint seq)
+{
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return g_atomic_int_get (&sl->seq) != seq;
+}
+
+/* Reads into @dst the expression @src protected by @sl.  */
+#define gx_seqlock_read(sl, dst, src)                   \
+  STMT_BEGIN                                            \
+  {                                                     \
+    gint __seq;                                         \
+    do                                                  \
+      {                                                 \
+        __seq = gx_seqlock_read_begin ((sl));           \
+        (dst) = (src);                                  \
+      }                                                 \
+    while (gx_seqlock_read_retry ((sl), __seq));        \
+  }                                                     \
+  STMT_END
+
 #endif /* GX_MACROS_H */
@@ -23,13 +23,13 @@ along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
 struct _lp_Clock
 {
   GstSystemClock parent;        /* parent object */
-  GMutex mutex;                 /* sync access to clock object */
+  GMutex mutex;                 /* sync writers of clock object */
+  gx_seqlock_t seq;             /* sync readers of clock object */
   gboolean lockstep;            /* true if clock advances in lock-step */
-  GstClock *sysclock;           /* system clock */
+  GstClock *sysclock;           /* source clock (system clock) */
   GstClockTime time;            /* clock time */
   GstClockTime unlock_time;     /* clock time when lock-step was disabled */
   GstClockTime unlock_systime;  /* systime when lock-step was disabled */
-  GstClockTime init_systime;    /* systime when the clock is instantiated */
 };
 
 /* Clock properties. */
@@ -46,10 +46,31 @@ enum
 GX_DEFINE_TYPE (lp_Clock, lp_clock, GST_TYPE_SYSTEM_CLOCK)
 
 
-#define clock_lock(clock)         g_mutex_lock (&((clock)->mutex))
-#define clock_unlock(clock)       g_mutex_unlock (&((clock)->mutex))
+/* Clock locking and unlocking.  The lock serializes writers only;
+   readers use the sequence lock, so that lp_clock_get_internal_time()
+   never blocks.  */
+#define clock_lock(clock)                                       \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    g_mutex_lock (&((clock)->mutex));                           \
+    gx_seqlock_write_begin (&((clock)->seq));                   \
+  }                                                             \
+  STMT_END
+
+#define clock_unlock(clock)                                     \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    gx_seqlock_write_end (&((clock)->seq));                     \
+    g_mutex_unlock (&((clock)->mutex));                         \
+  }                                                             \
+  STMT_END
+
 #define clock_get_systime(clock)  gst_clock_get_time ((clock)->sysclock)
 
+/* Returns the real-time clock time at system time @now.  */
+#define clock_realtime(now, unlock_time, unlock_systime)\
+  ((now) - (unlock_systime) + (unlock_time))
+
 
 /* methods */
 
@@ -57,13 +78,13 @@ static void
 lp_clock_init (lp_Clock *clock)
 {
   g_mutex_init (&clock->mutex);
+  gx_seqlock_init (&clock->seq);
   clock->lockstep = DEFAULT_LOCKSTEP;
   clock->sysclock = gst_system_clock_obtain ();
   g_assert_nonnull (clock->sysclock);
   clock->time = 0;
   clock->unlock_time = 0;
-  clock->unlock_systime = 0;
-  clock->init_systime = clock_get_systime (clock);
+  clock->unlock_systime = clock_get_systime (clock);
 }
 
 static void
@@ -77,9 +98,10 @@ lp_clock_get_property (GObject *object, guint prop_id,
   {
     case PROP_LOCKSTEP:
     {
-      clock_lock (clock);
-      g_value_set_boolean (value, g_atomic_int_get (&clock->lockstep));
-      clock_unlock (clock);
+      gboolean lockstep;
+
+      gx_seqlock_read (&clock->seq, lockstep, clock->lockstep);
+      g_value_set_boolean (value, lockstep);
       break;
     }
     default:
@@ -110,7 +132,13 @@ lp_clock_set_property (GObject *object, guint prop_id,
       if (!lockstep)
       {
         clock->unlock_time = clock->time;
-        clock->unlock_systime = gst_clock_get_time (clock->sysclock);
+        clock->unlock_systime = clock_get_systime (clock);
+      }
+      else                      /* freeze at the current real time */
+      {
+        clock->time = clock_realtime (clock_get_systime (clock),
+                                      clock->unlock_time,
+                                      clock->unlock_systime);
       }
 
     done:
@@ -133,25 +161,42 @@ lp_clock_finalize (GObject *object)
   G_OBJECT_CLASS (lp_clock_parent_class)->finalize (object);
 }
 
+/* Returns the internal time of @gst_clock.  Called by every sink and
+   streaming thread, so it doesn't take the clock lock: the clock fields
+   are read under the sequence lock and the real time is computed from a
+   consistent copy of them.  */
+
 static GstClockTime
 lp_clock_get_internal_time (GstClock *gst_clock)
 {
   lp_Clock *clock;
-  GstClockTime result;
+  gboolean lockstep;
+  GstClockTime time;
+  GstClockTime unlock_time;
+  GstClockTime unlock_systime;
+  GstClock *source;
+  gint seq;
 
   clock = LP_CLOCK (gst_clock);
-  clock_lock (clock);
 
-  if (!clock->lockstep)
-  {
-    GstClockTime now = clock_get_systime (clock);
-    clock->time = (now - clock->unlock_systime) + clock->unlock_time -
-      clock->init_systime;
-  }
-  result = clock->time;
+  do
+    {
+      seq = gx_seqlock_read_begin (&clock->seq);
+      lockstep = clock->lockstep;
+      time = clock->time;
+      unlock_time = clock->unlock_time;
+      unlock_systime = clock->unlock_systime;
+      source = clock->sysclock;
+    }
+  while (gx_seqlock_read_retry (&clock->seq, seq));
 
-  clock_unlock (clock);
-  return result;
+  if (lockstep)
+    return time;
+
+  /* The source is only swapped before @clock is in use, so it outlives
+     this call (cf. _lp_clock_set_source()).  */
+  return clock_realtime (gst_clock_get_time (source), unlock_time,
+                         unlock_systime);
 }
 
 static void
@@ -221,3 +266,29 @@ _lp_clock_reset_time (lp_Clock *clock, GstClockTime time)
   clock_unlock (clock);
   return status;
 }
+
+/* Makes @clock follow @source instead of the system clock: from now on,
+   the real time of @clock is the time of @source.  The source of a clock
+   that is already in use, i.e., referenced by a pipeline or shared with
+   another scene, is never swapped, as its readers do not hold a reference
+   to the old source.  Returns %TRUE if successful, or %FALSE if @clock is
+   in use.  */
+
+gboolean
+_lp_clock_set_source (lp_Clock *clock, GstClock *source)
+{
+  g_assert_nonnull (source);
+
+  if (unlikely (GST_OBJECT_REFCOUNT_VALUE (clock) > 1))
+    return FALSE;               /* in use */
+
+  clock_lock (clock);
+
+  gst_object_unref (clock->sysclock);
+  clock->sysclock = GST_CLOCK (gst_object_ref (source));
+  clock->unlock_time = 0;
+  clock->unlock_systime = 0;
+
+  clock_unlock (clock);
+  return TRUE;
+}
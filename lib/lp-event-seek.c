@@ -27,6 +27,8 @@ struct _lp_EventSeek
   {
     gboolean relative;          /* true if seek was relative */
     gint64 offset;              /* offset time */
+    lp_SeekMode mode;           /* seek mode */
+    guint64 latency;            /* seek latency */
   } prop;
 };
 
@@ -36,12 +38,16 @@ enum
   PROP_0,
   PROP_RELATIVE,
   PROP_OFFSET,
+  PROP_MODE,
+  PROP_LATENCY,
   PROP_LAST
 };
 
 /* Property defaults.  */
-#define DEFAULT_RELATIVE  FALSE /* absolute */
-#define DEFAULT_OFFSET    0     /* no offset */
+#define DEFAULT_RELATIVE  FALSE                  /* absolute */
+#define DEFAULT_OFFSET    0                      /* no offset */
+#define DEFAULT_MODE      LP_SEEK_MODE_ACCURATE  /* accurate */
+#define DEFAULT_LATENCY   0                      /* no latency */
 
 /* Define the lp_EventSeek type.  */
 GX_DEFINE_TYPE (lp_EventSeek, lp_event_seek, LP_TYPE_EVENT)
@@ -54,6 +60,8 @@ lp_event_seek_init (lp_EventSeek *event)
 {
   event->prop.relative = DEFAULT_RELATIVE;
   event->prop.offset = DEFAULT_OFFSET;
+  event->prop.mode = DEFAULT_MODE;
+  event->prop.latency = DEFAULT_LATENCY;
 }
 
 static void
@@ -71,6 +79,12 @@ lp_event_seek_get_property (GObject *object, guint prop_id,
     case PROP_OFFSET:
       g_value_set_int64 (value, event->prop.offset);
       break;
+    case PROP_MODE:
+      g_value_set_int (value, event->prop.mode);
+      break;
+    case PROP_LATENCY:
+      g_value_set_uint64 (value, event->prop.latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -91,6 +105,12 @@ lp_event_seek_set_property (GObject *object, guint prop_id,
     case PROP_OFFSET:
       event->prop.offset = g_value_get_int64 (value);
       break;
+    case PROP_MODE:
+      event->prop.mode = (lp_SeekMode) g_value_get_int (value);
+      break;
+    case PROP_LATENCY:
+      event->prop.latency = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -126,8 +146,12 @@ lp_event_seek_to_string (lp_Event *event)
   return _lp_event_to_string (event, "\
   relative: %s\n\
   offset: %" G_GINT64_FORMAT "\n\
+  mode: %d\n\
+  latency: %" G_GUINT64_FORMAT "\n\
 ",                            strbool (seek->prop.relative),
-                              seek->prop.offset);
+                              seek->prop.offset,
+                              seek->prop.mode,
+                              seek->prop.latency);
 }
 
 static void
@@ -156,6 +180,19 @@ lp_event_seek_class_init (lp_EventSeekClass *cls)
      ("offset", "offset", "offset time (in nanoseconds)",
       G_MININT64, G_MAXINT64, DEFAULT_OFFSET,
       (GParamFlags)(G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_MODE, g_param_spec_int
+     ("mode", "mode", "seek mode",
+      0, LP_SEEK_MODE_LAST - 1, DEFAULT_MODE,
+      (GParamFlags)(G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_LATENCY, g_param_spec_uint64
+     ("latency", "latency",
+      "time from seek request to first data (in nanoseconds)",
+      0, G_MAXUINT64, DEFAULT_LATENCY,
+      (GParamFlags)(G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE)));
 }
 
 
@@ -164,11 +201,14 @@ lp_event_seek_class_init (lp_EventSeekClass *cls)
 /* Creates a new seek event.  */
 
 lp_EventSeek *
-_lp_event_seek_new (lp_Media *source, gboolean relative, gint64 offset)
+_lp_event_seek_new (lp_Media *source, gboolean relative, gint64 offset,
+                    lp_SeekMode mode, guint64 latency)
 {
   return LP_EVENT_SEEK (g_object_new (LP_TYPE_EVENT_SEEK,
                                       "source", source,
                                       "mask", LP_EVENT_MASK_SEEK,
                                       "relative", relative,
-                                      "offset", offset, NULL));
+                                      "offset", offset,
+                                      "mode", mode,
+                                      "latency", latency, NULL));
 }
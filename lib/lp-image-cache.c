@@ -0,0 +1,206 @@
+/* lp-image-cache.c -- Decoded image cache.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "play-internal.h"
+
+/* Image cache entry.  */
+typedef struct _lp_ImageCacheEntry
+{
+  gchar *key;                   /* URI */
+  GstBuffer *buffer;            /* decoded and converted frame */
+  GstCaps *caps;                /* frame caps */
+  gsize size;                   /* frame size in bytes */
+} lp_ImageCacheEntry;
+
+/* Image cache.  */
+struct _lp_ImageCache
+{
+  GMutex mutex;                 /* sync access to cache */
+  GHashTable *index;            /* maps keys to links in lru */
+  GQueue lru;                   /* entries, most recently used first */
+  guint64 budget;               /* maximum size in bytes */
+  guint64 size;                 /* current size in bytes */
+};
+
+#define cache_lock(c)    g_mutex_lock (&(c)->mutex)
+#define cache_unlock(c)  g_mutex_unlock (&(c)->mutex)
+
+static void
+cache_entry_free (lp_ImageCacheEntry *entry)
+{
+  g_free (entry->key);
+  gst_buffer_unref (entry->buffer);
+  gst_caps_unref (entry->caps);
+  g_free (entry);
+}
+
+/* Evicts least recently used entries from @cache until its size fits
+   into its budget.  */
+
+static void
+cache_evict_unlocked (lp_ImageCache *cache)
+{
+  while (cache->size > cache->budget && cache->lru.tail != NULL)
+    {
+      lp_ImageCacheEntry *entry;
+
+      entry = (lp_ImageCacheEntry *) g_queue_pop_tail (&cache->lru);
+      g_assert_nonnull (entry);
+      g_assert (g_hash_table_remove (cache->index, entry->key));
+      g_assert (cache->size >= entry->size);
+      cache->size -= entry->size;
+      cache_entry_free (entry);
+    }
+}
+
+
+/* internal */
+
+/* Creates a new image cache that holds at most @budget bytes.  */
+
+lp_ImageCache *
+_lp_image_cache_new (guint64 budget)
+{
+  lp_ImageCache *cache;
+
+  cache = g_new0 (lp_ImageCache, 1);
+  g_mutex_init (&cache->mutex);
+  cache->index = g_hash_table_new (g_str_hash, g_str_equal);
+  g_assert_nonnull (cache->index);
+  g_queue_init (&cache->lru);
+  cache->budget = budget;
+  cache->size = 0;
+
+  return cache;
+}
+
+/* Releases @cache and all its entries.  */
+
+void
+_lp_image_cache_free (lp_ImageCache *cache)
+{
+  g_hash_table_destroy (cache->index);
+  g_queue_foreach (&cache->lru, (GFunc) cache_entry_free, NULL);
+  g_queue_clear (&cache->lru);
+  g_mutex_clear (&cache->mutex);
+  g_free (cache);
+}
+
+/* Sets the memory budget of @cache to @budget bytes, evicting entries if
+   necessary.  A budget of zero disables the cache.  */
+
+void
+_lp_image_cache_set_budget (lp_ImageCache *cache, guint64 budget)
+{
+  cache_lock (cache);
+  cache->budget = budget;
+  cache_evict_unlocked (cache);
+  cache_unlock (cache);
+}
+
+/* Returns the number of bytes currently held by @cache.  */
+
+guint64
+_lp_image_cache_get_size (lp_ImageCache *cache)
+{
+  guint64 size;
+
+  cache_lock (cache);
+  size = cache->size;
+  cache_unlock (cache);
+
+  return size;
+}
+
+/* Looks up the frame of @uri in @cache.  Returns %TRUE if successful and
+   stores new references to the frame buffer and caps into @buffer and
+   @caps, or returns %FALSE otherwise.  */
+
+gboolean
+_lp_image_cache_lookup (lp_ImageCache *cache, const gchar *uri,
+                        GstBuffer **buffer, GstCaps **caps)
+{
+  lp_ImageCacheEntry *entry;
+  GList *link;
+
+  g_assert_nonnull (uri);
+
+  cache_lock (cache);
+
+  link = (GList *) g_hash_table_lookup (cache->index, uri);
+
+  if (link == NULL)
+    {
+      cache_unlock (cache);
+      return FALSE;             /* miss */
+    }
+
+  g_queue_unlink (&cache->lru, link); /* touch */
+  g_queue_push_head_link (&cache->lru, link);
+
+  entry = (lp_ImageCacheEntry *) link->data;
+  set_if_nonnull (buffer, gst_buffer_ref (entry->buffer));
+  set_if_nonnull (caps, gst_caps_ref (entry->caps));
+
+  cache_unlock (cache);
+  return TRUE;
+}
+
+/* Inserts the frame @buffer with @caps of @uri into @cache.  The frame is
+   the full-size converted image; it is scaled by the compositor, so a
+   single entry serves every size @uri is shown at.  The cache keeps
+   references to @buffer and @caps, the frame data is not copied.  Does
+   nothing if the frame is already cached or if it does not fit into the
+   cache budget.  */
+
+void
+_lp_image_cache_insert (lp_ImageCache *cache, const gchar *uri,
+                        GstBuffer *buffer, GstCaps *caps)
+{
+  lp_ImageCacheEntry *entry;
+  gsize size;
+
+  g_assert_nonnull (uri);
+  g_assert_nonnull (buffer);
+  g_assert_nonnull (caps);
+
+  size = gst_buffer_get_size (buffer);
+
+  cache_lock (cache);
+
+  if (size > cache->budget
+      || g_hash_table_contains (cache->index, uri))
+    {
+      cache_unlock (cache);
+      return;                   /* nothing to do */
+    }
+
+  entry = g_new0 (lp_ImageCacheEntry, 1);
+  entry->key = g_strdup (uri);
+  entry->buffer = gst_buffer_ref (buffer);
+  entry->caps = gst_caps_ref (caps);
+  entry->size = size;
+
+  g_queue_push_head (&cache->lru, entry);
+  g_hash_table_insert (cache->index, entry->key, cache->lru.head);
+  cache->size += size;
+  cache_evict_unlocked (cache);
+
+  cache_unlock (cache);
+}
@@ -31,6 +31,7 @@ typedef enum
   SEEKING,                      /* media is seeking */
   PAUSING,                      /* media is pausing */
   PAUSED,                       /* media is paused */
+  RESUMING,                     /* media is resuming */
   DISPOSED                      /* media has been disposed */
 } lp_MediaState;
 
@@ -41,6 +42,8 @@ typedef enum
   FLAG_DRAINED  = (1 << 0),          /* media has drained */
   FLAG_FROZEN   = (1 << 1),          /* media is a still image */
   FLAG_TEXT     = (1 << 2),          /* media is a text */
+  FLAG_STANDBY  = (1 << 3),          /* media is prerolled in standby */
+  FLAG_PREROLL  = (1 << 4),          /* media awaits its preroll seek */
   FLAG_ALL      = (gint)(0xffffffff) /* all flags set */
 } lp_MediaFlag;
 
@@ -64,49 +67,97 @@ struct _lp_Media
   GstElement *decoder;          /* content decoder */
   GstClockTime offset;          /* start time offset */
   lp_MediaState state;          /* current state */
+  gboolean counted;             /* true if state is counted by scene */
   lp_MediaFlag flags;           /* media flags */
   guint linked_pads;            /* number of linked pads */
   struct
+  {                             /* published (lock-free reads): */
+    gx_seqlock_t seq;           /* sync access to published fields */
+    lp_MediaState state;        /* current state */
+    gint x;                     /* cached x */
+    gint y;                     /* cached y */
+    gint z;                     /* cached z */
+    gint width;                 /* cached width */
+    gint height;                /* cached height */
+    gdouble alpha;              /* cached alpha */
+  } pub;
+  struct
   {                             /* callback handlers: */
     gulong pad_added;           /* pad-added callback id */
     gulong no_more_pads;        /* no-more-pads callback id */
     gulong autoplug_continue;   /* autoplug-continue callback id */
     gulong drained;             /* drained callback id */
+    gulong element_added;       /* element-added callback id */
   } callback;
   struct
   {                             /* seek offset: */
     gboolean relative;          /* true if last seek was relative */
-    gint64 sum;                 /* accumulated offset */
     gint64 last;                /* last offset */
+    GstClockTime base;          /* running time of last segment start */
+    gint64 position;            /* stream position at base */
+    gdouble rate;               /* rate of last segment */
+    gboolean segment;           /* true if last seek was a segment seek */
+    gint64 target;              /* requested stream position */
+    lp_SeekMode mode;           /* mode of ongoing seek */
+    gboolean refine;            /* true if an accurate seek should follow */
+    GstClockTime start;         /* time of seek request */
+    GstClockTime latency;       /* time from request to first data */
+    guint waiting;              /* number of pads waiting for data */
+    gboolean internal;          /* true if seek was not requested by app */
   } seek;
   struct
-  {
-    GstElement *appsrc;         /* pushes paused video buffer */
-    GstElement *convert;        /* video convert to adapt caps */
-    GstBuffer *video_buffer;    /* paused video buffer */
-    GstCaps *caps;              /* current video caps */
+  {                             /* pause: */
+    GstBuffer *buffer;          /* paused video frame */
     GstClockTime time;          /* pause time */
-    GstClockTime duration;      /* pause buffer duration */
-    guint paused_pads;          /* number of paused pads */
-    GSList *block_probe_ids;    /* list of block probe ids */
+    GstClockTime pts;           /* timestamp of next repeated frame */
+    GstClockTime duration;      /* duration of repeated frames */
+    gulong probe_audio;         /* audio block probe id */
+    gulong probe_video;         /* video block probe id */
   } pause;
   struct
   {                             /* audio output: */
-    GstElement *convert;        /* audio convert */
-    GstElement *resample;       /* audio resample */
+    GstElement *queue;          /* decode queue (optional) */
+    GstElement *convert;        /* audio convert (only if converting) */
+    GstElement *resample;       /* audio resample (only if converting) */
+    GstElement *tempo;          /* audio tempo (only if rate != 1.0) */
+    GstPad *decoded;            /* decoder audio output */
     GstPad *pad;                /* audio pad in bin */
     lp_MediaPadFlag flags;      /* audio pad flags */
   } audio;
   struct
   {                             /* video output: */
     GstElement *freeze;         /* image freeze (optional) */
+    GstElement *queue;          /* decode queue (optional) */
     GstElement *convert;        /* video convert */
-    GstElement *crop;           /* video crop */
-    GstElement *text;           /* text overlay */
+    GstElement *crop;           /* video crop (only if cropped) */
+    GstElement *text;           /* text overlay (only if text is set) */
     GstPad *pad;                /* video pad in bin */
     lp_MediaPadFlag flags;      /* video pad flags */
   } video;
   struct
+  {                             /* image cache: */
+    GstBuffer *frame;           /* cached frame (until pushed) */
+  } cache;
+  gint buffering;               /* buffering level (in percent) */
+  guint threads;                /* thread share (0=automatic) */
+  struct
+  {                             /* quality of service: */
+    gsize processed;            /* video frames pushed to mixer */
+    gsize dropped;              /* video frames dropped upstream */
+    gsize late;                 /* video frames reported late */
+    guint64 lateness;           /* total lateness (in nanoseconds) */
+  } qos;
+  struct
+  {                             /* standby: */
+    gulong probe_audio;         /* audio block probe id */
+    gulong probe_video;         /* video block probe id */
+  } standby;
+  struct
+  {                             /* preroll seek: */
+    gulong probe_audio;         /* audio block probe id */
+    gulong probe_video;         /* video block probe id */
+  } preroll;
+  struct
   {                             /* properties: */
     lp_Scene *scene;            /* parent scene */
     gchar *uri;                 /* content URI */
@@ -127,14 +178,19 @@ struct _lp_Media
     gdouble crop_right;         /* cached crop_right */
     gdouble crop_bottom;        /* cached crop_bottom */
     gboolean sync;              /* synchronous mode */
+    gdouble rate;               /* cached rate */
+    lp_SeekMode seek_mode;      /* seek mode */
+    gboolean loop;              /* loop mode */
+    lp_Media *next;             /* next media */
+    guint demux_max_bytes;      /* demux queue limit in bytes */
+    guint demux_max_buffers;    /* demux queue limit in buffers */
+    guint64 demux_max_time;     /* demux queue limit in nanoseconds */
+    guint decode_max_bytes;     /* decode queue limit in bytes */
+    guint decode_max_buffers;   /* decode queue limit in buffers */
+    guint64 decode_max_time;    /* decode queue limit in nanoseconds */
   } prop;
 };
 
-typedef struct _blocked_pad {
-  GstPad *pad;
-  gulong probe_id;
-} blocked_pad_info;
-
 /* Maps GStreamer elements to offsets in lp_Media.  */
 static const gstx_eltmap_t lp_media_eltmap[] = {
   {"bin",           offsetof (lp_Media, bin)},
@@ -148,13 +204,36 @@ static const gstx_eltmap_t media_eltmap_audio[] = {
   {NULL, 0}
 };
 
+static const gstx_eltmap_t media_eltmap_audio_tempo[] = {
+  {"scaletempo",    offsetof (lp_Media, audio.tempo)},
+  {NULL, 0}
+};
+
 static const gstx_eltmap_t media_eltmap_video[] = {
   {"videoconvert",  offsetof (lp_Media, video.convert)},
+  {NULL, 0}
+};
+
+static const gstx_eltmap_t media_eltmap_video_crop[] = {
   {"videocrop",     offsetof (lp_Media, video.crop)},
+  {NULL, 0}
+};
+
+static const gstx_eltmap_t media_eltmap_video_text[] = {
   {"textoverlay",   offsetof (lp_Media, video.text)},
   {NULL, 0}
 };
 
+static const gstx_eltmap_t media_eltmap_audio_queue[] = {
+  {"queue",         offsetof (lp_Media, audio.queue)},
+  {NULL, 0}
+};
+
+static const gstx_eltmap_t media_eltmap_video_queue[] = {
+  {"queue",         offsetof (lp_Media, video.queue)},
+  {NULL, 0}
+};
+
 static const gstx_eltmap_t media_eltmap_video_freeze[] = {
   {"imagefreeze",   offsetof (lp_Media, video.freeze)},
   {NULL, 0}
@@ -183,6 +262,24 @@ enum
   PROP_CROP_RIGHT,
   PROP_CROP_BOTTOM,
   PROP_SYNCHRONOUS,
+  PROP_RATE,
+  PROP_SEEK_MODE,
+  PROP_LOOP,
+  PROP_NEXT,
+  PROP_DEMUX_MAX_BYTES,
+  PROP_DEMUX_MAX_BUFFERS,
+  PROP_DEMUX_MAX_TIME,
+  PROP_DECODE_MAX_BYTES,
+  PROP_DECODE_MAX_BUFFERS,
+  PROP_DECODE_MAX_TIME,
+  PROP_BUFFERING,
+  PROP_DECODE_LEVEL_BYTES,
+  PROP_DECODE_LEVEL_BUFFERS,
+  PROP_DECODE_LEVEL_TIME,
+  PROP_FRAMES_PROCESSED,
+  PROP_FRAMES_DROPPED,
+  PROP_FRAMES_LATE,
+  PROP_AVERAGE_LATENESS,
   PROP_LAST
 };
 
@@ -205,15 +302,49 @@ enum
 #define DEFAULT_CROP_RIGHT    0.0        /* no crop */
 #define DEFAULT_CROP_BOTTOM   0.0        /* no crop */
 #define DEFAULT_SYNCHRONOUS  FALSE       /* synchronous mode */
+#define DEFAULT_RATE          1.0        /* natural rate */
+#define DEFAULT_SEEK_MODE     LP_SEEK_MODE_ACCURATE /* accurate seek */
+#define DEFAULT_LOOP          FALSE      /* play once */
+#define DEFAULT_NEXT          NULL       /* no next media */
+#define DEFAULT_QUEUE_LIMIT   0          /* automatic */
 
 /* Define the lp_Media type.  */
 GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
 
 
-/* Media locking and unlocking.  */
-#define media_lock(m)    g_rec_mutex_lock (&((m)->mutex))
+/* Media locking and unlocking.  Contended locks are counted in the
+   statistics of the parent scene.  */
+#define media_lock(m)                                           \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    if (!g_rec_mutex_trylock (&((m)->mutex)))                   \
+      {                                                         \
+        if ((m)->prop.scene != NULL)                            \
+          _lp_scene_count_contention ((m)->prop.scene);         \
+        g_rec_mutex_lock (&((m)->mutex));                       \
+      }                                                         \
+  }                                                             \
+  STMT_END
+
 #define media_unlock(m)  g_rec_mutex_unlock (&((m)->mutex))
 
+/* Publishes the geometry and state of media @m, so that they can be read
+   without taking the media lock.  Must be called with the lock held.  */
+#define media_publish(m)                                        \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    gx_seqlock_write_begin (&(m)->pub.seq);                     \
+    (m)->pub.state = (m)->state;                                \
+    (m)->pub.x = (m)->prop.x;                                   \
+    (m)->pub.y = (m)->prop.y;                                   \
+    (m)->pub.z = (m)->prop.z;                                   \
+    (m)->pub.width = (m)->prop.width;                           \
+    (m)->pub.height = (m)->prop.height;                         \
+    (m)->pub.alpha = (m)->prop.alpha;                           \
+    gx_seqlock_write_end (&(m)->pub.seq);                       \
+  }                                                             \
+  STMT_END
+
 /* Media state queries.  */
 #define media_state_started(m)    ((m)->state == STARTED)
 #define media_state_starting(m)   ((m)->state == STARTING)
@@ -222,8 +353,116 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
 #define media_state_seeking(m)    ((m)->state == SEEKING)
 #define media_state_pausing(m)    ((m)->state == PAUSING)
 #define media_state_paused(m)     ((m)->state == PAUSED)
+#define media_state_resuming(m)   ((m)->state == RESUMING)
 #define media_state_disposed(m)   ((m)->state == DISPOSED)
 
+/* Maps media state @st to the group counted in scene statistics.  */
+
+static lp_MediaGroup
+media_state_to_group (lp_MediaState st)
+{
+  switch (st)
+    {
+    case STARTED:               /* fall through */
+    case SEEKING:
+      return LP_MEDIA_GROUP_STARTED;
+    case STOPPED:
+      return LP_MEDIA_GROUP_STOPPED;
+    case PAUSED:
+      return LP_MEDIA_GROUP_PAUSED;
+    case STARTING:              /* fall through */
+    case STOPPING:              /* fall through */
+    case PAUSING:               /* fall through */
+    case RESUMING:
+      return LP_MEDIA_GROUP_BUSY;
+    case DISPOSED:              /* fall through */
+    default:
+      return LP_MEDIA_GROUP_NONE;
+    }
+}
+
+/* Media state names, indexed by lp_MediaState.  */
+static const gchar *media_state_names[] = {
+  "started",
+  "starting",
+  "stopped",
+  "stopping",
+  "seeking",
+  "pausing",
+  "paused",
+  "resuming",
+  "disposed",
+};
+
+/* Returns the trace recorder of media @m's scene, or NULL.  */
+#define media_get_trace(m)                                      \
+  (((m)->prop.scene != NULL)                                    \
+   ? _lp_scene_get_trace ((m)->prop.scene) : NULL)
+
+/* Records instant @name with @detail into the trace of media @m.  */
+#define media_trace_instant(m, name, detail)                    \
+  _lp_trace_instant (media_get_trace ((m)), "media", (name), (m), (detail))
+
+/* Records the transition of @media from state @from to state @to into
+   the scene trace.  Transient states and the paused state are recorded as
+   spans; the begin event carries the media URI.  */
+
+static void
+media_trace_state (lp_Media *media, lp_MediaState from, lp_MediaState to)
+{
+  lp_Trace *trace;
+
+  trace = media_get_trace (media);
+  if (likely (trace == NULL) || from == to)
+    return;                     /* nothing to do */
+
+  switch (from)
+    {
+    case STARTING:              /* fall through */
+    case STOPPING:              /* fall through */
+    case SEEKING:               /* fall through */
+    case PAUSING:               /* fall through */
+    case PAUSED:                /* fall through */
+    case RESUMING:
+      _lp_trace_end (trace, "media", media_state_names[from], media);
+      break;
+    default:
+      break;
+    }
+
+  switch (to)
+    {
+    case STARTING:              /* fall through */
+    case STOPPING:              /* fall through */
+    case SEEKING:               /* fall through */
+    case PAUSING:               /* fall through */
+    case PAUSED:                /* fall through */
+    case RESUMING:
+      _lp_trace_begin (trace, "media", media_state_names[to], media,
+                       media->prop.uri);
+      break;
+    default:
+      _lp_trace_instant (trace, "media", media_state_names[to], media,
+                         NULL);
+      break;
+    }
+}
+
+/* Sets the state of media @m to @st, updates scene statistics, and
+   records the transition into the scene trace.  */
+#define media_set_state(m, st)                                  \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    media_trace_state ((m), (m)->state, (st));                  \
+    if ((m)->counted)                                           \
+      _lp_scene_count_media ((m)->prop.scene,                   \
+                             media_state_to_group ((m)->state), \
+                             media_state_to_group ((st)));      \
+    (m)->state = (st);                                          \
+    media_publish ((m));                                        \
+  }                                                             \
+  STMT_END
+
 /* Media flag access.  */
 #define media_flags_init(m, f)    ((m)->flags = (lp_MediaFlag)(f))
 #define media_flag_set(m, f)      (media_flags_init ((m), (m)->flags | (f)))
@@ -235,6 +474,51 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
 #define media_toggle_frozen(m)    (media_flag_toggle (m, FLAG_FROZEN))
 #define media_is_text(m)          ((m)->flags & FLAG_TEXT)
 #define media_toggle_text(m)      (media_flag_toggle (m, FLAG_TEXT))
+#define media_is_standby(m)       ((m)->flags & FLAG_STANDBY)
+#define media_toggle_standby(m)   (media_flag_toggle (m, FLAG_STANDBY))
+#define media_is_prerolling(m)    ((m)->flags & FLAG_PREROLL)
+#define media_toggle_prerolling(m) (media_flag_toggle (m, FLAG_PREROLL))
+
+/* True if the first segment of @m needs a rate or the segment flag, which
+   are set by a seek while its pads are still blocked.  */
+#define media_needs_preroll_seek(m)             \
+  ((m)->decoder != NULL                         \
+   && !media_is_frozen ((m))                    \
+   && ((m)->prop.rate != 1.0 || (m)->prop.loop))
+
+/* True if @m has demux or decode queue limits set.  */
+#define media_has_demux_limits(m)               \
+  ((m)->prop.demux_max_bytes > 0                \
+   || (m)->prop.demux_max_buffers > 0           \
+   || (m)->prop.demux_max_time > 0)
+
+#define media_has_decode_limits(m)              \
+  ((m)->prop.decode_max_bytes > 0               \
+   || (m)->prop.decode_max_buffers > 0          \
+   || (m)->prop.decode_max_time > 0)
+
+/* Media QoS counters.  Event counters are pointer-sized atomics, as in
+   the scene statistics, so that the streaming threads never take a lock
+   to update them.  */
+#define media_qos_add(m, field, n)                              \
+  g_atomic_pointer_add (&(m)->qos.field, (gssize)(n))
+
+#define media_qos_set(m, field, n)                              \
+  g_atomic_pointer_set (&(m)->qos.field, (gsize)(n))
+
+#define media_qos_get(m, field)                                 \
+  ((guint64)(gsize) g_atomic_pointer_get (&(m)->qos.field))
+
+/* The total lateness counts nanoseconds, which overflow a 32-bit gsize
+   after a few seconds of lateness, so it is a 64-bit atomic.  */
+#define media_qos_add_lateness(m, n)                            \
+  gx_atomic_uint64_add (&(m)->qos.lateness, (n))
+
+#define media_qos_set_lateness(m, n)                            \
+  gx_atomic_uint64_set (&(m)->qos.lateness, (n))
+
+#define media_qos_get_lateness(m)                               \
+  gx_atomic_uint64_get (&(m)->qos.lateness)
 
 /* Media pad queries and pad-flag access.  */
 #define MEDIA_PAD_FLAGS_INIT(p, f)   ((p) = (lp_MediaPadFlag)(f))
@@ -255,6 +539,14 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
   (!((media_has_audio ((m)) && ((m)->audio.flags & (f)))        \
      || (media_has_video ((m)) && ((m)->video.flags & (f)))))
 
+/* Tests whether @buf shares the memory of the paused frame of @m, i.e.,
+   whether it has been pushed by lp_media_pause_task_func().  */
+#define media_is_pause_frame(m, buf)                                    \
+  ((m)->pause.buffer != NULL                                            \
+   && gst_buffer_n_memory ((buf)) > 0                                   \
+   && (gst_buffer_peek_memory ((buf), 0)                                \
+       == gst_buffer_peek_memory ((m)->pause.buffer, 0)))
+
 #define media_toggle_flag_on_all_pads(m, f)             \
   STMT_BEGIN                                            \
   {                                                     \
@@ -281,17 +573,49 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
     (m)->callback.no_more_pads = 0;             \
     (m)->callback.autoplug_continue = 0;        \
     (m)->callback.drained = 0;                  \
+    (m)->callback.element_added = 0;            \
     (m)->seek.relative = FALSE;                 \
-    (m)->seek.sum = 0;                          \
     (m)->seek.last = 0;                         \
+    (m)->seek.base = GST_CLOCK_TIME_NONE;       \
+    (m)->seek.position = 0;                     \
+    (m)->seek.rate = 1.0;                       \
+    (m)->seek.segment = FALSE;                  \
+    (m)->seek.target = 0;                       \
+    (m)->seek.mode = LP_SEEK_MODE_ACCURATE;     \
+    (m)->seek.refine = FALSE;                   \
+    (m)->seek.start = GST_CLOCK_TIME_NONE;      \
+    (m)->seek.latency = GST_CLOCK_TIME_NONE;    \
+    (m)->seek.waiting = 0;                      \
+    (m)->seek.internal = FALSE;                 \
+    (m)->audio.queue = NULL;                    \
+    (m)->audio.convert = NULL;                  \
+    (m)->audio.resample = NULL;                 \
+    (m)->audio.tempo = NULL;                    \
+    (m)->audio.decoded = NULL;                  \
     (m)->audio.pad = NULL;                      \
     (m)->audio.flags = PAD_FLAG_NONE;           \
+    (m)->video.queue = NULL;                    \
+    (m)->video.crop = NULL;                     \
+    (m)->video.text = NULL;                     \
     (m)->video.pad = NULL;                      \
     (m)->video.flags = PAD_FLAG_NONE;           \
-    (m)->pause.paused_pads = 0;                 \
+    (m)->pause.buffer = NULL;                   \
     (m)->pause.time = 0;                        \
-    (m)->pause.caps = NULL;                     \
-    (m)->pause.block_probe_ids = NULL;          \
+    (m)->pause.pts = GST_CLOCK_TIME_NONE;       \
+    (m)->pause.duration = GST_CLOCK_TIME_NONE;  \
+    (m)->pause.probe_audio = 0;                 \
+    (m)->pause.probe_video = 0;                 \
+    (m)->cache.frame = NULL;                    \
+    (m)->buffering = 100;                       \
+    (m)->threads = 0;                           \
+    media_qos_set ((m), processed, 0);          \
+    media_qos_set ((m), dropped, 0);            \
+    media_qos_set ((m), late, 0);               \
+    media_qos_set_lateness ((m), 0);            \
+    (m)->standby.probe_audio = 0;               \
+    (m)->standby.probe_video = 0;               \
+    (m)->preroll.probe_audio = 0;               \
+    (m)->preroll.probe_video = 0;               \
   }                                             \
   STMT_END
 
@@ -308,6 +632,12 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
       {                                                         \
         gst_object_unref ((m)->video.pad);                      \
       }                                                         \
+    if ((m)->audio.decoded != NULL)                             \
+      gst_object_unref ((m)->audio.decoded);                    \
+    if ((m)->cache.frame != NULL)                               \
+      gst_buffer_unref ((m)->cache.frame);                      \
+    if ((m)->pause.buffer != NULL)                              \
+      gst_buffer_unref ((m)->pause.buffer);                     \
     gst_object_unref ((m)->bin);                                \
     g_free ((m)->prop.final_uri);                               \
     media_reset_run_time_data ((m));                            \
@@ -337,6 +667,16 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
     (m)->prop.crop_right = DEFAULT_CROP_RIGHT;                  \
     (m)->prop.crop_bottom = DEFAULT_CROP_BOTTOM;                \
     (m)->prop.sync = DEFAULT_SYNCHRONOUS;                       \
+    (m)->prop.rate = DEFAULT_RATE;                              \
+    (m)->prop.seek_mode = DEFAULT_SEEK_MODE;                    \
+    (m)->prop.loop = DEFAULT_LOOP;                              \
+    (m)->prop.next = DEFAULT_NEXT;                              \
+    (m)->prop.demux_max_bytes = DEFAULT_QUEUE_LIMIT;            \
+    (m)->prop.demux_max_buffers = DEFAULT_QUEUE_LIMIT;          \
+    (m)->prop.demux_max_time = DEFAULT_QUEUE_LIMIT;             \
+    (m)->prop.decode_max_bytes = DEFAULT_QUEUE_LIMIT;           \
+    (m)->prop.decode_max_buffers = DEFAULT_QUEUE_LIMIT;         \
+    (m)->prop.decode_max_time = DEFAULT_QUEUE_LIMIT;            \
   }                                                             \
   STMT_END
 
@@ -349,6 +689,10 @@ GX_DEFINE_TYPE (lp_Media, lp_media, G_TYPE_OBJECT)
   }                                                             \
   STMT_END
 
+/* Forward declarations.  */
+
+static gboolean media_start_unlocked (lp_Media *, gboolean);
+
 
 static gboolean
 lp_media_has_started (lp_Media *media)
@@ -402,595 +746,2252 @@ media_install_probe (lp_Media *media, GstPadProbeType type,
   return n;
 }
 
-
-/* callbacks */
-
-/* WARNING: In the callbacks, media must be *LOCKED*.  */
-
-/* Signals that a media pad has been blocked, which in this case happens
-   immediately after the corresponding pad is added to the media decoder.
-   Here we keep the pad blocked until it is explicit unblocked by
-   lp_media_no_more_pads_callback().  */
+/* Links the audio pad of @media to a new request pad of the scene audio
+   mixer.  */
 
-static GstPadProbeReturn
-lp_media_pad_added_block_probe_callback (GstPad *pad, GstPadProbeInfo *info,
-                                         lp_Media *media)
+static void
+media_link_audio_mixer (lp_Media *media)
 {
-  lp_MediaPadFlag *flags;
+  GstElement *mixer;
+  GstPad *sink;
 
-  media_lock (media);
+  mixer = _lp_scene_get_audio_mixer (media->prop.scene);
+  g_assert_nonnull (mixer);
 
-  if (unlikely (!media_state_starting (media)))
-    goto unblock;               /* drop residual probes */
+  sink = gst_element_get_request_pad (mixer, "sink_%u");
+  g_assert_nonnull (sink);
 
-  flags = media_get_pad_flags (media, pad);
-  g_assert_nonnull (flags);
-  g_assert (media_pad_flag_active (*flags));
+  g_assert (gst_pad_link (media->audio.pad, sink) == GST_PAD_LINK_OK);
+  g_object_set (sink,
+      "mute", media->prop.mute,
+      "volume", media->prop.volume, NULL);
+  gst_object_unref (sink);
+}
 
-  if (media_pad_flag_blocked (*flags))
-  {
-    media_unlock (media);
-    return GST_PAD_PROBE_OK;  /* block */
-  }
+/* Links the video pad of @media to a new request pad of the scene video
+   mixer, and applies the geometry of @media to it.  */
 
-  if (media_pad_flag_flushed (*flags))
-    goto unblock;               /* drop residual probes */
+static void
+media_link_video_mixer (lp_Media *media)
+{
+  GstElement *mixer;
+  GstPad *sink;
 
-  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
-  g_assert (media_state_starting (media));
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-  gst_pad_set_offset (pad, (gint64) media->offset);
+  mixer = _lp_scene_get_video_mixer (media->prop.scene);
+  g_assert_nonnull (mixer);
 
-  if (media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED))
-  {
-    lp_EventStart *event = _lp_event_start_new (G_OBJECT(media), FALSE);
-    g_assert_nonnull (event);
-    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
-  }
+  sink = gst_element_get_request_pad (mixer, "sink_%u");
+  g_assert_nonnull (sink);
 
- unblock:
-  media_unlock (media);
-  return GST_PAD_PROBE_REMOVE;
+  g_assert (gst_pad_link (media->video.pad, sink) == GST_PAD_LINK_OK);
+  g_object_set
+    (sink,
+     "xpos", media->prop.x,
+     "ypos", media->prop.y,
+     "zorder", media->prop.z,
+     "alpha", media->prop.alpha, NULL);
+  if (media->prop.width > 0)
+    g_object_set (sink, "width", media->prop.width, NULL);
+  if (media->prop.height > 0)
+    g_object_set (sink, "height", media->prop.height, NULL);
+  gst_object_unref (sink);
 }
 
-static GstPadProbeReturn
-lp_media_pause_block_probe_callback (GstPad *pad,
-                                       arg_unused(GstPadProbeInfo *info),
-                                       lp_Media *media)
+/* Unlinks the audio pad of @media from the scene audio mixer and releases
+   the corresponding request pad.  */
+
+static void
+media_unlink_audio_mixer (lp_Media *media)
 {
-  GstElement *peer_parent = NULL;
-  GstPad *peer = NULL;
-  GstCaps *caps = NULL;
-  const char *name = NULL;
-  lp_MediaPadFlag *flags = NULL;
+  GstElement *mixer;
+  GstPad *sink;
 
-  media_lock (media);
+  sink = gst_pad_get_peer (media->audio.pad);
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_unlink (media->audio.pad, sink));
 
-  caps = gst_pad_query_caps (pad, NULL);
-  g_assert_nonnull (caps);
+  mixer = _lp_scene_get_audio_mixer (media->prop.scene);
+  g_assert_nonnull (mixer);
+  gst_element_release_request_pad (mixer, sink);
+  gst_object_unref (sink);
+}
 
-  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
-  g_assert_nonnull (name);
+/* Returns the duration of the frames repeated while @media is paused,
+   where @buffer is the paused frame.  */
 
-  if (g_str_equal (name, "audio/x-raw"))
-    pad = media->audio.pad;
-  else if (g_str_equal (name, "video/x-raw"))
-    pad = media->video.pad;
-  else
-    goto done;
+static GstClockTime
+media_get_pause_frame_duration (lp_Media *media, GstBuffer *buffer)
+{
+  GstCaps *caps;
+  gint num = 0;
+  gint den = 0;
 
-  flags = media_get_pad_flags (media, pad);
+  caps = gst_pad_get_current_caps (media->video.pad);
+  if (caps != NULL)
+    {
+      gst_structure_get_fraction (gst_caps_get_structure (caps, 0),
+                                  "framerate", &num, &den);
+      gst_caps_unref (caps);
+    }
 
-  peer = gst_pad_get_peer (pad);
-  peer_parent = gst_pad_get_parent_element (peer);
+  if (num > 0 && den > 0)
+    return gst_util_uint64_scale_int (GST_SECOND, den, num);
 
-  g_assert (gst_pad_unlink (pad, peer));
-  gst_element_release_request_pad (peer_parent, peer);
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    return GST_BUFFER_DURATION (buffer);
 
-  g_assert (gst_pad_set_active (pad, FALSE));
-  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_ACTIVE); /* deactivate */
+  return 33 * GST_MSECOND;      /* about 30 fps */
+}
 
-  gst_object_unref (peer);
+/* Collects a copy of sticky @event into the list pointed by @data.  */
 
-  media->pause.paused_pads++;
-  if (media->pause.paused_pads == media->linked_pads)
-  {
-    _lp_scene_dispatch (media->prop.scene,
-        LP_EVENT (_lp_event_pause_new (G_OBJECT(media))));
-  }
+static gboolean
+media_collect_sticky_event (arg_unused (GstPad *pad), GstEvent **event,
+                            GList **list)
+{
+  if (GST_EVENT_TYPE (*event) != GST_EVENT_EOS)
+    *list = g_list_append (*list, gst_event_copy (*event));
+  return TRUE;
+}
 
-done:
-  media_unlock (media);
+/* Pushes again the sticky events of @pad, which its peer dropped when it
+   was flushed.  The events are copied, so that @pad marks them as not yet
+   delivered and applies its current offset to them.  */
 
-  return GST_PAD_PROBE_OK;
+static void
+media_resend_sticky_events (GstPad *pad)
+{
+  GList *list = NULL;
+  GList *l;
+
+  gst_pad_sticky_events_foreach
+    (pad, (GstPadStickyEventsForeachFunction) media_collect_sticky_event,
+     &list);
+
+  for (l = list; l != NULL; l = l->next)
+    gst_pad_push_event (pad, (GstEvent *) l->data);
+
+  g_list_free (list);
 }
 
-static GstPadProbeReturn
-lp_media_pause_have_data_probe_callback (GstPad *pad,
-                                   GstPadProbeInfo *info,
-                                   arg_unused(lp_Media *media))
+/* Stops the task that repeats the paused frame of @media (if any) and
+   drops the reference to this frame.  */
+
+static void
+media_stop_pause_task (lp_Media *media)
 {
-  GstCaps *caps = NULL;
-  const char *name = NULL;
-  blocked_pad_info *blocked_pad = NULL;
-  gulong probe_id = 0;
+  GstPad *peer;
 
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-  media_lock (media);
-  if (media_state_paused (media))
-    goto finish;
+  if (media->pause.buffer == NULL)
+    return;                     /* nothing to do */
 
-  g_assert (media_state_pausing(media));
+  /* The task may be waiting on the compositor, which is not consuming
+     if the scene is paused or in lock-step mode; flush the compositor pad
+     to wake it up.  */
+  peer = gst_pad_get_peer (media->video.pad);
+  if (peer != NULL)
+    gst_pad_send_event (peer, gst_event_new_flush_start ());
 
-  caps = gst_pad_query_caps (pad, NULL);
-  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  g_assert (gst_pad_stop_task (media->video.pad));
 
-  if (g_str_equal (name, "video/x-raw"))
-  {
-    GstCaps *videocaps = NULL;
-    media->pause.video_buffer =
-      gst_buffer_copy (GST_PAD_PROBE_INFO_BUFFER (info));
-    videocaps = gst_pad_get_current_caps(pad);
-    media->pause.caps = gst_caps_copy (videocaps);
+  if (peer != NULL)
+    {
+      /* The flush dropped the segment of the compositor pad; send it
+         again before the video pad is unblocked.  */
+      gst_pad_send_event (peer, gst_event_new_flush_stop (FALSE));
+      media_resend_sticky_events (media->video.pad);
+      gst_object_unref (peer);
+    }
 
-    gst_caps_unref (videocaps);
-  }
-  gst_caps_unref (caps);
+  g_clear_pointer (&media->pause.buffer, gst_buffer_unref);
+}
+
+/* Removes the block probes installed by lp_media_pause() from @media
+   pads.  */
+
+static void
+media_remove_pause_probes (lp_Media *media)
+{
+  if (media_has_audio (media) && media->pause.probe_audio > 0)
+    gst_pad_remove_probe (media->audio.pad, media->pause.probe_audio);
 
-  probe_id = gst_pad_add_probe (pad,
-      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
-      (GstPadProbeCallback) lp_media_pause_block_probe_callback,
-      media, NULL);
+  if (media_has_video (media) && media->pause.probe_video > 0)
+    gst_pad_remove_probe (media->video.pad, media->pause.probe_video);
 
-  blocked_pad = g_new0(blocked_pad_info, 1);
-  blocked_pad->pad = (GstPad *) g_object_ref (pad);
-  blocked_pad->probe_id = probe_id;
+  media->pause.probe_audio = 0;
+  media->pause.probe_video = 0;
+}
 
-  media->pause.block_probe_ids = g_slist_prepend (
-      media->pause.block_probe_ids, blocked_pad);
+/* Returns the stream position of @media at running time @now.  */
 
-finish:
-  media_unlock (media);
-  return GST_PAD_PROBE_OK;
+static gint64
+media_get_stream_position (lp_Media *media, GstClockTime now)
+{
+  gint64 run;
+
+  g_assert (GST_CLOCK_TIME_IS_VALID (media->seek.base));
+  run = (now > media->seek.base) ? (gint64)(now - media->seek.base) : 0;
+
+  return media->seek.position + (gint64)(run * media->seek.rate);
 }
 
-/*
- * Creates, adds and links audio elementos within media bin. It returns
- * the corresponding ghost pad created in case of success or NULL otherwise.
- */
+/* Returns the output pad of @media audio chain before the audio tempo:
+   the resample output, or, if @media bypasses conversion, the queue or
+   decoder output.  */
 
 static GstPad *
-_lp_media_configure_audio_bin (lp_Media *media, GstPad *pad)
+media_get_audio_tail_pad (lp_Media *media) /* transfer-full */
 {
-  GstElement *mixer;
+  if (media->audio.resample != NULL)
+    return gst_element_get_static_pad (media->audio.resample, "src");
+  if (media->audio.queue != NULL)
+    return gst_element_get_static_pad (media->audio.queue, "src");
+  g_assert_nonnull (media->audio.decoded);
+  return (GstPad *) gst_object_ref (media->audio.decoded);
+}
+
+/* Inserts the audio convert and resample of @media, which bypasses
+   conversion, right after its audio tail.  The audio ghost pad must not
+   target the tail.  */
+
+static void
+media_insert_audio_convert (lp_Media *media)
+{
+  GstPad *pad;
   GstPad *sink;
-  GstPad *ghost;
 
-  if (unlikely (media_has_audio (media)))
-  {
-    _lp_warn ("ignoring extra audio stream");
-    goto done;
-  }
+  g_assert_null (media->audio.convert);
+  pad = media_get_audio_tail_pad (media);
+  g_assert_nonnull (pad);
 
   _lp_eltmap_alloc_check (media, media_eltmap_audio);
-
-  gstx_bin_add (GST_BIN (media->bin), media->audio.convert);
-  gstx_bin_add (GST_BIN (media->bin), media->audio.resample);
+  gstx_bin_add (media->bin, media->audio.convert);
+  gstx_bin_add (media->bin, media->audio.resample);
   gstx_element_link (media->audio.convert, media->audio.resample);
+  g_object_set (media->audio.resample, "quality",
+                _lp_scene_get_resample_quality (media->prop.scene), NULL);
 
   sink = gst_element_get_static_pad (media->audio.convert, "sink");
   g_assert_nonnull (sink);
-
   g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
   gst_object_unref (sink);
+  gst_object_unref (pad);
 
-  pad = gst_element_get_static_pad (media->audio.resample, "src");
-  g_assert_nonnull (pad);
+  gstx_element_sync_state_with_parent (media->audio.resample);
+  gstx_element_sync_state_with_parent (media->audio.convert);
+}
 
-  ghost = gst_ghost_pad_new (NULL, pad);
-  g_assert_nonnull (ghost);
-  gst_object_unref (pad);
+/* Inserts the audio tempo of @media right after its audio tail, and
+   retargets the audio ghost pad to the tempo output.  If @media bypasses
+   conversion, the tempo may not accept the decoded format, so the audio
+   convert and resample are inserted first.  */
 
-  g_assert (gst_pad_set_active (ghost, TRUE));
-  media->audio.pad = (GstPad *) g_object_ref (ghost); /* ref ghost */
-  g_assert (gst_element_add_pad (media->bin, ghost));
-  g_assert_nonnull (media->audio.pad);
+static void
+media_insert_audio_tempo (lp_Media *media)
+{
+  GstPad *pad;
+  GstPad *sink;
 
-  mixer = _lp_scene_get_audio_mixer (media->prop.scene);
-  g_assert_nonnull (mixer);
+  g_assert_null (media->audio.tempo);
+  _lp_eltmap_alloc_check (media, media_eltmap_audio_tempo);
+  gstx_bin_add (media->bin, media->audio.tempo);
 
-  sink = gst_element_get_request_pad (mixer, "sink_%u");
-  g_assert_nonnull (sink);
+  if (media_has_audio (media))
+    g_assert (gst_ghost_pad_set_target (GST_GHOST_PAD (media->audio.pad),
+                                        NULL));
 
-  g_assert (gst_pad_link (ghost, sink) == GST_PAD_LINK_OK);
-  g_object_set (sink,
-      "mute", media->prop.mute,
-      "volume", media->prop.volume, NULL);
+  if (media->audio.convert == NULL)
+    media_insert_audio_convert (media);
+
+  pad = media_get_audio_tail_pad (media);
+  g_assert_nonnull (pad);
+  sink = gst_element_get_static_pad (media->audio.tempo, "sink");
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
   gst_object_unref (sink);
-  gstx_element_sync_state_with_parent (media->audio.convert);
-  gstx_element_sync_state_with_parent (media->audio.resample);
-  MEDIA_PAD_FLAGS_INIT (media->audio.flags, PAD_FLAG_ACTIVE);
+  gst_object_unref (pad);
 
-done:
-  return ghost;
+  if (media_has_audio (media))
+    {
+      pad = gst_element_get_static_pad (media->audio.tempo, "src");
+      g_assert_nonnull (pad);
+      g_assert (gst_ghost_pad_set_target
+                (GST_GHOST_PAD (media->audio.pad), pad));
+      gst_object_unref (pad);
+      gstx_element_sync_state_with_parent (media->audio.tempo);
+    }
 }
 
-/*
- * Creates, adds and links video and text elementos within media bin. It
- * returns the corresponding ghost pad created in case of success or
- * NULL otherwise.
- */
-static GstPad *
-_lp_media_configure_video_bin (lp_Media *media, GstPad *pad)
+/* Removes the audio tempo of @media and retargets the audio ghost pad back
+   to the audio tail output.  */
+
+static void
+media_remove_audio_tempo (lp_Media *media)
 {
-  GstElement *mixer;
+  GstPad *pad;
   GstPad *sink;
-  GstPad *ghost = NULL;
-  GstCaps *caps = NULL;
-  const GstStructure *str = NULL;
-
-  if (!_lp_scene_has_video (media->prop.scene))
-  {
-    goto done;            /* nothing to do */
-  }
-
-  caps = gst_pad_get_current_caps (pad);
-  if (caps != NULL) /* Media that are only text */
-    str = gst_caps_get_structure (caps, 0);
-
-  if (unlikely (media_has_video (media)))
-  {
-    _lp_warn ("ignoring extra video stream");
-    goto done;
-  }
 
-  if (media_is_frozen (media))
-  {
-    _lp_eltmap_alloc_check (media, media_eltmap_video_freeze);
-    gstx_bin_add (media->bin, media->video.freeze);
+  g_assert_nonnull (media->audio.tempo);
+  g_assert (gst_ghost_pad_set_target (GST_GHOST_PAD (media->audio.pad),
+                                      NULL));
+  pad = media_get_audio_tail_pad (media);
+  g_assert_nonnull (pad);
+  sink = gst_element_get_static_pad (media->audio.tempo, "sink");
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_unlink (pad, sink));
+  gst_object_unref (sink);
+  gstx_element_set_state (media->audio.tempo, GST_STATE_NULL);
+  gstx_bin_remove (media->bin, media->audio.tempo);
+  media->audio.tempo = NULL;
 
-    sink = gst_element_get_static_pad (media->video.freeze, "sink");
-    g_assert_nonnull (sink);
+  g_assert (gst_ghost_pad_set_target (GST_GHOST_PAD (media->audio.pad), pad));
+  gst_object_unref (pad);
+}
 
-    g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
-    gst_object_unref (sink);
+/* Returns the last element of the fixed part of @media video chain, after
+   which the optional crop and text overlay are linked.  */
+#define media_video_tail(m)\
+  (media_is_frozen ((m)) ? (m)->video.freeze : (m)->video.convert)
 
-    pad = gst_element_get_static_pad (media->video.freeze, "src");
-    g_assert_nonnull (pad);
-  }
+/* Tests whether @media video needs a crop.  */
+#define media_video_needs_crop(m)               \
+  ((m)->prop.crop_top != DEFAULT_CROP_TOP       \
+   || (m)->prop.crop_left != DEFAULT_CROP_LEFT  \
+   || (m)->prop.crop_right != DEFAULT_CROP_RIGHT\
+   || (m)->prop.crop_bottom != DEFAULT_CROP_BOTTOM)
 
-  _lp_eltmap_alloc_check (media, media_eltmap_video);
-  gstx_bin_add (media->bin, media->video.convert);
-  gstx_bin_add (media->bin, media->video.crop);
-  gstx_bin_add (media->bin, media->video.text);
+/* Tests whether @media video needs a text overlay.  */
+#define media_video_needs_text(m)\
+  ((m)->prop.text != NULL && *(m)->prop.text != '\0')
 
-  g_assert (gst_element_link_many (media->video.convert,
-        media->video.crop, media->video.text, NULL));
+/* Tests whether the optional elements of @media video chain do not match
+   the current values of its properties.  */
+#define media_video_filters_outdated(m)                         \
+  (media_video_needs_crop ((m)) != ((m)->video.crop != NULL)    \
+   || media_video_needs_text ((m)) != ((m)->video.text != NULL))
 
-  sink = gst_element_get_static_pad (media->video.convert, "sink");
-  g_assert_nonnull (sink);
+/* Sets @media video crop from its crop properties.  */
 
-  g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
-  gst_object_unref (sink);
+static void
+media_update_video_crop (lp_Media *media)
+{
+  g_assert_nonnull (media->video.crop);
+  g_object_set (media->video.crop,
+                "top", (gint) (media->prop.crop_top * media->prop.height),
+                "left", (gint) (media->prop.crop_left * media->prop.width),
+                "right", (gint) (media->prop.crop_right * media->prop.width),
+                "bottom",
+                (gint) (media->prop.crop_bottom * media->prop.height),
+                NULL);
+}
 
-  if (media_is_frozen (media))
-    gst_object_unref (pad);
+/* Sets @media video text overlay from its text properties.  */
 
-  pad = gst_element_get_static_pad (media->video.text, "src");
-  g_assert_nonnull (pad);
+static void
+media_update_video_text (lp_Media *media)
+{
+  const gchar *font;
+
+  g_assert_nonnull (media->video.text);
+  font = media->prop.text_font;
+  g_object_set (media->video.text,
+                "text", media->prop.text,
+                "color", media->prop.text_color,
+                "font-desc", (font != NULL) ? font : "",
+                NULL);
+}
 
-  ghost = gst_ghost_pad_new (NULL, pad);
-  g_assert_nonnull (ghost);
-  gst_object_unref (pad);
+/* Adds or removes the crop and the text overlay of @media, so that each
+   is in the video chain only when its properties are not the default,
+   and links them after the video tail.  The chain must be unlinked after
+   the tail.  Returns the last element of the chain.  */
 
-  g_assert (gst_pad_set_active (ghost, TRUE));
-  media->video.pad = (GstPad *) g_object_ref (ghost); /* ref ghost */
-  g_assert (gst_element_add_pad (media->bin, ghost));
-  g_assert_nonnull (media->video.pad);
+static GstElement *
+media_link_video_filters (lp_Media *media)
+{
+  GstElement *last;
 
-  mixer = _lp_scene_get_video_mixer (media->prop.scene);
-  g_assert_nonnull (mixer);
+  if (media_video_needs_crop (media) && media->video.crop == NULL)
+    {
+      _lp_eltmap_alloc_check (media, media_eltmap_video_crop);
+      gstx_bin_add (media->bin, media->video.crop);
+      media_update_video_crop (media);
+    }
+  else if (!media_video_needs_crop (media) && media->video.crop != NULL)
+    {
+      gstx_element_set_state (media->video.crop, GST_STATE_NULL);
+      gstx_bin_remove (media->bin, media->video.crop);
+      media->video.crop = NULL;
+    }
 
-  sink = gst_element_get_request_pad (mixer, "sink_%u");
-  g_assert_nonnull (sink);
+  if (media_video_needs_text (media) && media->video.text == NULL)
+    {
+      _lp_eltmap_alloc_check (media, media_eltmap_video_text);
+      gstx_bin_add (media->bin, media->video.text);
+      media_update_video_text (media);
+    }
+  else if (!media_video_needs_text (media) && media->video.text != NULL)
+    {
+      gstx_element_set_state (media->video.text, GST_STATE_NULL);
+      gstx_bin_remove (media->bin, media->video.text);
+      media->video.text = NULL;
+    }
 
-  g_assert (gst_pad_link (ghost, sink) == GST_PAD_LINK_OK);
-  g_object_set
-    (sink,
-     "xpos", media->prop.x,
-     "ypos", media->prop.y,
-     "zorder", media->prop.z,
-     "alpha", media->prop.alpha, NULL);
+  last = media_video_tail (media);
+  if (media->video.crop != NULL)
+    {
+      gstx_element_link (last, media->video.crop);
+      last = media->video.crop;
+    }
+  if (media->video.text != NULL)
+    {
+      gstx_element_link (last, media->video.text);
+      last = media->video.text;
+    }
+  return last;
+}
 
-  /* update dimensions */
-  if (media->prop.width > 0)
-    g_object_set (sink, "width", media->prop.width, NULL);
-  else
-  {
-    gint width;
-    if (str != NULL && gst_structure_get_int (str, "width", &width))
-      g_object_set (media, "width", width, NULL);
-  }
+/* Unlinks the optional crop and text overlay of @media from its video
+   chain.  */
 
-  if (media->prop.height > 0)
-    g_object_set (sink, "height", media->prop.height, NULL);
-  {
-    gint height;
-    if (str != NULL && gst_structure_get_int (str, "height", &height))
-      g_object_set (media, "height", height, NULL);
-  }
+static void
+media_unlink_video_filters (lp_Media *media)
+{
+  GstElement *last;
 
-  gst_object_unref (sink);
+  last = media_video_tail (media);
+  if (media->video.crop != NULL)
+    {
+      gst_element_unlink (last, media->video.crop);
+      last = media->video.crop;
+    }
+  if (media->video.text != NULL)
+    gst_element_unlink (last, media->video.text);
+}
 
-  /* crop video */
-  if (media_has_video (media))
-  {
-    g_object_set (media->video.crop,
-        "top", (gint) (media->prop.crop_top * media->prop.height),
-        "left", (gint) (media->prop.crop_left * media->prop.width),
-        "right", (gint) (media->prop.crop_right * media->prop.width),
-        "bottom", (gint) (media->prop.crop_bottom * media->prop.height),
-        NULL);
-  }
+/* Looks up the content of @media in the scene image cache.  If it is
+   there, adds to @media bin an appsrc that feeds it the cached frame and
+   returns %TRUE; otherwise returns %FALSE.  */
 
-  /* set text */
-  if (media->prop.text != NULL)
-  {
-    g_object_set (media->video.text,
-        "text", media->prop.text,
-        "color", media->prop.text_color, NULL);
-  }
+static gboolean
+media_setup_cached_image (lp_Media *media)
+{
+  static const gstx_eltmap_t lp_media_cached_eltmap[] = {
+    {"bin",           offsetof (lp_Media, bin)},
+    {"appsrc",        offsetof (lp_Media, source)},
+    {NULL, 0},
+  };
+  lp_ImageCache *cache;
+  GstBuffer *buffer;
+  GstCaps *caps;
 
-  if (media->prop.text_font != NULL)
-  {
-    g_object_set (media->video.text, "font-desc",
-        media->prop.text_font, NULL);
-  }
+  cache = _lp_scene_get_image_cache (media->prop.scene);
+  g_assert_nonnull (cache);
 
-  if (media_is_frozen (media))
-    gstx_element_sync_state_with_parent (media->video.freeze);
+  if (!_lp_image_cache_lookup (cache, media->prop.final_uri,
+                               &buffer, &caps))
+    {
+      return FALSE;             /* miss */
+    }
 
-  gstx_element_sync_state_with_parent (media->video.convert);
-  gstx_element_sync_state_with_parent (media->video.crop);
-  gstx_element_sync_state_with_parent (media->video.text);
-  MEDIA_PAD_FLAGS_INIT (media->video.flags, PAD_FLAG_ACTIVE);
+  _lp_eltmap_alloc_check (media, lp_media_cached_eltmap);
+  g_object_set (media->source,
+                "caps", caps,
+                "format", GST_FORMAT_TIME,
+                NULL);
+  gst_caps_unref (caps);
+  gstx_bin_add (media->bin, media->source);
 
-  if (caps != NULL)
-    gst_caps_unref (caps);
-done:
+  media->cache.frame = buffer;  /* pushed after bin is linked */
+  media_flag_set (media, FLAG_FROZEN);
 
-  return ghost;
+  return TRUE;
 }
-/* Signals that a new pad has been added to media decoder.  Here we build,
-   link, and pre-roll the necessary audio and video elements.  */
+
+/* Applies the decode queue limits of @media to @queue.  Limits that are
+   not set keep the queue defaults.  */
 
 static void
-lp_media_pad_added_callback (arg_unused (GstElement *dec),
-                             GstPad *pad, lp_Media *media)
+media_setup_decode_queue (lp_Media *media, GstElement *queue)
 {
-  lp_Scene *scene;
-  GstCaps *caps;
-  GstPad *ghost;
-  gulong id;
-  const gchar *name;
-  lp_MediaPadFlag *flags;
-
-  media_lock (media);
-
-  g_assert (media_state_starting (media));
+  if (media->prop.decode_max_bytes > 0)
+    g_object_set (queue, "max-size-bytes",
+                  media->prop.decode_max_bytes, NULL);
+  if (media->prop.decode_max_buffers > 0)
+    g_object_set (queue, "max-size-buffers",
+                  media->prop.decode_max_buffers, NULL);
+  if (media->prop.decode_max_time > 0)
+    g_object_set (queue, "max-size-time",
+                  media->prop.decode_max_time, NULL);
+}
 
-  scene = media->prop.scene;
-  g_assert_nonnull (scene);
+/* Returns the sum of the current level @name ("current-level-bytes",
+   "current-level-buffers", or "current-level-time") of the decode queues
+   of @media.  */
 
-  caps = gst_pad_query_caps (pad, NULL);
-  g_assert_nonnull (caps);
+static guint64
+media_get_decode_level (lp_Media *media, const gchar *name)
+{
+  GstElement *queue[2];
+  guint64 level;
+  gsize i;
 
-  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
-  g_assert_nonnull (name);
-  gst_caps_unref (caps);
+  queue[0] = media->audio.queue;
+  queue[1] = media->video.queue;
 
-  if (g_str_equal (name, "audio/x-raw"))
-  {
-    ghost = _lp_media_configure_audio_bin (media, pad);
-    flags = &media->audio.flags;
-  }
-  else if (g_str_equal (name, "video/x-raw"))
-  {
-    ghost = _lp_media_configure_video_bin (media, pad);
-    flags = &media->video.flags;
-  }
-  else
-  {
-    _lp_warn ("unknown stream type: %s", name);
-    goto done;
-  }
+  level = 0;
+  for (i = 0; i < nelementsof (queue); i++)
+    {
+      GValue value = G_VALUE_INIT;
 
-  if (ghost != NULL)
-  {
-    id = gst_pad_add_probe
-      (ghost, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
-       (GstPadProbeCallback) lp_media_pad_added_block_probe_callback,
-       media, NULL);
-    g_assert (id > 0);
+      if (queue[i] == NULL)
+        continue;
 
-    MEDIA_PAD_FLAG_SET (*flags, PAD_FLAG_BLOCKED);
-    media->linked_pads++;
-  }
+      g_value_init (&value, G_TYPE_UINT64);
+      g_object_get_property (G_OBJECT (queue[i]), name, &value);
+      level += g_value_get_uint64 (&value);
+      g_value_unset (&value);
+    }
 
- done:
-  media_unlock (media);
+  return level;
 }
 
-/* Signals that no more pads will be added to media decoder.  Here we
-   dispatch a start lp_Event that will eventually trigger
-   _lp_media_finish_start() and put media in state "started".  */
+/* Sets the thread count of the decoders and video converter of @media
+   according to its thread share.  The share is split evenly between
+   decoding and conversion.  Elements that do not expose a thread count
+   property keep their defaults.  */
 
 static void
-lp_media_no_more_pads_callback (GstElement *dec, lp_Media *media)
+media_apply_threads_unlocked (lp_Media *media)
 {
-  media_lock (media);
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  guint dec_threads;
+  guint conv_threads;
+  gboolean done;
 
-  g_assert (media_state_starting (media));
+  if (media->threads == 0 || media->bin == NULL)
+    return;                     /* nothing to do */
 
-  if (unlikely (!media_has_audio (media) && !media_has_video (media)))
-  {
-    lp_EventError *event =
-      _lp_event_error_new_start_no_pads (G_OBJECT(media));
-    g_assert_nonnull (event);
-    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
-    goto done;
-  }
+  conv_threads = max (media->threads / 2, 1);
+  dec_threads = max (media->threads - media->threads / 2, 1);
 
-  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_ACTIVE));
-  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_BLOCKED));
-  media_toggle_flag_on_all_pads (media, PAD_FLAG_BLOCKED); /* unblock */
+  it = gst_bin_iterate_recurse (GST_BIN (media->bin));
+  g_assert_nonnull (it);
 
- done:
-  g_signal_handler_disconnect (dec, media->callback.pad_added);
-  g_signal_handler_disconnect (dec, media->callback.no_more_pads);
-  g_signal_handler_disconnect (dec, media->callback.autoplug_continue);
+  done = FALSE;
+  while (!done)
+    {
+      switch (gst_iterator_next (it, &item))
+        {
+        case GST_ITERATOR_OK:
+          {
+            GObject *elt;
+            GType type;
+
+            elt = G_OBJECT (g_value_get_object (&item));
+            if ((GstElement *) elt == media->video.convert)
+              {
+                type = gx_object_find_property_type (elt, "n-threads");
+                if (type == G_TYPE_UINT)
+                  g_object_set (elt, "n-threads", conv_threads, NULL);
+              }
+            else
+              {
+                type = gx_object_find_property_type (elt, "max-threads");
+                if (type == G_TYPE_INT)
+                  g_object_set (elt, "max-threads", (gint) dec_threads,
+                                NULL);
+                else if (type == G_TYPE_UINT)
+                  g_object_set (elt, "max-threads", dec_threads, NULL);
+              }
+            g_value_reset (&item);
+            break;
+          }
+        case GST_ITERATOR_RESYNC:
+          gst_iterator_resync (it);
+          break;
+        case GST_ITERATOR_ERROR:  /* fall through */
+        case GST_ITERATOR_DONE:
+          done = TRUE;
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+    }
 
-  media_unlock (media);
+  g_value_unset (&item);
+  gst_iterator_free (it);
 }
 
-/* Signals that media decoder has found a new stream, which in this case
-   happens immediately before the decoder starts looking for elements to
-   decode the stream.  Here we check if the stream corresponds to a still
-   image (PNG, JPG, etc.) and, if so, we mark it as frozen.  */
+/* Returns the running time at which the current segment of @media ends,
+   or GST_CLOCK_TIME_NONE if the duration of @media is unknown.  */
 
-static gboolean
-lp_media_autoplug_continue_callback (arg_unused (GstElement *elt),
-                                     arg_unused (GstPad *pad),
-                                     GstCaps *caps, lp_Media *media)
+static GstClockTime
+media_get_end_running_time (lp_Media *media)
 {
-  const gchar *name;
+  gint64 duration;
 
-  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
-  g_assert_nonnull (name);
+  if (unlikely (media->decoder == NULL))
+    return GST_CLOCK_TIME_NONE;
 
-  if (!g_str_has_prefix (name, "image"))
-    return TRUE;                /* not an image, nothing to do */
+  if (unlikely (!gst_element_query_duration (media->decoder,
+                                             GST_FORMAT_TIME, &duration)))
+    return GST_CLOCK_TIME_NONE;
 
-  media_lock (media);
-  media_flag_set (media, FLAG_FROZEN); /* freeze */
-  media_unlock (media);
-  return TRUE;
+  if (unlikely (duration < media->seek.position))
+    return GST_CLOCK_TIME_NONE;
+
+  g_assert (GST_CLOCK_TIME_IS_VALID (media->seek.base));
+  return media->seek.base + (GstClockTime)
+    ((duration - media->seek.position) / media->seek.rate);
 }
 
-/* Signals that media decoder has drained its source.  Here we stop the
-   media object (if it is not frozen).  */
+/* Lets through the first data held on @pad of @media by the block probe
+   @id, shifted to the start offset of @media.  Media must be locked.  */
 
 static void
-lp_media_drained_callback (GstElement *dec, lp_Media *media)
+media_unblock_pad_unlocked (lp_Media *media, GstPad *pad, gulong id)
 {
-  media_lock (media);
+  lp_MediaPadFlag *flags;
+
+  flags = media_get_pad_flags (media, pad);
+  g_assert_nonnull (flags);
+  g_assert (!media_pad_flag_flushed (*flags));
+  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
+  gst_pad_set_offset (pad, (gint64) media->offset);
+  gst_pad_remove_probe (pad, id);
+}
+
+/* Dispatches the start lp_Event of @media if all its pads have been
+   flushed, i.e., if it has prerolled.  Media must be locked.  */
+
+static void
+media_dispatch_start_if_prerolled (lp_Media *media)
+{
+  lp_EventStart *event;
+
+  if (!media_has_audio (media) && !media_has_video (media))
+    return;                     /* no pads yet */
+
+  if (!media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED))
+    return;                     /* not prerolled yet */
+
+  event = _lp_event_start_new (G_OBJECT (media), FALSE);
+  g_assert_nonnull (event);
+  media_trace_instant (media, "prerolled", NULL);
+  _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+}
+
+/* Posts the message that triggers the preroll seek of @media (cf.
+   _lp_media_finish_preroll()), if the seek is pending and all pads of
+   @media hold their first data.  The flush of the seek then drops only
+   data that has not reached the mixers.  Media must be locked.  */
+
+static void
+media_post_preroll_seek_unlocked (lp_Media *media)
+{
+  GstMessage *msg;
+
+  if (!media_is_prerolling (media))
+    return;                     /* nothing to do */
+
+  if ((media_has_audio (media) && media->preroll.probe_audio == 0)
+      || (media_has_video (media) && media->preroll.probe_video == 0))
+    return;                     /* some pad has no data yet */
+
+  media_toggle_prerolling (media); /* post once */
+  msg = gst_message_new_element
+    (GST_OBJECT (media->bin),
+     gst_structure_new_empty ("lp_Media-preroll-seek"));
+  g_assert_nonnull (msg);
+  g_assert (gst_element_post_message (media->bin, msg));
+}
+
+/* Ends a loop iteration of @media, whose segment has ended at stream
+   position @stop.  If @media is still in loop mode, restarts the segment
+   with a non-flushing seek, which continues the running time where the
+   last segment ended.  Otherwise, seeks to @stop without the segment flag
+   so that @media drains as usual.  Called from the streaming thread that
+   carries the segment-done event.  Media must be locked.  */
+
+static void
+media_restart_segment_unlocked (lp_Media *media, gint64 stop)
+{
+  gint64 start;
+  gint flags;
+
+  if (unlikely (!media_state_started (media)))
+    return;                     /* stopped, paused, or sought meanwhile */
+
+  flags = GST_SEEK_FLAG_ACCURATE;
+  if (media->prop.loop)
+    {
+      flags |= GST_SEEK_FLAG_SEGMENT;
+      start = 0;
+    }
+  else
+    {
+      start = stop;
+    }
+
+  if (unlikely (!gst_element_seek (media->bin, media->seek.rate,
+                                   GST_FORMAT_TIME, (GstSeekFlags) flags,
+                                   GST_SEEK_TYPE_SET, start,
+                                   GST_SEEK_TYPE_NONE, 0)))
+    {
+      _lp_warn ("cannot loop %p", media);
+      return;
+    }
+
+  /* The last segment ran from the stream position at base up to @stop.  */
+  media->seek.base += (GstClockTime)
+    ((stop - media->seek.position) / media->seek.rate);
+  media->seek.position = start;
+  media->seek.segment = media->prop.loop;
+  media_trace_instant (media, "loop", NULL);
+}
+
+/* Releases @media, which has been prerolled in standby, so that it starts
+   at running time @offset.  Standby pads are not linked to the scene
+   mixers, which would otherwise wait on them and stall the media being
+   played; they are linked here.  Pads already blocked on their first data
+   are unblocked here; the others are unblocked later by
+   lp_media_pad_added_block_probe_callback() as usual.  Media must be
+   locked.  */
+
+static void
+media_release_standby_unlocked (lp_Media *media, GstClockTime offset)
+{
+  GstPad *pad[2];
+  gulong *id[2];
+  gsize i;
+
+  g_assert (media_state_starting (media));
+  g_assert (media_is_standby (media));
+  g_assert (GST_CLOCK_TIME_IS_VALID (offset));
+  media_toggle_standby (media); /* release */
+
+  media->offset = offset;
+  media->seek.base = offset;
+
+  if (media_has_audio (media))
+    media_link_audio_mixer (media);
+  if (media_has_video (media))
+    media_link_video_mixer (media);
+
+  pad[0] = media->audio.pad;
+  id[0] = &media->standby.probe_audio;
+  pad[1] = media->video.pad;
+  id[1] = &media->standby.probe_video;
+
+  for (i = 0; i < nelementsof (pad); i++)
+    {
+      if (*id[i] == 0)
+        continue;               /* not blocked yet */
+
+      media_unblock_pad_unlocked (media, pad[i], *id[i]);
+      *id[i] = 0;
+    }
+
+  media_dispatch_start_if_prerolled (media);
+}
+
+/* Returns a new reference to the media that follows @m (cf. property
+   "next"), or NULL if there is none.  Media must be locked.  The next
+   media is only locked after @m is unlocked, so that media locks are
+   never nested.  */
+#define media_ref_next(m)\
+  (((m)->prop.next != NULL) ? g_object_ref ((m)->prop.next) : NULL)
+
+/* Serializes changes to the "next" links of all media, so that cycles
+   are reliably detected.  */
+G_LOCK_DEFINE_STATIC (next_links);
+
+/* Returns true if following the "next" links from @next leads back to
+   @media.  The "next_links" lock must be held.  */
+
+static gboolean
+media_next_makes_cycle (lp_Media *media, lp_Media *next)
+{
+  for (; next != NULL; next = next->prop.next)
+    if (next == media)
+      return TRUE;
+  return FALSE;
+}
+
+/* Prerolls @next, the media that follows another media, in standby if it
+   is stopped.  @next must not be locked, nor the media it follows.  */
+
+static void
+media_preroll_next (lp_Media *next)
+{
+  /* Media that cannot be prerolled is started when the other drains.  */
+  media_lock (next);
+  if (media_state_stopped (next)
+      && unlikely (!media_start_unlocked (next, TRUE)))
+    {
+      _lp_warn ("cannot preroll next media %p", next);
+    }
+  media_unlock (next);
+}
+
+/* Starts @next, the media that follows another media, at running time
+   @boundary, where the other media ends.  @next must not be locked, nor
+   the media it follows.  */
+
+static void
+media_start_next (lp_Media *next, GstClockTime boundary)
+{
+  media_lock (next);
+  if (media_state_starting (next) && media_is_standby (next))
+    {
+      media_release_standby_unlocked (next, boundary);
+    }
+  else if (media_state_stopped (next))
+    {
+      if (unlikely (!media_start_unlocked (next, FALSE)))
+        _lp_warn ("cannot start next media %p", next);
+    }
+  media_unlock (next);
+}
+
+
+/* callbacks */
+
+/* WARNING: In the callbacks, media must be *LOCKED*.  */
+
+/* Signals that a media pad has been blocked, which in this case happens
+   immediately after the corresponding pad is added to the media decoder.
+   Here we keep the pad blocked until it is explicit unblocked by
+   lp_media_no_more_pads_callback() and, if media is in standby, until it is
+   released by media_release_standby_unlocked().  */
+
+static GstPadProbeReturn
+lp_media_pad_added_block_probe_callback (GstPad *pad, GstPadProbeInfo *info,
+                                         lp_Media *media)
+{
+  lp_MediaPadFlag *flags;
+
+  media_lock (media);
+
+  if (unlikely (!media_state_starting (media)))
+    goto unblock;               /* drop residual probes */
+
+  flags = media_get_pad_flags (media, pad);
+  g_assert_nonnull (flags);
+  g_assert (media_pad_flag_active (*flags));
+
+  if (media_pad_flag_blocked (*flags))
+  {
+    /* Remember the probe holding the first data of @pad, so that the
+       preroll seek can be done once all pads hold theirs.  */
+    if (pad == media->audio.pad)
+      media->preroll.probe_audio = GST_PAD_PROBE_INFO_ID (info);
+    else
+      media->preroll.probe_video = GST_PAD_PROBE_INFO_ID (info);
+    media_post_preroll_seek_unlocked (media);
+    media_unlock (media);
+    return GST_PAD_PROBE_OK;  /* block */
+  }
+
+  if (media_pad_flag_flushed (*flags))
+    goto unblock;               /* drop residual probes */
+
+  if (media_is_standby (media))
+  {
+    /* Keep the pad blocked on its first data until media is released by
+       media_release_standby_unlocked().  */
+    if (pad == media->audio.pad)
+      media->standby.probe_audio = GST_PAD_PROBE_INFO_ID (info);
+    else
+      media->standby.probe_video = GST_PAD_PROBE_INFO_ID (info);
+    media_unlock (media);
+    return GST_PAD_PROBE_OK;    /* block */
+  }
+
+  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
+  g_assert (media_state_starting (media));
+  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
+  gst_pad_set_offset (pad, (gint64) media->offset);
+  media_dispatch_start_if_prerolled (media);
+
+ unblock:
+  media_unlock (media);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Signals that a converted frame has reached the image freezer of a still
+   image.  Here we store the frame into the scene image cache, so that other
+   media objects showing the same image need not decode it again.  */
+
+static GstPadProbeReturn
+lp_media_image_cache_probe_callback (GstPad *pad, GstPadProbeInfo *info,
+                                     lp_Media *media)
+{
+  lp_ImageCache *cache;
+  GstCaps *caps;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (unlikely (caps == NULL))
+    return GST_PAD_PROBE_OK;    /* not negotiated yet */
+
+  media_lock (media);
+
+  if (likely (media->prop.final_uri != NULL))
+    {
+      cache = _lp_scene_get_image_cache (media->prop.scene);
+      g_assert_nonnull (cache);
+      _lp_image_cache_insert (cache, media->prop.final_uri,
+                              GST_PAD_PROBE_INFO_BUFFER (info), caps);
+    }
+
+  media_unlock (media);
+
+  gst_caps_unref (caps);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Signals that the audio tail output is idle, which in this case
+   happens after the rate of @media has changed.  Here we insert or remove
+   the audio tempo, so that it is in the audio graph only when the rate of
+   @media is not 1.0.  */
+
+static GstPadProbeReturn
+lp_media_tempo_idle_probe_callback (arg_unused (GstPad *pad),
+                                    arg_unused (GstPadProbeInfo *info),
+                                    lp_Media *media)
+{
+  media_lock (media);
+
+  if (unlikely (!media_has_audio (media)))
+    goto done;                  /* nothing to do */
+
+  if (media->prop.rate != 1.0 && media->audio.tempo == NULL)
+    media_insert_audio_tempo (media);
+  else if (media->prop.rate == 1.0 && media->audio.tempo != NULL)
+    media_remove_audio_tempo (media);
+
+ done:
+  media_unlock (media);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Signals that the video tail output is idle, which in this case happens
+   after a crop or text property of @media has changed.  Here we insert or
+   remove the crop and the text overlay, so that each is in the video graph
+   only when its properties are not the default.  */
+
+static GstPadProbeReturn
+lp_media_video_filters_idle_probe_callback (arg_unused (GstPad *pad),
+                                            arg_unused (GstPadProbeInfo *info),
+                                            lp_Media *media)
+{
+  GstElement *last;
+  GstPad *src;
+
+  media_lock (media);
+
+  if (unlikely (!media_has_video (media)))
+    goto done;                  /* nothing to do */
+
+  if (!media_video_filters_outdated (media))
+    goto done;                  /* nothing to do */
+
+  g_assert (gst_ghost_pad_set_target (GST_GHOST_PAD (media->video.pad),
+                                      NULL));
+  media_unlink_video_filters (media);
+  last = media_link_video_filters (media);
+
+  src = gst_element_get_static_pad (last, "src");
+  g_assert_nonnull (src);
+  g_assert (gst_ghost_pad_set_target (GST_GHOST_PAD (media->video.pad), src));
+  gst_object_unref (src);
+
+  if (media->video.crop != NULL)
+    gstx_element_sync_state_with_parent (media->video.crop);
+  if (media->video.text != NULL)
+    gstx_element_sync_state_with_parent (media->video.text);
+
+ done:
+  media_unlock (media);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Schedules the insertion or removal of the crop and text overlay of
+   @media when its video chain is idle.  Media must be locked.  */
+
+static void
+media_replug_video_filters_unlocked (lp_Media *media)
+{
+  GstPad *pad;
+
+  /* The probe is called immediately if the pad is already idle.  */
+  pad = gst_element_get_static_pad (media_video_tail (media), "src");
+  g_assert_nonnull (pad);
+  gst_pad_add_probe
+    (pad, GST_PAD_PROBE_TYPE_IDLE,
+     (GstPadProbeCallback) lp_media_video_filters_idle_probe_callback,
+     media, NULL);
+  gst_object_unref (pad);
+}
+
+/* Repeats the paused frame of @media while @media is paused.  Each
+   repeated frame is a new buffer that shares the memory of the paused
+   frame; only its metadata is copied.  This runs in a task started on the
+   video pad of @media and must not lock @media, as the task is stopped
+   while @media is locked.  */
+
+static void
+lp_media_pause_task_func (lp_Media *media)
+{
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+
+  buffer = gst_buffer_copy_region (media->pause.buffer,
+                                   (GstBufferCopyFlags)
+                                   (GST_BUFFER_COPY_METADATA
+                                    | GST_BUFFER_COPY_MEMORY),
+                                   0, (gsize) -1);
+  g_assert_nonnull (buffer);
+
+  GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DISCONT);
+  GST_BUFFER_PTS (buffer) = media->pause.pts;
+  GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = media->pause.duration;
+  media->pause.pts += media->pause.duration;
+
+  ret = gst_pad_push (media->video.pad, buffer);
+  if (unlikely (ret != GST_FLOW_OK))
+    gst_pad_pause_task (media->video.pad);
+}
+
+/* Signals that a media pad has been blocked, which in this case happens
+   immediately after lp_media_pause() is called.  Here we keep the pad
+   blocked until lp_media_resume() or lp_media_stop() is called.  The audio
+   pad is unlinked from the audio mixer.  The video pad stays linked to its
+   compositor pad, where lp_media_pause_task_func() keeps repeating the
+   blocked frame.  When all pads have been blocked, we dispatch a pause
+   lp_Event that will eventually trigger _lp_media_finish_pause() and put
+   media in state "paused".  */
+
+static GstPadProbeReturn
+lp_media_pause_block_probe_callback (GstPad *pad, GstPadProbeInfo *info,
+                                     lp_Media *media)
+{
+  GstBuffer *buffer;
+  lp_MediaPadFlag *flags;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  g_assert_nonnull (buffer);
+
+  /* Let repeated frames through; don't lock media here (see
+     lp_media_pause_task_func()).  */
+  if (media_is_pause_frame (media, buffer))
+    return GST_PAD_PROBE_PASS;
+
+  media_lock (media);
+
+  if (unlikely (!media_state_pausing (media)))
+    goto unblock;               /* drop residual probes */
+
+  flags = media_get_pad_flags (media, pad);
+  g_assert_nonnull (flags);
+  g_assert (media_pad_flag_active (*flags));
+  g_assert (!media_pad_flag_blocked (*flags));
+  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_BLOCKED); /* block */
+
+  if (pad == media->audio.pad)
+    {
+      media_unlink_audio_mixer (media);
+    }
+  else if (GST_BUFFER_PTS_IS_VALID (buffer))
+    {
+      g_assert_null (media->pause.buffer);
+      media->pause.buffer = gst_buffer_ref (buffer);
+      media->pause.pts = GST_BUFFER_PTS (buffer);
+      media->pause.duration = media_get_pause_frame_duration (media, buffer);
+      g_assert (gst_pad_start_task
+                (pad, (GstTaskFunction) lp_media_pause_task_func,
+                 media, NULL));
+    }
+
+  if (media_is_flag_set_on_all_pads (media, PAD_FLAG_BLOCKED))
+    {
+      lp_EventPause *event = _lp_event_pause_new (G_OBJECT (media));
+      g_assert_nonnull (event);
+      _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+    }
+
+  media_unlock (media);
+  return GST_PAD_PROBE_OK;      /* block */
+
+ unblock:
+  media_unlock (media);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/*
+ * Creates, adds and links audio elementos within media bin. It returns
+ * the corresponding ghost pad created in case of success or NULL otherwise.
+ */
+
+static GstPad *
+_lp_media_configure_audio_bin (lp_Media *media, GstPad *pad)
+{
+  GstPad *sink;
+  GstPad *ghost;
+  GstCaps *pinned;
+  GstCaps *caps;
+  gboolean bypass;
+
+  if (unlikely (media_has_audio (media)))
+  {
+    _lp_warn ("ignoring extra audio stream");
+    goto done;
+  }
+
+  media->audio.decoded = (GstPad *) gst_object_ref (pad);
+
+  /* Bypass conversion if the decoded audio already matches the format to
+     which the scene pins its mixer.  The audio tempo may need conversion,
+     so media that start at a rate other than 1.0 are always converted, and
+     media whose rate changes later get conversion with the tempo.  */
+  bypass = FALSE;
+  pinned = _lp_scene_get_audio_caps (media->prop.scene);
+  if (pinned != NULL)
+  {
+    caps = gst_pad_get_current_caps (pad);
+    if (caps != NULL)
+    {
+      bypass = media->prop.rate == 1.0
+        && gst_caps_is_fixed (caps) && gst_caps_is_subset (caps, pinned);
+      gst_caps_unref (caps);
+    }
+    gst_caps_unref (pinned);
+  }
+
+  if (!bypass)
+  {
+    _lp_eltmap_alloc_check (media, media_eltmap_audio);
+    gstx_bin_add (GST_BIN (media->bin), media->audio.convert);
+    gstx_bin_add (GST_BIN (media->bin), media->audio.resample);
+    gstx_element_link (media->audio.convert, media->audio.resample);
+    g_object_set (media->audio.resample, "quality",
+                  _lp_scene_get_resample_quality (media->prop.scene), NULL);
+  }
+
+  if (media_has_decode_limits (media))
+  {
+    _lp_eltmap_alloc_check (media, media_eltmap_audio_queue);
+    media_setup_decode_queue (media, media->audio.queue);
+    gstx_bin_add (GST_BIN (media->bin), media->audio.queue);
+    if (media->audio.convert != NULL)
+      gstx_element_link (media->audio.queue, media->audio.convert);
+  }
+
+  if (media->audio.queue != NULL || media->audio.convert != NULL)
+  {
+    sink = gst_element_get_static_pad ((media->audio.queue != NULL)
+                                       ? media->audio.queue
+                                       : media->audio.convert, "sink");
+    g_assert_nonnull (sink);
+
+    g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
+    gst_object_unref (sink);
+  }
+
+  if (media->prop.rate != 1.0)  /* keep pitch */
+    media_insert_audio_tempo (media);
+
+  pad = (media->audio.tempo != NULL)
+    ? gst_element_get_static_pad (media->audio.tempo, "src")
+    : media_get_audio_tail_pad (media);
+  g_assert_nonnull (pad);
+
+  ghost = gst_ghost_pad_new (NULL, pad);
+  g_assert_nonnull (ghost);
+  gst_object_unref (pad);
+
+  g_assert (gst_pad_set_active (ghost, TRUE));
+  media->audio.pad = (GstPad *) g_object_ref (ghost); /* ref ghost */
+  g_assert (gst_element_add_pad (media->bin, ghost));
+  g_assert_nonnull (media->audio.pad);
+
+  if (!media_is_standby (media)) /* linked on release */
+    media_link_audio_mixer (media);
+  if (media->audio.queue != NULL)
+    gstx_element_sync_state_with_parent (media->audio.queue);
+  if (media->audio.convert != NULL)
+    gstx_element_sync_state_with_parent (media->audio.convert);
+  if (media->audio.resample != NULL)
+    gstx_element_sync_state_with_parent (media->audio.resample);
+  if (media->audio.tempo != NULL)
+    gstx_element_sync_state_with_parent (media->audio.tempo);
+  MEDIA_PAD_FLAGS_INIT (media->audio.flags, PAD_FLAG_ACTIVE);
+
+done:
+  return ghost;
+}
+
+/*
+ * Creates, adds and links video and text elementos within media bin. It
+ * returns the corresponding ghost pad created in case of success or
+ * NULL otherwise.
+ */
+static GstPad *
+_lp_media_configure_video_bin (lp_Media *media, GstPad *pad)
+{
+  GstPad *sink;
+  GstPad *ghost = NULL;
+  GstCaps *caps = NULL;
+  const GstStructure *str = NULL;
+
+  if (!_lp_scene_has_video (media->prop.scene))
+  {
+    goto done;            /* nothing to do */
+  }
+
+  caps = gst_pad_get_current_caps (pad);
+  if (caps != NULL) /* Media that are only text */
+    str = gst_caps_get_structure (caps, 0);
+
+  if (unlikely (media_has_video (media)))
+  {
+    _lp_warn ("ignoring extra video stream");
+    goto done;
+  }
+
+  _lp_eltmap_alloc_check (media, media_eltmap_video);
+  gstx_bin_add (media->bin, media->video.convert);
+
+  if (media_is_frozen (media))
+  {
+    /* Freeze after conversion, so that a still image is converted only
+       once and the converted frame can be shared via the image cache.  */
+    _lp_eltmap_alloc_check (media, media_eltmap_video_freeze);
+    gstx_bin_add (media->bin, media->video.freeze);
+    gstx_element_link (media->video.convert, media->video.freeze);
+
+    if (media->source == NULL)  /* decoded, i.e., not cached */
+    {
+      gulong id;
+
+      sink = gst_element_get_static_pad (media->video.freeze, "sink");
+      g_assert_nonnull (sink);
+
+      id = gst_pad_add_probe
+        (sink, GST_PAD_PROBE_TYPE_BUFFER,
+         (GstPadProbeCallback) lp_media_image_cache_probe_callback,
+         media, NULL);
+      g_assert (id > 0);
+      gst_object_unref (sink);
+    }
+  }
+  else
+  {
+    if (media_has_decode_limits (media))
+    {
+      _lp_eltmap_alloc_check (media, media_eltmap_video_queue);
+      media_setup_decode_queue (media, media->video.queue);
+      gstx_bin_add (media->bin, media->video.queue);
+      gstx_element_link (media->video.queue, media->video.convert);
+    }
+  }
+
+  sink = gst_element_get_static_pad ((media->video.queue != NULL)
+                                     ? media->video.queue
+                                     : media->video.convert, "sink");
+  g_assert_nonnull (sink);
+
+  g_assert (gst_pad_link (pad, sink) == GST_PAD_LINK_OK);
+  gst_object_unref (sink);
+
+  /* Crop and text overlay are linked only if needed; see
+     lp_media_video_filters_idle_probe_callback().  */
+  pad = gst_element_get_static_pad (media_link_video_filters (media), "src");
+  g_assert_nonnull (pad);
+
+  ghost = gst_ghost_pad_new (NULL, pad);
+  g_assert_nonnull (ghost);
+  gst_object_unref (pad);
+
+  g_assert (gst_pad_set_active (ghost, TRUE));
+  media->video.pad = (GstPad *) g_object_ref (ghost); /* ref ghost */
+  g_assert (gst_element_add_pad (media->bin, ghost));
+  g_assert_nonnull (media->video.pad);
+
+  if (!media_is_standby (media)) /* linked on release */
+    media_link_video_mixer (media);
+
+  /* Media without explicit dimensions take those of the video.  */
+  if (media->prop.width <= 0)
+  {
+    gint width;
+    if (str != NULL && gst_structure_get_int (str, "width", &width))
+      g_object_set (media, "width", width, NULL);
+  }
+
+  if (media->prop.height <= 0)
+  {
+    gint height;
+    if (str != NULL && gst_structure_get_int (str, "height", &height))
+      g_object_set (media, "height", height, NULL);
+  }
+
+  /* Crop depends on the dimensions, which may have been updated above.  */
+  if (media->video.crop != NULL)
+    media_update_video_crop (media);
+
+  if (media_is_frozen (media))
+    gstx_element_sync_state_with_parent (media->video.freeze);
+
+  if (media->video.queue != NULL)
+    gstx_element_sync_state_with_parent (media->video.queue);
+
+  gstx_element_sync_state_with_parent (media->video.convert);
+  if (media->video.crop != NULL)
+    gstx_element_sync_state_with_parent (media->video.crop);
+  if (media->video.text != NULL)
+    gstx_element_sync_state_with_parent (media->video.text);
+  MEDIA_PAD_FLAGS_INIT (media->video.flags, PAD_FLAG_ACTIVE);
+
+  if (caps != NULL)
+    gst_caps_unref (caps);
+done:
+
+  return ghost;
+}
+
+/* Signals that a media pad has received a downstream event.  Here we
+   catch the segment-done event that ends each iteration of a looping
+   media (cf. property "loop") and restart the segment right here, in the
+   streaming thread, so that the loop point does not depend on how soon
+   the application pumps the scene bus.  A message is posted afterwards
+   to report the iteration.  The event is dropped, as the mixers should
+   see a single continuous stream.  */
+
+static GstPadProbeReturn
+lp_media_segment_done_probe_callback (GstPad *pad, GstPadProbeInfo *info,
+                                      lp_Media *media)
+{
+  GstEvent *evt;
+  GstFormat format;
+  gint64 position;
+  GstStructure *st;
+  GstMessage *msg;
+
+  evt = GST_PAD_PROBE_INFO_EVENT (info);
+  g_assert_nonnull (evt);
+
+  if (GST_EVENT_TYPE (evt) != GST_EVENT_SEGMENT_DONE)
+    return GST_PAD_PROBE_OK;    /* nothing to do */
+
+  if (media_has_video (media) && pad != media->video.pad)
+    return GST_PAD_PROBE_DROP;  /* video pad leads the loop */
+
+  gst_event_parse_segment_done (evt, &format, &position);
+  if (unlikely (format != GST_FORMAT_TIME))
+    return GST_PAD_PROBE_DROP;  /* unknown format */
+
+  media_lock (media);
+  media_restart_segment_unlocked (media, position);
+  media_unlock (media);
+
+  st = gst_structure_new ("lp_Media-segment-done",
+                          "position", G_TYPE_INT64, position, NULL);
+  g_assert_nonnull (st);
+
+  msg = gst_message_new_element (GST_OBJECT (media->bin), st);
+  g_assert_nonnull (msg);
+  g_assert (gst_element_post_message (media->bin, msg));
+
+  return GST_PAD_PROBE_DROP;
+}
+
+/* Signals that data or an upstream event crossed the media video pad.
+   Here we count the frames pushed to the video mixer and the frames that
+   QoS events sent upstream by the mixer report as late.  This runs for
+   every frame, so the counters are updated atomically.  */
+
+static GstPadProbeReturn
+lp_media_qos_probe_callback (arg_unused (GstPad *pad),
+                             GstPadProbeInfo *info, lp_Media *media)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+      media_qos_add (media, processed, 1);
+    }
+  else
+    {
+      GstEvent *evt;
+      GstClockTimeDiff diff;
+
+      evt = GST_PAD_PROBE_INFO_EVENT (info);
+      g_assert_nonnull (evt);
+
+      if (GST_EVENT_TYPE (evt) != GST_EVENT_QOS)
+        return GST_PAD_PROBE_OK; /* nothing to do */
+
+      gst_event_parse_qos (evt, NULL, NULL, &diff, NULL);
+      if (diff > 0)
+        {
+          media_qos_add (media, late, 1);
+          media_qos_add_lateness (media, diff);
+        }
+    }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Signals that an element has been added to the media decoder.  Here we
+   apply the demux queue limits to the internal decodebin, whose multiqueue
+   holds the demuxed streams.  */
+
+static void
+lp_media_element_added_callback (arg_unused (GstBin *dec),
+                                 GstElement *elt, lp_Media *media)
+{
+  GstElementFactory *factory;
+
+  factory = gst_element_get_factory (elt);
+  if (factory == NULL
+      || !g_str_equal (GST_OBJECT_NAME (factory), "decodebin"))
+    return;                     /* nothing to do */
+
+  media_lock (media);
+
+  if (media->prop.demux_max_bytes > 0)
+    g_object_set (elt, "max-size-bytes", media->prop.demux_max_bytes, NULL);
+  if (media->prop.demux_max_buffers > 0)
+    g_object_set (elt, "max-size-buffers",
+                  media->prop.demux_max_buffers, NULL);
+  if (media->prop.demux_max_time > 0)
+    g_object_set (elt, "max-size-time", media->prop.demux_max_time, NULL);
+
+  media_unlock (media);
+}
+
+/* Signals that a new pad has been added to media decoder.  Here we build,
+   link, and pre-roll the necessary audio and video elements.  */
+
+static void
+lp_media_pad_added_callback (arg_unused (GstElement *dec),
+                             GstPad *pad, lp_Media *media)
+{
+  lp_Scene *scene;
+  GstCaps *caps;
+  GstPad *ghost;
+  gulong id;
+  const gchar *name;
+  lp_MediaPadFlag *flags;
+
+  media_lock (media);
+
+  g_assert (media_state_starting (media));
+
+  scene = media->prop.scene;
+  g_assert_nonnull (scene);
+
+  caps = gst_pad_query_caps (pad, NULL);
+  g_assert_nonnull (caps);
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  g_assert_nonnull (name);
+  media_trace_instant (media, "pad-added", name);
+  gst_caps_unref (caps);
+
+  if (g_str_equal (name, "audio/x-raw"))
+  {
+    ghost = _lp_media_configure_audio_bin (media, pad);
+    flags = &media->audio.flags;
+  }
+  else if (g_str_equal (name, "video/x-raw"))
+  {
+    ghost = _lp_media_configure_video_bin (media, pad);
+    flags = &media->video.flags;
+  }
+  else
+  {
+    _lp_warn ("unknown stream type: %s", name);
+    goto done;
+  }
+
+  if (ghost != NULL)
+  {
+    id = gst_pad_add_probe
+      (ghost, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+       (GstPadProbeCallback) lp_media_pad_added_block_probe_callback,
+       media, NULL);
+    g_assert (id > 0);
+
+    MEDIA_PAD_FLAG_SET (*flags, PAD_FLAG_BLOCKED);
+    media->linked_pads++;
+
+    id = gst_pad_add_probe
+      (ghost, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+       (GstPadProbeCallback) lp_media_segment_done_probe_callback,
+       media, NULL);
+    g_assert (id > 0);
+
+    if (flags == &media->video.flags)
+      {
+        id = gst_pad_add_probe
+          (ghost, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER
+                                    | GST_PAD_PROBE_TYPE_EVENT_UPSTREAM),
+           (GstPadProbeCallback) lp_media_qos_probe_callback,
+           media, NULL);
+        g_assert (id > 0);
+      }
+
+    /* Decoders exist by now, so this is the earliest point where their
+       thread count can be set.  */
+    media_apply_threads_unlocked (media);
+  }
+
+ done:
+  media_unlock (media);
+}
+
+/* Signals that no more pads will be added to media decoder.  Here we
+   unblock the media pads, so that their first data dispatches a start
+   lp_Event that will eventually trigger _lp_media_finish_start() and put
+   media in state "started".  If the first segment needs a rate other than
+   1.0 or the segment flag, the pads are unblocked only by the preroll seek
+   (cf. _lp_media_finish_preroll()).  */
+
+static void
+lp_media_no_more_pads_callback (GstElement *dec, lp_Media *media)
+{
+  media_lock (media);
+
+  g_assert (media_state_starting (media));
+  media_trace_instant (media, "no-more-pads", NULL);
+
+  if (unlikely (!media_has_audio (media) && !media_has_video (media)))
+  {
+    lp_EventError *event =
+      _lp_event_error_new_start_no_pads (G_OBJECT(media));
+    g_assert_nonnull (event);
+    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+    goto done;
+  }
+
+  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_ACTIVE));
+  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_BLOCKED));
+
+  if (media_needs_preroll_seek (media))
+  {
+    /* Keep the pads blocked on their first data until the preroll seek
+       sets the rate and loop mode of the first segment.  */
+    media_toggle_prerolling (media);
+    media_post_preroll_seek_unlocked (media);
+  }
+  else
+  {
+    media_toggle_flag_on_all_pads (media, PAD_FLAG_BLOCKED); /* unblock */
+  }
+
+ done:
+  g_signal_handler_disconnect (dec, media->callback.pad_added);
+  g_signal_handler_disconnect (dec, media->callback.no_more_pads);
+  g_signal_handler_disconnect (dec, media->callback.autoplug_continue);
+
+  media_unlock (media);
+}
+
+/* Signals that media decoder has found a new stream, which in this case
+   happens immediately before the decoder starts looking for elements to
+   decode the stream.  Here we check if the stream corresponds to a still
+   image (PNG, JPG, etc.) and, if so, we mark it as frozen.  */
+
+static gboolean
+lp_media_autoplug_continue_callback (arg_unused (GstElement *elt),
+                                     arg_unused (GstPad *pad),
+                                     GstCaps *caps, lp_Media *media)
+{
+  const gchar *name;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  g_assert_nonnull (name);
+
+  if (!g_str_has_prefix (name, "image"))
+    return TRUE;                /* not an image, nothing to do */
+
+  media_lock (media);
+  media_flag_set (media, FLAG_FROZEN); /* freeze */
+  media_unlock (media);
+  return TRUE;
+}
+
+/* Signals that media decoder has drained its source.  Here we start the
+   next media object (if any) at the exact running time where this one
+   ends, and stop the media object (if it is not frozen).  */
+
+static void
+lp_media_drained_callback (GstElement *dec, lp_Media *media)
+{
+  lp_Media *next;
+  GstClockTime boundary = GST_CLOCK_TIME_NONE;
+
+  media_lock (media);
 
   g_signal_handler_disconnect (dec, media->callback.drained);
 
-  if (media_is_frozen (media))
-    goto done;                  /* still image, nothing to do */
+  if (media_is_frozen (media))
+    {
+      media_unlock (media);
+      return;                   /* still image, nothing to do */
+    }
+
+  g_assert (!media_has_drained (media));
+  media_toggle_drained (media); /* drain */
+  media_trace_instant (media, "drained", NULL);
+
+  next = media_ref_next (media);
+  if (next != NULL)
+    {
+      boundary = media_get_end_running_time (media);
+      if (unlikely (!GST_CLOCK_TIME_IS_VALID (boundary)))
+        boundary = _lp_scene_get_offset_last_buffer (media->prop.scene);
+    }
+
+  media_unlock (media);
+
+  if (next != NULL)
+    {
+      media_start_next (next, boundary);
+      g_object_unref (next);
+    }
+
+  lp_media_stop (media);
+}
+
+/* Signals that a media pad has been blocked, which in this case happens
+   immediately after lp_media_stop() is called.  Here we wait until all
+   media pads have been blocked, then we dispatch a stop lp_Event that will
+   eventually trigger _lp_media_finish_stop() and put media in state
+   "stopped".  */
+
+static GstPadProbeReturn
+lp_media_stop_block_probe_callback (GstPad *pad,
+                                    arg_unused (GstPadProbeInfo *info),
+                                    lp_Media *media)
+{
+  GstPad *peer;
+  lp_MediaPadFlag *flags;
+
+  media_lock (media);
+
+  if (unlikely (!media_state_stopping (media)))
+    goto done;                  /* drop residual probes */
+
+  flags = media_get_pad_flags (media, pad);
+  g_assert_nonnull (flags);
+  g_assert (*flags == PAD_FLAG_ACTIVE);
+
+  peer = gst_pad_get_peer (pad);
+  if (peer != NULL)             /* paused audio pads are unlinked */
+    {
+      g_assert (gst_pad_send_event (peer, gst_event_new_eos ()));
+      gst_object_unref (peer);
+    }
+
+  g_assert (gst_pad_set_active (pad, FALSE));
+  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_ACTIVE); /* deactivate */
+
+  if (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_ACTIVE))
+    {
+      lp_EventStop *event;
+      event = _lp_event_stop_new (media, media_has_drained (media));
+      g_assert_nonnull (event);
+      _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+    }
+
+ done:
+  media_unlock (media);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Signals that a media pad has received a flush event, a segment event,
+   or data after being sought.  Here we wait for the first data (buffer,
+   gap, or EOS) that follows the flush on each pad, record the seek
+   latency, and dispatch a seek lp_Event that will eventually trigger
+   _lp_media_finish_seek() and put media back in state "started".
+
+   Data that precedes the flush is passed without locking @media, since
+   the thread that issued the seek may be holding the lock while waiting
+   for the streaming thread to flush.  */
+
+static GstPadProbeReturn
+lp_media_seek_flush_probe_callback (GstPad *pad, GstPadProbeInfo *info,
+                                    lp_Media *media)
+{
+  lp_MediaPadFlag *flags;
+
+  flags = media_get_pad_flags (media, pad);
+  g_assert_nonnull (flags);
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+      if (!media_pad_flag_flushed (*flags))
+        return GST_PAD_PROBE_PASS; /* data from before the flush */
+    }
+  else
+    {
+      GstEvent *evt;
+
+      evt = GST_PAD_PROBE_INFO_EVENT (info);
+      g_assert_nonnull (evt);
+
+      switch (GST_EVENT_TYPE (evt))
+        {
+        case GST_EVENT_FLUSH_STOP:
+          {
+            media_lock (media);
+            g_assert (media_state_seeking (media));
+            g_assert (media_pad_flag_active (*flags));
+            if (!media_pad_flag_flushed (*flags))
+              MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
+            media_unlock (media);
+            return GST_PAD_PROBE_PASS;
+          }
+        case GST_EVENT_SEGMENT:
+          {
+            const GstSegment *segment;
+
+            if (!media_pad_flag_flushed (*flags))
+              return GST_PAD_PROBE_PASS;
+
+            /* Key frame seeks may start the new segment before the
+               requested position.  */
+            media_lock (media);
+            gst_event_parse_segment (evt, &segment);
+            if (media->seek.mode == LP_SEEK_MODE_KEYFRAME
+                && segment->format == GST_FORMAT_TIME
+                && (pad == media->video.pad || !media_has_video (media)))
+              {
+                media->seek.position = (gint64) gst_segment_to_stream_time
+                  (segment, GST_FORMAT_TIME, segment->start);
+              }
+            media_unlock (media);
+            return GST_PAD_PROBE_PASS;
+          }
+        case GST_EVENT_GAP:     /* fall through */
+        case GST_EVENT_EOS:
+          {
+            if (!media_pad_flag_flushed (*flags))
+              return GST_PAD_PROBE_PASS;
+            break;
+          }
+        default:
+          {
+            return GST_PAD_PROBE_PASS; /* nothing to do */
+          }
+        }
+    }
+
+  media_lock (media);
+
+  g_assert (media_state_seeking (media));
+  if (!GST_CLOCK_TIME_IS_VALID (media->seek.latency))
+    media->seek.latency = gst_util_get_timestamp () - media->seek.start;
+
+  g_assert (media->seek.waiting > 0);
+  if (--media->seek.waiting == 0)
+    {
+      lp_EventSeek *event = _lp_event_seek_new (media, media->seek.relative,
+                                                media->seek.last,
+                                                media->seek.mode,
+                                                media->seek.latency);
+      g_assert_nonnull (event);
+      _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+    }
+
+  media_unlock (media);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Seeks @media to stream position @abs using seek @mode (which cannot be
+   refine) and sets its playback rate to the value of property "rate".  If
+   the rate is not 1.0, makes sure that the audio graph contains the audio
+   tempo before the new segment reaches it.  Media must be locked.  Returns
+   %TRUE if successful, or %FALSE otherwise.  */
+
+static gboolean
+media_seek_to_unlocked (lp_Media *media, gint64 abs, lp_SeekMode mode)
+{
+  gulong id_audio;
+  gulong id_video;
+  guint64 now;
+  gint flags;
+  gboolean status;
+
+  g_assert (media_state_started (media));
+  g_assert (abs >= 0);
+
+  if (media_has_audio (media)
+      && (media->prop.rate != 1.0) != (media->audio.tempo != NULL))
+    {
+      GstPad *pad;
+
+      /* The probe id is zero if the probe has been called immediately.  */
+      pad = media_get_audio_tail_pad (media);
+      g_assert_nonnull (pad);
+      gst_pad_add_probe
+        (pad, GST_PAD_PROBE_TYPE_IDLE,
+         (GstPadProbeCallback) lp_media_tempo_idle_probe_callback,
+         media, NULL);
+      gst_object_unref (pad);
+    }
+
+  flags = 0
+    | GST_SEEK_FLAG_FLUSH       /* flush bin */
+    | GST_SEEK_FLAG_TRICKMODE;  /* decode only key frames */
+
+  if (media->prop.loop)
+    flags |= GST_SEEK_FLAG_SEGMENT; /* end with segment-done, not EOS */
+
+  switch (mode)
+    {
+    case LP_SEEK_MODE_ACCURATE:
+      flags |= GST_SEEK_FLAG_ACCURATE; /* be accurate */
+      break;
+    case LP_SEEK_MODE_KEYFRAME:
+      flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  media_set_state (media, SEEKING);
+  media->seek.mode = mode;
+  media->seek.internal = FALSE;
+  media->seek.waiting = media_install_probe
+    (media, (GstPadProbeType)(GST_PAD_PROBE_TYPE_EVENT_FLUSH
+                              | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM
+                              | GST_PAD_PROBE_TYPE_BUFFER),
+     (GstPadProbeCallback) lp_media_seek_flush_probe_callback,
+     &id_audio, &id_video);
+  media->seek.start = gst_util_get_timestamp ();
+  media->seek.latency = GST_CLOCK_TIME_NONE;
+
+  now = _lp_scene_get_running_time (media->prop.scene);
+  g_assert (GST_CLOCK_TIME_IS_VALID (now));
+
+  _lp_debug ("\n\
+seek (%s) %p\n\
+  now: %" GST_TIME_FORMAT "\n\
+  abs: %" GST_TIME_FORMAT "\n\
+  rate: %g\n",
+             mode == LP_SEEK_MODE_KEYFRAME ? "keyframe" : "accurate",
+             media,
+             GST_TIME_ARGS (now),
+             GST_TIME_ARGS (abs),
+             media->prop.rate);
+
+  status = gst_element_seek (media->bin, media->prop.rate, GST_FORMAT_TIME,
+                             (GstSeekFlags) flags,
+                             GST_SEEK_TYPE_SET, abs,
+                             GST_SEEK_TYPE_NONE, 0);
+  if (unlikely (!status))
+    {
+      if (media_has_audio (media))
+        gst_pad_remove_probe (media->audio.pad, id_audio);
+      if (media_has_video (media))
+        gst_pad_remove_probe (media->video.pad, id_video);
+      media->seek.waiting = 0;
+      media_set_state (media, STARTED);
+      return FALSE;
+    }
+
+  /* Update the segment data only in case of success.  */
+  media->seek.base = now;
+  media->seek.position = abs;
+  media->seek.rate = media->prop.rate;
+  media->seek.segment = media->prop.loop;
+
+  if (media_has_audio (media))
+    gst_pad_set_offset (media->audio.pad, now);
+  if (media_has_video (media))
+    gst_pad_set_offset (media->video.pad, now);
+
+  return TRUE;
+}
+
+/* Seeks in @media by @offset (cf. lp_media_seek()) using seek @mode.
+   Media must be locked.  Returns %TRUE if successful, or %FALSE
+   otherwise.  */
+
+static gboolean
+media_seek_unlocked (lp_Media *media, gboolean relative, gint64 offset,
+                     lp_SeekMode mode)
+{
+  GstQuery *query;
+  gboolean seekable;
+  gint64 duration;
+  guint64 now;
+  gint64 pos;
+  gint64 abs;
+
+  if (unlikely (!media_state_started (media)))
+    return FALSE;               /* nothing to do */
+
+  if (unlikely (media->decoder == NULL))
+    return FALSE;               /* cached image, not seekable */
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  g_assert_nonnull (query);
+  if (unlikely (!gst_element_query (media->decoder, query)))
+    {
+      gst_query_unref (query);
+      return FALSE;             /* not seekable */
+    }
+
+  seekable = FALSE;
+  gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  if (unlikely (!seekable))
+    return FALSE;               /* not seekable */
+
+  duration = GST_CLOCK_TIME_NONE;
+  if (!relative && offset < 0.0) /* resolve duration */
+    {
+      query = gst_query_new_duration (GST_FORMAT_TIME);
+      g_assert_nonnull (query);
+      if (unlikely (!gst_element_query (media->decoder, query)))
+        {
+          gst_query_unref (query);
+          return FALSE;
+        }
+      gst_query_parse_duration (query, NULL, &duration);
+      gst_query_unref (query);
+    }
+
+  now = _lp_scene_get_running_time (media->prop.scene);
+  g_assert (GST_CLOCK_TIME_IS_VALID (now));
+  pos = media_get_stream_position (media, now);
+
+  if (relative)                 /* offset is relative */
+  {
+    abs = max (pos + offset, 0);
+  }
+  else                          /* offset is absolute */
+  {
+    if (offset < 0)
+      {
+        g_assert (GST_CLOCK_STIME_IS_VALID (duration));
+        offset = duration + offset;
+      }
+    abs = max (offset, 0);
+  }
+
+  if (unlikely (!media_seek_to_unlocked
+                (media, abs, (mode == LP_SEEK_MODE_REFINE)
+                 ? LP_SEEK_MODE_KEYFRAME : mode)))
+    {
+      return FALSE;
+    }
+
+  media->seek.relative = relative; /* last seek type */
+  media->seek.last = offset;       /* last seek offset */
+  media->seek.target = abs;
+  media->seek.refine = (mode == LP_SEEK_MODE_REFINE);
+
+  return TRUE;
+}
+
+/* Applies the values of properties "rate" and "loop" to @media, if they
+   differ from those of its current segment, by an accurate seek to the
+   current position.  The seek is internal: no seek lp_Event is dispatched
+   for it.  Media must be started and locked.  Returns %TRUE if successful
+   or if there is nothing to do, or %FALSE otherwise.  */
+
+static gboolean
+media_update_segment_unlocked (lp_Media *media)
+{
+  guint64 now;
+
+  g_assert (media_state_started (media));
+
+  /* A looping segment whose loop mode is turned off needs no seek: it
+     drains when it ends (cf. media_restart_segment_unlocked()).  */
+  if (media->prop.rate == media->seek.rate
+      && (media->prop.loop == media->seek.segment || !media->prop.loop))
+    return TRUE;                /* nothing to do */
+
+  if (media_is_frozen (media))
+    return TRUE;                /* still image, nothing to do */
+
+  now = _lp_scene_get_running_time (media->prop.scene);
+  g_assert (GST_CLOCK_TIME_IS_VALID (now));
+  if (unlikely (!media_seek_to_unlocked
+                (media, max (media_get_stream_position (media, now), 0),
+                 LP_SEEK_MODE_ACCURATE)))
+    {
+      _lp_warn ("cannot change rate or loop mode of %p", media);
+      return FALSE;
+    }
+
+  media->seek.internal = TRUE;
+  return TRUE;
+}
+
+/* Starts @media (cf. lp_media_start()).  If @standby is %TRUE, prerolls
+   @media and keeps its pads blocked on their first data until it is
+   released by media_release_standby_unlocked().  Media must be locked.
+   Returns %TRUE if successful, or %FALSE otherwise.  */
+
+static gboolean
+media_start_unlocked (lp_Media *media, gboolean standby)
+{
+  GstElement *pipeline;
+  gboolean is_started = FALSE;
+
+  if (unlikely (!media_state_stopped (media)))
+    goto fail;                  /* nothing to do */
+
+  if (standby && (media->prop.uri == NULL
+                  || g_str_has_prefix (media->prop.uri, "data:")))
+    goto fail;                  /* nothing to preroll */
+
+  if (media->prop.uri == NULL &&
+      media->prop.width > 0 &&
+      media->prop.height > 0)
+  {
+    /* push transparent buffer */
+    GstCaps *caps = NULL;
 
-  g_assert (!media_has_drained (media));
-  media_toggle_drained (media); /* drain */
-  lp_media_stop (media);
+    const gstx_eltmap_t lp_media_appsrc_eltmap[] = {
+      {"bin",           offsetof (lp_Media, bin)},
+      {"appsrc",        offsetof (lp_Media, source)},
+      {"videoconvert",  offsetof (lp_Media, decoder)},
+      {NULL, 0},
+    };
 
- done:
-  media_unlock (media);
-}
+    _lp_eltmap_alloc_check (media, lp_media_appsrc_eltmap);
 
-/* Signals that a media pad has been blocked, which in this case happens
-   immediately after lp_media_stop() is called.  Here we wait until all
-   media pads have been blocked, then we dispatch a stop lp_Event that will
-   eventually trigger _lp_media_finish_stop() and put media in state
-   "stopped".  */
+    gstx_bin_add (media->bin, media->source);
+    gstx_bin_add (media->bin, media->decoder);
 
-static GstPadProbeReturn
-lp_media_stop_block_probe_callback (GstPad *pad,
-                                    arg_unused (GstPadProbeInfo *info),
-                                    lp_Media *media)
-{
-  GstPad *peer;
-  lp_MediaPadFlag *flags;
+    caps = gst_caps_new_simple ("video/x-raw",
+        "format", G_TYPE_STRING, "ARGB",
+        "width", G_TYPE_INT, media->prop.width,
+        "height", G_TYPE_INT, media->prop.height,
+        "framerate", GST_TYPE_FRACTION, 30, 1,
+        "pixel-aspect-ration", GST_TYPE_FRACTION, 1,1,
+        NULL);
+    g_object_set (media->source,
+        "caps", caps,
+        "format", GST_FORMAT_TIME,
+        "stream-type", 0,
+        NULL);
 
-  media_lock (media);
+    gst_app_src_set_caps(GST_APP_SRC(media->source), caps);
 
-  if (unlikely (!media_state_stopping (media)))
-    goto done;                  /* drop residual probes */
+    g_signal_connect (media->source, "need-data",
+        G_CALLBACK (_lp_common_appsrc_transparent_data), media);
 
-  flags = media_get_pad_flags (media, pad);
-  g_assert_nonnull (flags);
-  g_assert (*flags == PAD_FLAG_ACTIVE);
+    g_assert (gst_element_link (media->source, media->decoder));
 
-  peer = gst_pad_get_peer (pad);
-  g_assert_nonnull (peer);
-  g_assert (gst_pad_send_event (peer, gst_event_new_eos ()));
-  gst_object_unref (peer);
+    is_started = TRUE;
+    goto sourceok;
+  }
 
-  g_assert (gst_pad_set_active (pad, FALSE));
-  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_ACTIVE); /* deactivate */
+  if (gst_uri_is_valid (media->prop.uri))
+  {
+    gboolean ok = TRUE;
+    char *urischeme = gst_uri_get_protocol (media->prop.uri);
+    if (g_str_equal ("data", urischeme))
+    {
+      /* URI is: data://<...>  */
+      char *tmp = media->prop.uri + 4;
+      char *endptr = NULL;
 
-  if (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_ACTIVE))
+      if (!tmp || *tmp != ':')
+        ok = FALSE;
+      else
+      {
+        while (*(++tmp))
+        {
+          if (*tmp == ',')
+          {
+            endptr = tmp;
+            break;
+          }
+        }
+      }
+
+      if (endptr != NULL)
+      {
+        char *type;
+        tmp = media->prop.uri + 5;
+        type = g_strndup (tmp, endptr - tmp);
+
+        /* If type isn't specified, the default is text */
+        if (strlen (type) == 0 || g_str_has_prefix(type, "text"))
+        {
+          char *text = (endptr + 1);
+          g_object_set (media, "text", text, NULL);
+
+          media_flag_set (media, FLAG_TEXT);
+        }
+        g_free (type);
+      }
+      else
+        ok = FALSE;
+    }
+    else
+      media->prop.final_uri = g_strdup (media->prop.uri);
+
+    g_free (urischeme);
+    if (!ok)
+      goto fail;
+  }
+  else
+  {
+    GError *error = NULL;
+    gchar *final_uri = gst_filename_to_uri (media->prop.uri, &error);
+    if (unlikely (final_uri == NULL))
     {
-      lp_EventStop *event;
-      event = _lp_event_stop_new (media, media_has_drained (media));
-      g_assert_nonnull (event);
-      _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+      _lp_warn ("bad URI: %s", media->prop.uri);
+      g_error_free (error);
+      goto fail;
     }
+    media->prop.final_uri = final_uri;
+  }
 
- done:
-  media_unlock (media);
+  if (!standby                 /* cached frames cannot be held back */
+      && media->prop.final_uri != NULL
+      && _lp_scene_has_video (media->prop.scene)
+      && media_setup_cached_image (media))
+  {
+    is_started = TRUE;          /* still image, no need to decode it */
+    goto sourceok;
+  }
 
-  return GST_PAD_PROBE_OK;
-}
+  _lp_eltmap_alloc_check (media, lp_media_eltmap);
+  {
+    gchar *uri = _lp_mmap_src_get_uri (media->prop.final_uri);
+    g_object_set (media->decoder, "uri", uri, NULL);
+    g_free (uri);
+  }
+  gstx_bin_add (media->bin, media->decoder);
 
-/* Signals that a media pad has received a flush event, which in this case
-   happens after the pad has been sought.  Here we dispatch a seek lp_Event
-   that will eventually trigger _lp_media_finish_seek() and put media back
-   in state "started".  */
+  if (media_has_demux_limits (media))
+  {
+    /* The byte and time limits also apply to the queue that uridecodebin
+       inserts after network sources.  */
+    g_object_set (media->decoder, "use-buffering", TRUE, NULL);
+    if (media->prop.demux_max_bytes > 0)
+      g_object_set (media->decoder, "buffer-size",
+                    (gint) min (media->prop.demux_max_bytes, G_MAXINT), NULL);
+    if (media->prop.demux_max_time > 0)
+      g_object_set (media->decoder, "buffer-duration",
+                    (gint64) media->prop.demux_max_time, NULL);
+
+    media->callback.element_added = g_signal_connect
+      (media->decoder, "element-added", /* GstBin */
+       G_CALLBACK (lp_media_element_added_callback), media);
+    g_assert (media->callback.element_added > 0);
+  }
 
-static GstPadProbeReturn
-lp_media_seek_flush_probe_callback (GstPad *pad, GstPadProbeInfo *info,
-                                    lp_Media *media)
-{
-  lp_MediaPadFlag *flags;
-  GstEvent *evt;
+  media->callback.pad_added = g_signal_connect
+    (media->decoder, "pad-added", /* GstElement */
+     G_CALLBACK (lp_media_pad_added_callback), media);
+  g_assert (media->callback.pad_added > 0);
 
-  media_unlock (media);
+  media->callback.no_more_pads = g_signal_connect
+    (media->decoder, "no-more-pads", /* GstElement */
+     G_CALLBACK (lp_media_no_more_pads_callback), media);
+  g_assert (media->callback.no_more_pads);
 
-  g_assert (media_state_seeking (media));
+  media->callback.autoplug_continue = g_signal_connect
+    (media->decoder, "autoplug-continue", /* GstURIDecodeBin */
+     G_CALLBACK (lp_media_autoplug_continue_callback), media);
+  g_assert (media->callback.autoplug_continue > 0);
 
-  flags = media_get_pad_flags (media, pad);
-  g_assert_nonnull (flags);
-  g_assert (media_pad_flag_active (*flags));
+  media->callback.drained = g_signal_connect
+    (media->decoder, "drained", /* GstURIDecodeBin */
+     G_CALLBACK (lp_media_drained_callback), media);
+  g_assert (media->callback.drained > 0);
 
-  evt = GST_PAD_PROBE_INFO_EVENT (info);
-  g_assert_nonnull (evt);
+sourceok:
+  g_object_set_data (G_OBJECT (media->bin), "lp_Media", media);
 
-  if (GST_EVENT_TYPE (evt) != GST_EVENT_FLUSH_STOP)
-    goto pass;                  /* nothing to do  */
+  pipeline = _lp_scene_get_pipeline (media->prop.scene);
+  g_assert_nonnull (pipeline);
+  gstx_bin_add (pipeline, media->bin);
+  g_assert (gst_object_ref (media->bin) == media->bin);
 
-  if (media_pad_flag_flushed (*flags))
-    goto remove;                /* drop residual probes */
+  media_set_state (media, STARTING);
+  if (standby)
+    media_flag_set (media, FLAG_STANDBY);
 
-  MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
-  g_assert (media_state_seeking (media));
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
+  /* To properly synchronize multiple media objects we need to save the
+   * offset at this point */
+  media->offset = _lp_scene_get_offset_last_buffer (media->prop.scene);
+  g_assert (GST_CLOCK_TIME_IS_VALID (media->offset));
+  media->seek.base = media->offset;
+
+  if (unlikely (!gst_element_sync_state_with_parent (media->bin)))
+  {
+    gstx_element_set_state_sync (media->bin, GST_STATE_NULL);
+    gstx_bin_remove (pipeline, media->bin);
+    media_set_state (media, STOPPED);
+    media_release_run_time_data (media);
+    goto fail;
+  }
+
+  if (is_started)
+  {
+    GstPad *pad = NULL;
+    GstPad *ghost = NULL;
+    lp_EventStart *event = NULL;
+    lp_MediaPadFlag *flags = NULL;
+
+    pad = gst_element_get_static_pad
+      ((media->decoder != NULL) ? media->decoder : media->source, "src");
+    ghost = _lp_media_configure_video_bin (media, pad);
+    g_assert_nonnull (ghost);
+    gst_object_unref (pad);
+
+    flags = media_get_pad_flags (media, ghost);
+    g_assert_nonnull (flags);
+    g_assert (media_pad_flag_active (*flags));
+    MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
 
-  if (media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED))
+    if (media->cache.frame != NULL) /* push cached frame */
     {
-      lp_EventSeek *event = _lp_event_seek_new (media, media->seek.relative,
-                                                media->seek.last);
-      g_assert_nonnull (event);
-      _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+      GstAppSrc *appsrc = GST_APP_SRC (media->source);
+
+      gst_pad_set_offset (ghost, (gint64) media->offset);
+      g_assert (gst_app_src_push_buffer (appsrc, media->cache.frame)
+                == GST_FLOW_OK);
+      media->cache.frame = NULL; /* transfer-full */
+      g_assert (gst_app_src_end_of_stream (appsrc) == GST_FLOW_OK);
     }
 
- remove:
-  media_unlock (media);
-  return GST_PAD_PROBE_REMOVE;
+    event = _lp_event_start_new (G_OBJECT(media), FALSE);
+    g_assert_nonnull (event);
+    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+    media->linked_pads++;
+  }
 
- pass:
-  media_unlock (media);
-  return GST_PAD_PROBE_PASS;
+  /* if (media->prop.sync) */
+  /* { */
+  /*   _lp_scene_iterate_loop_until (media->prop.scene, */
+  /*       (gboolean (*)(gpointer)) lp_media_has_started, media); */
+  /* } */
+
+  _lp_debug ("%p offset: %lu\n", media, media->offset);
+
+  return TRUE;
+
+ fail:
+  return FALSE;
 }
 
 
@@ -1000,8 +3001,11 @@ static void
 lp_media_init (lp_Media *media)
 {
   g_rec_mutex_init (&media->mutex);
+  media->counted = FALSE;
   media_reset_run_time_data (media);
   media_reset_property_cache (media);
+  gx_seqlock_init (&media->pub.seq);
+  media_publish (media);
 }
 
 static void
@@ -1009,8 +3013,41 @@ lp_media_get_property (GObject *object, guint prop_id,
                        GValue *value, GParamSpec *pspec)
 {
   lp_Media *media;
+  gint n;
+  gdouble d;
 
   media = LP_MEDIA (object);
+
+  switch (prop_id)              /* published, don't take the lock */
+    {
+    case PROP_X:
+      gx_seqlock_read (&media->pub.seq, n, media->pub.x);
+      g_value_set_int (value, n);
+      return;
+    case PROP_Y:
+      gx_seqlock_read (&media->pub.seq, n, media->pub.y);
+      g_value_set_int (value, n);
+      return;
+    case PROP_Z:
+      gx_seqlock_read (&media->pub.seq, n, media->pub.z);
+      g_value_set_int (value, n);
+      return;
+    case PROP_WIDTH:
+      gx_seqlock_read (&media->pub.seq, n, media->pub.width);
+      g_value_set_int (value, n);
+      return;
+    case PROP_HEIGHT:
+      gx_seqlock_read (&media->pub.seq, n, media->pub.height);
+      g_value_set_int (value, n);
+      return;
+    case PROP_ALPHA:
+      gx_seqlock_read (&media->pub.seq, d, media->pub.alpha);
+      g_value_set_double (value, d);
+      return;
+    default:
+      break;
+    }
+
   media_lock (media);
 
   switch (prop_id)
@@ -1019,28 +3056,10 @@ lp_media_get_property (GObject *object, guint prop_id,
       g_value_take_object (value, media->prop.scene);
       break;
     case PROP_URI:
-      g_value_set_string (value, media->prop.uri);
-      break;
-    case PROP_FINAL_URI:
-      g_value_set_string (value, media->prop.final_uri);
-      break;
-    case PROP_X:
-      g_value_set_int (value, media->prop.x);
-      break;
-    case PROP_Y:
-      g_value_set_int (value, media->prop.y);
-      break;
-    case PROP_Z:
-      g_value_set_int (value, media->prop.z);
-      break;
-    case PROP_WIDTH:
-      g_value_set_int (value, media->prop.width);
-      break;
-    case PROP_HEIGHT:
-      g_value_set_int (value, media->prop.height);
+      g_value_set_string (value, media->prop.uri);
       break;
-    case PROP_ALPHA:
-      g_value_set_double (value, media->prop.alpha);
+    case PROP_FINAL_URI:
+      g_value_set_string (value, media->prop.final_uri);
       break;
     case PROP_MUTE:
       g_value_set_boolean (value, media->prop.mute);
@@ -1072,6 +3091,80 @@ lp_media_get_property (GObject *object, guint prop_id,
     case PROP_SYNCHRONOUS:
       g_value_set_boolean (value, media->prop.sync);
       break;
+    case PROP_RATE:
+      g_value_set_double (value, media->prop.rate);
+      break;
+    case PROP_SEEK_MODE:
+      g_value_set_int (value, media->prop.seek_mode);
+      break;
+    case PROP_LOOP:
+      g_value_set_boolean (value, media->prop.loop);
+      break;
+    case PROP_NEXT:
+      g_value_set_object (value, media->prop.next);
+      break;
+    case PROP_DEMUX_MAX_BYTES:
+      g_value_set_uint (value, media->prop.demux_max_bytes);
+      break;
+    case PROP_DEMUX_MAX_BUFFERS:
+      g_value_set_uint (value, media->prop.demux_max_buffers);
+      break;
+    case PROP_DEMUX_MAX_TIME:
+      g_value_set_uint64 (value, media->prop.demux_max_time);
+      break;
+    case PROP_DECODE_MAX_BYTES:
+      g_value_set_uint (value, media->prop.decode_max_bytes);
+      break;
+    case PROP_DECODE_MAX_BUFFERS:
+      g_value_set_uint (value, media->prop.decode_max_buffers);
+      break;
+    case PROP_DECODE_MAX_TIME:
+      g_value_set_uint64 (value, media->prop.decode_max_time);
+      break;
+    case PROP_BUFFERING:
+      g_value_set_int (value, media->buffering);
+      break;
+    case PROP_DECODE_LEVEL_BYTES:
+      g_value_set_uint (value, (guint) media_get_decode_level
+                        (media, "current-level-bytes"));
+      break;
+    case PROP_DECODE_LEVEL_BUFFERS:
+      g_value_set_uint (value, (guint) media_get_decode_level
+                        (media, "current-level-buffers"));
+      break;
+    case PROP_DECODE_LEVEL_TIME:
+      g_value_set_uint64 (value, media_get_decode_level
+                          (media, "current-level-time"));
+      break;
+    case PROP_FRAMES_PROCESSED:  /* fall through */
+    case PROP_FRAMES_DROPPED:    /* fall through */
+    case PROP_FRAMES_LATE:       /* fall through */
+    case PROP_AVERAGE_LATENESS:
+      {
+        guint64 late;
+
+        switch (prop_id)
+          {
+          case PROP_FRAMES_PROCESSED:
+            g_value_set_uint64 (value, media_qos_get (media, processed));
+            break;
+          case PROP_FRAMES_DROPPED:
+            g_value_set_uint64 (value, media_qos_get (media, dropped));
+            break;
+          case PROP_FRAMES_LATE:
+            g_value_set_uint64 (value, media_qos_get (media, late));
+            break;
+          case PROP_AVERAGE_LATENESS:
+            late = media_qos_get (media, late);
+            g_value_set_uint64 (value, (late > 0)
+                                ? media_qos_get_lateness (media) / late
+                                : 0);
+            break;
+          default:
+            g_assert_not_reached ();
+          }
+        break;
+      }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -1084,10 +3177,13 @@ lp_media_set_property (GObject *object, guint prop_id,
                        const GValue *value, GParamSpec *pspec)
 {
   lp_Media *media;
+  lp_Media *preroll = NULL;
+  gboolean rebalance;
 
   media = LP_MEDIA (object);
   media_lock (media);
 
+  rebalance = FALSE;
   switch (prop_id)
     {
     case PROP_SCENE:            /* don't take ownership */
@@ -1149,19 +3245,90 @@ lp_media_set_property (GObject *object, guint prop_id,
     case PROP_SYNCHRONOUS:
       media->prop.sync = g_value_get_boolean (value);
       break;
+    case PROP_RATE:
+      media->prop.rate = g_value_get_double (value);
+      break;
+    case PROP_SEEK_MODE:
+      media->prop.seek_mode = (lp_SeekMode) g_value_get_int (value);
+      break;
+    case PROP_LOOP:
+      media->prop.loop = g_value_get_boolean (value);
+      break;
+    case PROP_NEXT:
+      {
+        lp_Media *next;
+
+        next = (lp_Media *) g_value_get_object (value);
+        if (unlikely (next != NULL
+                      && next->prop.scene != media->prop.scene))
+          {
+            _lp_warn ("bad next media %p", next);
+            goto done;
+          }
+
+        G_LOCK (next_links);
+        if (unlikely (media_next_makes_cycle (media, next)))
+          {
+            G_UNLOCK (next_links);
+            _lp_warn ("next media %p would make a cycle", next);
+            goto done;
+          }
+        media->prop.next = next; /* not ref'ed; owned by scene */
+        G_UNLOCK (next_links);
+        break;
+      }
+    case PROP_DEMUX_MAX_BYTES:
+      media->prop.demux_max_bytes = g_value_get_uint (value);
+      break;
+    case PROP_DEMUX_MAX_BUFFERS:
+      media->prop.demux_max_buffers = g_value_get_uint (value);
+      break;
+    case PROP_DEMUX_MAX_TIME:
+      media->prop.demux_max_time = g_value_get_uint64 (value);
+      break;
+    case PROP_DECODE_MAX_BYTES:
+      media->prop.decode_max_bytes = g_value_get_uint (value);
+      break;
+    case PROP_DECODE_MAX_BUFFERS:
+      media->prop.decode_max_buffers = g_value_get_uint (value);
+      break;
+    case PROP_DECODE_MAX_TIME:
+      media->prop.decode_max_time = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
 
+  media_publish (media);
+
   if (!media_state_started (media))
     goto done;                  /* nothing to do */
 
+  /* Displayed area changed, so does the thread share.  */
+  rebalance = prop_id == PROP_WIDTH || prop_id == PROP_HEIGHT;
+
   switch (prop_id)
     {
     case PROP_SCENE:            /* fall through */
-    case PROP_URI:
+    case PROP_URI:              /* fall through */
+    case PROP_SEEK_MODE:        /* fall through */
+    case PROP_DEMUX_MAX_BYTES:  /* fall through */
+    case PROP_DEMUX_MAX_BUFFERS: /* fall through */
+    case PROP_DEMUX_MAX_TIME:
       {
-        break;                  /* nothing to do */
+        break;                  /* nothing to do; applied on start */
+      }
+    case PROP_DECODE_MAX_BYTES:   /* fall through */
+    case PROP_DECODE_MAX_BUFFERS: /* fall through */
+    case PROP_DECODE_MAX_TIME:
+      {
+        /* Queues are inserted only on start; existing ones are updated
+           in place.  */
+        if (media->audio.queue != NULL)
+          media_setup_decode_queue (media, media->audio.queue);
+        if (media->video.queue != NULL)
+          media_setup_decode_queue (media, media->video.queue);
+        break;
       }
     case PROP_X:                /* fall through */
     case PROP_Y:                /* fall through */
@@ -1179,7 +3346,8 @@ lp_media_set_property (GObject *object, guint prop_id,
           break;                /* nothing to do */
 
         sink = gst_pad_get_peer (media->video.pad);
-        g_assert_nonnull (sink);
+        if (sink == NULL)
+          break;                /* in standby; applied on release */
 
         switch (prop_id)
           {
@@ -1212,38 +3380,16 @@ lp_media_set_property (GObject *object, guint prop_id,
     case PROP_TEXT_COLOR:       /* fall through */
     case PROP_TEXT_FONT:
       {
-        GstElement *text;
-
         if (!_lp_scene_has_video (media->prop.scene))
           break;                /* nothing to do */
 
         if (!media_has_video (media))
           break;                /* nothing to do */
 
-        text = media->video.text;
-        g_assert_nonnull (text);
-
-        switch (prop_id)
-          {
-          case PROP_TEXT:
-            {
-              g_object_set (text, "text", media->prop.text, NULL);
-              break;
-            }
-          case PROP_TEXT_COLOR:
-            {
-              g_object_set (text, "color", media->prop.text_color, NULL);
-              break;
-            }
-          case PROP_TEXT_FONT:
-            {
-              char *font = media->prop.text_font;
-              g_object_set (text, "font-desc", (font) ? font : "", NULL);
-              break;
-            }
-          default:
-            g_assert_not_reached ();
-          }
+        if (media_video_filters_outdated (media))
+          media_replug_video_filters_unlocked (media);
+        else if (media->video.text != NULL)
+          media_update_video_text (media);
         break;
       }
     case PROP_MUTE:             /* fall through */
@@ -1255,7 +3401,8 @@ lp_media_set_property (GObject *object, guint prop_id,
           break;                /* nothing to do */
 
         sink = gst_pad_get_peer (media->audio.pad);
-        g_assert_nonnull (sink);
+        if (sink == NULL)
+          break;                /* in standby or paused; applied later */
 
         switch (prop_id)
           {
@@ -1282,13 +3429,24 @@ lp_media_set_property (GObject *object, guint prop_id,
         if (!media_has_video (media))
           break;                /* nothing to do */
 
-        g_object_set (media->video.crop,
-            "top", (gint) (media->prop.crop_top * media->prop.height),
-            "left", (gint) (media->prop.crop_left * media->prop.width),
-            "right", (gint) (media->prop.crop_right * media->prop.width),
-            "bottom", (gint) (media->prop.crop_bottom * media->prop.height),
-            NULL);
-
+        if (media_video_filters_outdated (media))
+          media_replug_video_filters_unlocked (media);
+        else if (media->video.crop != NULL)
+          media_update_video_crop (media);
+        break;
+      }
+    case PROP_RATE:             /* fall through */
+    case PROP_LOOP:
+      {
+        /* Rate and segment seeks are changed by a seek to the current
+           position.  Changes made while @media is seeking or paused are
+           applied when it is started again.  */
+        media_update_segment_unlocked (media);
+        break;
+      }
+    case PROP_NEXT:
+      {
+        preroll = media_ref_next (media); /* prerolled after unlock */
         break;
       }
     default:
@@ -1297,6 +3455,15 @@ lp_media_set_property (GObject *object, guint prop_id,
 
  done:
   media_unlock (media);
+
+  if (preroll != NULL)
+    {
+      media_preroll_next (preroll);
+      g_object_unref (preroll);
+    }
+
+  if (rebalance)
+    _lp_scene_rebalance_threads (media->prop.scene);
 }
 
 static void
@@ -1313,7 +3480,12 @@ lp_media_constructed (GObject *object)
   media_unlock (media);
 
   g_assert (LP_IS_SCENE (scene));
-  _lp_scene_add_media (scene, media);
+  if (_lp_scene_add_media (scene, media))
+    {
+      media_lock (media);
+      media->counted = TRUE;    /* counted as stopped by scene */
+      media_unlock (media);
+    }
 }
 
 static void
@@ -1342,7 +3514,7 @@ lp_media_dispose (GObject *object)
 
   /* g_assert (media_state_stopped (media)); */
   media_release_property_cache (media);
-  media->state = DISPOSED;
+  media_set_state (media, DISPOSED);
   media_unlock (media);
 
   G_OBJECT_CLASS (lp_media_parent_class)->dispose (object);
@@ -1484,6 +3656,127 @@ lp_media_class_init (lp_MediaClass *cls)
      ("sync", "synchronous mode", "activate synchronous mode",
       DEFAULT_SYNCHRONOUS,
       (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_RATE, g_param_spec_double
+     ("rate", "rate", "playback rate",
+      0.01, 100.0, DEFAULT_RATE,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_SEEK_MODE, g_param_spec_int
+     ("seek-mode", "seek mode", "mode of subsequent seeks",
+      0, LP_SEEK_MODE_LAST - 1, DEFAULT_SEEK_MODE,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_LOOP, g_param_spec_boolean
+     ("loop", "loop", "restart playback seamlessly when media ends",
+      DEFAULT_LOOP,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_NEXT, g_param_spec_object
+     ("next", "next", "media to start seamlessly when media ends",
+      LP_TYPE_MEDIA,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DEMUX_MAX_BYTES, g_param_spec_uint
+     ("demux-max-bytes", "demux max bytes",
+      "max bytes in demux queue (0=automatic)",
+      0, G_MAXUINT, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DEMUX_MAX_BUFFERS, g_param_spec_uint
+     ("demux-max-buffers", "demux max buffers",
+      "max buffers in demux queue (0=automatic)",
+      0, G_MAXUINT, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DEMUX_MAX_TIME, g_param_spec_uint64
+     ("demux-max-time", "demux max time",
+      "max time in demux queue (in nanoseconds, 0=automatic)",
+      0, G_MAXUINT64, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_MAX_BYTES, g_param_spec_uint
+     ("decode-max-bytes", "decode max bytes",
+      "max bytes in decode queue (0=no queue)",
+      0, G_MAXUINT, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_MAX_BUFFERS, g_param_spec_uint
+     ("decode-max-buffers", "decode max buffers",
+      "max buffers in decode queue (0=no queue)",
+      0, G_MAXUINT, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_MAX_TIME, g_param_spec_uint64
+     ("decode-max-time", "decode max time",
+      "max time in decode queue (in nanoseconds, 0=no queue)",
+      0, G_MAXUINT64, DEFAULT_QUEUE_LIMIT,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_BUFFERING, g_param_spec_int
+     ("buffering", "buffering", "buffering level (in percent)",
+      0, 100, 100,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_LEVEL_BYTES, g_param_spec_uint
+     ("decode-level-bytes", "decode level bytes",
+      "current bytes in decode queues",
+      0, G_MAXUINT, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_LEVEL_BUFFERS, g_param_spec_uint
+     ("decode-level-buffers", "decode level buffers",
+      "current buffers in decode queues",
+      0, G_MAXUINT, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_DECODE_LEVEL_TIME, g_param_spec_uint64
+     ("decode-level-time", "decode level time",
+      "current time in decode queues (in nanoseconds)",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_FRAMES_PROCESSED, g_param_spec_uint64
+     ("frames-processed", "frames processed",
+      "number of video frames pushed to the scene",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_FRAMES_DROPPED, g_param_spec_uint64
+     ("frames-dropped", "frames dropped",
+      "number of video frames dropped by decoders",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_FRAMES_LATE, g_param_spec_uint64
+     ("frames-late", "frames late",
+      "number of video frames reported late by the scene",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE));
+
+  g_object_class_install_property
+    (gobject_class, PROP_AVERAGE_LATENESS, g_param_spec_uint64
+     ("average-lateness", "average lateness",
+      "average lateness of late video frames (in nanoseconds)",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE));
 }
 
 
@@ -1525,7 +3818,7 @@ _lp_media_finish_error (lp_Media *media)
 {
   media_lock (media);
 
-  media->state = STOPPING;
+  media_set_state (media, STOPPING);
   _lp_media_finish_stop (media);
 
   media_unlock (media);
@@ -1536,6 +3829,8 @@ _lp_media_finish_error (lp_Media *media)
 void
 _lp_media_finish_start (lp_Media *media)
 {
+  lp_Media *next;
+
   media_lock (media);
 
   g_assert (media_state_starting (media));
@@ -1545,53 +3840,312 @@ _lp_media_finish_start (lp_Media *media)
   g_assert (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_BLOCKED));
   g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED));
   media_toggle_flag_on_all_pads (media, PAD_FLAG_FLUSHED); /* un-flush */
-  media->state = STARTED;
+  media_set_state (media, STARTED);
+
+  /* The first segment already has the rate and loop mode set before
+     @media started (cf. _lp_media_finish_preroll()); this seeks only if
+     they were changed while @media was starting.  */
+  media_update_segment_unlocked (media);
+
+  next = media_ref_next (media);
+
+  media_unlock (media);
+
+  /* Preroll the next media, so that it is ready when this one ends.  */
+  if (next != NULL)
+    {
+      media_preroll_next (next);
+      g_object_unref (next);
+    }
+  _lp_scene_rebalance_threads (media->prop.scene);
+}
+
+/* Finishes the preroll of @media, whose pads hold their first data, by a
+   flushing seek to its start with the rate and loop mode of property
+   "rate" and "loop".  The flush drops the held data and the pads are
+   unblocked, so that the first data of the new segment dispatches the
+   start lp_Event as usual.  If the seek fails, the held data is let
+   through and @media plays its first segment at the natural rate.  */
+
+void
+_lp_media_finish_preroll (lp_Media *media)
+{
+  gint flags;
+
+  media_lock (media);
+
+  if (unlikely (!media_state_starting (media)))
+    goto done;                  /* stopped meanwhile */
+
+  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_BLOCKED));
+  media_toggle_flag_on_all_pads (media, PAD_FLAG_BLOCKED); /* unblock */
+
+  flags = GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE;
+  if (media->prop.loop)
+    flags |= GST_SEEK_FLAG_SEGMENT; /* end with segment-done, not EOS */
+
+  if (likely (gst_element_seek (media->bin, media->prop.rate,
+                                GST_FORMAT_TIME, (GstSeekFlags) flags,
+                                GST_SEEK_TYPE_SET, 0,
+                                GST_SEEK_TYPE_NONE, 0)))
+    {
+      media->seek.rate = media->prop.rate;
+      media->seek.segment = media->prop.loop;
+    }
+  else
+    {
+      _lp_warn ("cannot set rate or loop mode of %p", media);
+      if (media_is_standby (media)) /* held until release */
+        {
+          media->standby.probe_audio = media->preroll.probe_audio;
+          media->standby.probe_video = media->preroll.probe_video;
+        }
+      else
+        {
+          if (media_has_audio (media))
+            media_unblock_pad_unlocked (media, media->audio.pad,
+                                        media->preroll.probe_audio);
+          if (media_has_video (media))
+            media_unblock_pad_unlocked (media, media->video.pad,
+                                        media->preroll.probe_video);
+          media_dispatch_start_if_prerolled (media);
+        }
+    }
+
+  media->preroll.probe_audio = 0;
+  media->preroll.probe_video = 0;
+
+ done:
+  media_unlock (media);
+}
+
+/* Finishes async stop in @media.  */
+
+void
+_lp_media_finish_stop (lp_Media *media)
+{
+  GstElement *pipeline;
+
+  media_lock (media);
+
+  g_assert (media_state_stopping (media));
+  g_assert (media->audio.flags == PAD_FLAG_NONE);
+  g_assert (media->video.flags == PAD_FLAG_NONE);
+
+  if (media_has_audio (media))
+    g_clear_pointer (&media->audio.pad, gst_object_unref);
+
+  if (media_has_video (media))
+    g_clear_pointer (&media->video.pad, gst_object_unref);
+
+  pipeline = _lp_scene_get_pipeline (media->prop.scene);
+  g_assert_nonnull (pipeline);
+  g_assert (gst_bin_remove (GST_BIN (pipeline), media->bin));
+  gstx_element_set_state_sync (media->bin, GST_STATE_NULL);
+  media_set_state (media, STOPPED);
+  media_release_run_time_data (media);
+
+  media_unlock (media);
+  _lp_scene_rebalance_threads (media->prop.scene);
+}
+
+/* Finishes async seek in @media.  Returns %TRUE if the seek was requested
+   by the application, or %FALSE if it was internal, in which case its seek
+   lp_Event should not be delivered.  */
+
+gboolean
+_lp_media_finish_seek (lp_Media *media)
+{
+  gboolean requested;
+
+  media_lock (media);
+  requested = !media->seek.internal;
+
+  g_assert (media_state_seeking (media));
+  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_ACTIVE));
+  g_assert (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_BLOCKED));
+  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED));
+  media_toggle_flag_on_all_pads (media, PAD_FLAG_FLUSHED); /* un-flush */
+  media_set_state (media, STARTED);
+
+  /* In refine mode, the key frame seek is followed by an accurate seek to
+     the requested position.  */
+  if (media->seek.refine)
+    {
+      media->seek.refine = FALSE;
+      if (unlikely (!media_seek_to_unlocked (media, media->seek.target,
+                                             LP_SEEK_MODE_ACCURATE)))
+        {
+          _lp_warn ("cannot refine seek of %p", media);
+        }
+    }
+  else                          /* apply rate or loop set while seeking */
+    {
+      media_update_segment_unlocked (media);
+    }
+
+  media_unlock (media);
+  return requested;
+}
+
+/* Queries the latency of @media.  If @video is true, queries the video
+   branch, otherwise queries the audio branch.  Stores in @decode the
+   latency up to the decoder output and in @convert the latency added by
+   the converters of @media.  Returns %TRUE if successful, or %FALSE if
+   @media is not started or has no such branch.  */
+
+gboolean
+_lp_media_get_latency (lp_Media *media, gboolean video,
+                       GstClockTime *decode, GstClockTime *convert)
+{
+  GstElement *entry;
+  GstPad *ghost;
+  GstPad *sink;
+  GstPad *peer;
+  GstClockTime dec;
+  GstClockTime out;
+
+  media_lock (media);
+
+  if (!media_state_started (media)
+      || (video && !media_has_video (media))
+      || (!video && !media_has_audio (media)))
+    {
+      media_unlock (media);
+      return FALSE;
+    }
+
+  if (video)
+    {
+      ghost = (GstPad *) gst_object_ref (media->video.pad);
+      entry = (media->video.queue != NULL)
+        ? media->video.queue : media->video.convert;
+    }
+  else
+    {
+      ghost = (GstPad *) gst_object_ref (media->audio.pad);
+      entry = NULL;             /* decoder output is known */
+    }
+
+  if (entry != NULL)
+    {
+      sink = gst_element_get_static_pad (entry, "sink");
+      g_assert_nonnull (sink);
+      peer = gst_pad_get_peer (sink);
+      gst_object_unref (sink);
+    }
+  else
+    {
+      peer = (GstPad *) gst_object_ref (media->audio.decoded);
+    }
+
+  /* Queries travel upstream through the media elements; they do not need
+     the media lock.  */
+  media_unlock (media);
+
+  dec = (peer != NULL) ? gstx_pad_query_latency (peer, NULL) : 0;
+  out = gstx_pad_query_latency (ghost, NULL);
+
+  if (peer != NULL)
+    gst_object_unref (peer);
+  gst_object_unref (ghost);
+
+  set_if_nonnull (decode, dec);
+  set_if_nonnull (convert, (out > dec) ? out - dec : 0);
+
+  return TRUE;
+}
+
+/* Returns the displayed area of @media in pixels, or zero if @media is
+   not started or has no video.  Media displayed at their natural size
+   use the size of the decoded frames.  */
+
+guint64
+_lp_media_get_display_area (lp_Media *media)
+{
+  lp_MediaState state;
+  gint width;
+  gint height;
+
+  gx_seqlock_read (&media->pub.seq, state, media->pub.state);
+  if (state != STARTED)
+    return 0;                   /* nothing to do */
+
+  media_lock (media);
+
+  if (!media_state_started (media) || !media_has_video (media))
+    {
+      media_unlock (media);
+      return 0;
+    }
+
+  width = media->prop.width;
+  height = media->prop.height;
+  if (width <= 0 || height <= 0)
+    {
+      GstCaps *caps;
+
+      caps = gst_pad_get_current_caps (media->video.pad);
+      if (caps != NULL)
+        {
+          GstStructure *st;
+
+          st = gst_caps_get_structure (caps, 0);
+          if (width <= 0)
+            gst_structure_get_int (st, "width", &width);
+          if (height <= 0)
+            gst_structure_get_int (st, "height", &height);
+          gst_caps_unref (caps);
+        }
+    }
 
   media_unlock (media);
+  return (guint64) max (width, 1) * (guint64) max (height, 1);
 }
 
-/* Finishes async stop in @media.  */
+/* Sets the thread share of @media to @threads and applies it to the
+   elements of @media.  */
 
 void
-_lp_media_finish_stop (lp_Media *media)
+_lp_media_set_threads (lp_Media *media, guint threads)
 {
-  GstElement *pipeline;
-
   media_lock (media);
 
-  g_assert (media_state_stopping (media));
-  g_assert (media->audio.flags == PAD_FLAG_NONE);
-  g_assert (media->video.flags == PAD_FLAG_NONE);
+  if (media->threads != threads)
+    {
+      media->threads = threads;
+      media_apply_threads_unlocked (media);
+    }
 
-  if (media_has_audio (media))
-    g_clear_pointer (&media->audio.pad, gst_object_unref);
+  media_unlock (media);
+}
 
-  if (media_has_video (media))
-    g_clear_pointer (&media->video.pad, gst_object_unref);
+/* Updates the number of frames dropped by the decoders of @media, as
+   reported by a QoS message with @dropped frames.  Decoders report
+   cumulative counts, so the largest count is kept.  */
 
-  pipeline = _lp_scene_get_pipeline (media->prop.scene);
-  g_assert_nonnull (pipeline);
-  g_assert (gst_bin_remove (GST_BIN (pipeline), media->bin));
-  gstx_element_set_state_sync (media->bin, GST_STATE_NULL);
-  media_release_run_time_data (media);
+void
+_lp_media_update_qos (lp_Media *media, guint64 dropped)
+{
+  gsize old;
 
-  media_unlock (media);
+  do
+    {
+      old = (gsize) g_atomic_pointer_get (&media->qos.dropped);
+      if (old >= dropped)
+        break;
+    }
+  while (!g_atomic_pointer_compare_and_exchange
+         (&media->qos.dropped, old, (gsize) dropped));
 }
 
-/* Finishes async seek in @media.  */
+/* Updates the buffering level of @media to @percent.  */
 
 void
-_lp_media_finish_seek (lp_Media *media)
+_lp_media_update_buffering (lp_Media *media, gint percent)
 {
   media_lock (media);
-
-  g_assert (media_state_seeking (media));
-  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_ACTIVE));
-  g_assert (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_BLOCKED));
-  g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_FLUSHED));
-  media_toggle_flag_on_all_pads (media, PAD_FLAG_FLUSHED); /* un-flush */
-  media->state = STARTED;
-
+  media->buffering = clamp (percent, 0, 100);
   media_unlock (media);
 }
 
@@ -1641,242 +4195,64 @@ lp_media_to_string (lp_Media *media)
   height: %d\n\
   alpha: %.2lg\n\
   mute: %s\n\
-  volume: %.2lg\n\
-  text: %s\n\
-  text-color: 0x%x\n\
-  text-font: %s\n\
-",
-                         G_OBJECT_TYPE_NAME (media),
-                         media,
-                         media->prop.scene,
-                         media->prop.uri,
-                         media->prop.x,
-                         media->prop.y,
-                         media->prop.z,
-                         media->prop.width,
-                         media->prop.height,
-                         media->prop.alpha,
-                         strbool (media->prop.mute),
-                         media->prop.volume,
-                         media->prop.text,
-                         media->prop.text_color,
-                         media->prop.text_font);
-  g_assert_nonnull (str);
-
-  media_unlock (media);
-  return str;
-}
-
-/**
- * lp_media_start:
- * @media: an #lp_Media
- *
- * Starts @media asynchronously.
- *
- * Returns: %TRUE if successful, or %FALSE otherwise
- */
-gboolean
-lp_media_start (lp_Media *media)
-{
-  GstElement *pipeline;
-  gboolean is_started = FALSE;
-
-  media_lock (media);
-
-  if (unlikely (!media_state_stopped (media)))
-    goto fail;                  /* nothing to do */
-
-  if (media->prop.uri == NULL &&
-      media->prop.width > 0 &&
-      media->prop.height > 0)
-  {
-    /* push transparent buffer */
-    GstCaps *caps = NULL;
-
-    const gstx_eltmap_t lp_media_appsrc_eltmap[] = {
-      {"bin",           offsetof (lp_Media, bin)},
-      {"appsrc",        offsetof (lp_Media, source)},
-      {"videoconvert",  offsetof (lp_Media, decoder)},
-      {NULL, 0},
-    };
-
-    _lp_eltmap_alloc_check (media, lp_media_appsrc_eltmap);
-
-    gstx_bin_add (media->bin, media->source);
-    gstx_bin_add (media->bin, media->decoder);
-
-    caps = gst_caps_new_simple ("video/x-raw",
-        "format", G_TYPE_STRING, "ARGB",
-        "width", G_TYPE_INT, media->prop.width,
-        "height", G_TYPE_INT, media->prop.height,
-        "framerate", GST_TYPE_FRACTION, 30, 1,
-        "pixel-aspect-ration", GST_TYPE_FRACTION, 1,1,
-        NULL);
-    g_object_set (media->source,
-        "caps", caps,
-        "format", GST_FORMAT_TIME,
-        "stream-type", 0,
-        NULL);
-
-    gst_app_src_set_caps(GST_APP_SRC(media->source), caps);
-
-    g_signal_connect (media->source, "need-data",
-        G_CALLBACK (_lp_common_appsrc_transparent_data), media);
-
-    g_assert (gst_element_link (media->source, media->decoder));
-
-    is_started = TRUE;
-    goto sourceok;
-  }
-
-  if (gst_uri_is_valid (media->prop.uri))
-  {
-    gboolean ok = TRUE;
-    char *urischeme = gst_uri_get_protocol (media->prop.uri);
-    if (g_str_equal ("data", urischeme))
-    {
-      /* URI is: data://<...>  */
-      char *tmp = media->prop.uri + 4;
-      char *endptr = NULL;
-
-      if (!tmp || *tmp != ':')
-        ok = FALSE;
-      else
-      {
-        while (*(++tmp))
-        {
-          if (*tmp == ',')
-          {
-            endptr = tmp;
-            break;
-          }
-        }
-      }
-
-      if (endptr != NULL)
-      {
-        char *type;
-        tmp = media->prop.uri + 5;
-        type = g_strndup (tmp, endptr - tmp);
-
-        /* If type isn't specified, the default is text */
-        if (strlen (type) == 0 || g_str_has_prefix(type, "text"))
-        {
-          char *text = (endptr + 1);
-          g_object_set (media, "text", text, NULL);
-
-          media_flag_set (media, FLAG_TEXT);
-        }
-        g_free (type);
-      }
-      else
-        ok = FALSE;
-    }
-    else
-      media->prop.final_uri = g_strdup (media->prop.uri);
-
-    g_free (urischeme);
-    if (!ok)
-      goto fail;
-  }
-  else
-  {
-    GError *error = NULL;
-    gchar *final_uri = gst_filename_to_uri (media->prop.uri, &error);
-    if (unlikely (final_uri == NULL))
-    {
-      _lp_warn ("bad URI: %s", media->prop.uri);
-      g_error_free (error);
-      goto fail;
-    }
-    media->prop.final_uri = final_uri;
-  }
-
-  _lp_eltmap_alloc_check (media, lp_media_eltmap);
-  g_object_set (media->decoder, "uri", media->prop.final_uri, NULL);
-  gstx_bin_add (media->bin, media->decoder);
-
-  media->callback.pad_added = g_signal_connect
-    (media->decoder, "pad-added", /* GstElement */
-     G_CALLBACK (lp_media_pad_added_callback), media);
-  g_assert (media->callback.pad_added > 0);
-
-  media->callback.no_more_pads = g_signal_connect
-    (media->decoder, "no-more-pads", /* GstElement */
-     G_CALLBACK (lp_media_no_more_pads_callback), media);
-  g_assert (media->callback.no_more_pads);
-
-  media->callback.autoplug_continue = g_signal_connect
-    (media->decoder, "autoplug-continue", /* GstURIDecodeBin */
-     G_CALLBACK (lp_media_autoplug_continue_callback), media);
-  g_assert (media->callback.autoplug_continue > 0);
-
-  media->callback.drained = g_signal_connect
-    (media->decoder, "drained", /* GstURIDecodeBin */
-     G_CALLBACK (lp_media_drained_callback), media);
-  g_assert (media->callback.drained > 0);
-
-sourceok:
-  g_object_set_data (G_OBJECT (media->bin), "lp_Media", media);
-
-  pipeline = _lp_scene_get_pipeline (media->prop.scene);
-  g_assert_nonnull (pipeline);
-  gstx_bin_add (pipeline, media->bin);
-  g_assert (gst_object_ref (media->bin) == media->bin);
-
-  media->state = STARTING;
-
-  /* To properly synchronize multiple media objects we need to save the
-   * offset at this point */
-  media->offset = _lp_scene_get_offset_last_buffer (media->prop.scene);
-  g_assert (GST_CLOCK_TIME_IS_VALID (media->offset));
-
-  if (unlikely (!gst_element_sync_state_with_parent (media->bin)))
-  {
-    gstx_element_set_state_sync (media->bin, GST_STATE_NULL);
-    gstx_bin_remove (pipeline, media->bin);
-    media_release_run_time_data (media);
-    goto fail;
-  }
-
-  if (is_started)
-  {
-    GstPad *pad = NULL;
-    GstPad *ghost = NULL;
-    lp_EventStart *event = NULL;
-    lp_MediaPadFlag *flags = NULL;
-
-    pad = gst_element_get_static_pad (media->decoder, "src");
-    ghost = _lp_media_configure_video_bin (media, pad);
-    g_assert_nonnull (ghost);
-    gst_object_unref (pad);
-
-    flags = media_get_pad_flags (media, ghost);
-    g_assert_nonnull (flags);
-    g_assert (media_pad_flag_active (*flags));
-    MEDIA_PAD_FLAG_TOGGLE (*flags, PAD_FLAG_FLUSHED); /* flush */
-
-    event = _lp_event_start_new (G_OBJECT(media), FALSE);
-    g_assert_nonnull (event);
-    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
-    media->linked_pads++;
-  }
+  volume: %.2lg\n\
+  text: %s\n\
+  text-color: 0x%x\n\
+  text-font: %s\n\
+",
+                         G_OBJECT_TYPE_NAME (media),
+                         media,
+                         media->prop.scene,
+                         media->prop.uri,
+                         media->prop.x,
+                         media->prop.y,
+                         media->prop.z,
+                         media->prop.width,
+                         media->prop.height,
+                         media->prop.alpha,
+                         strbool (media->prop.mute),
+                         media->prop.volume,
+                         media->prop.text,
+                         media->prop.text_color,
+                         media->prop.text_font);
+  g_assert_nonnull (str);
 
   media_unlock (media);
+  return str;
+}
 
-  /* if (media->prop.sync) */
-  /* { */
-  /*   _lp_scene_iterate_loop_until (media->prop.scene, */
-  /*       (gboolean (*)(gpointer)) lp_media_has_started, media); */
-  /* } */
+/**
+ * lp_media_start:
+ * @media: an #lp_Media
+ *
+ * Starts @media asynchronously.
+ *
+ * If @media has been prerolled as the next media of another one (cf.
+ * property "next"), starts it immediately without waiting for the other
+ * media to end.
+ *
+ * Returns: %TRUE if successful, or %FALSE otherwise
+ */
+gboolean
+lp_media_start (lp_Media *media)
+{
+  gboolean status;
 
-  _lp_debug ("%p offset: %lu\n", media, media->offset);
+  media_lock (media);
 
-  return TRUE;
+  if (media_state_starting (media) && media_is_standby (media))
+    {
+      media_release_standby_unlocked
+        (media, _lp_scene_get_offset_last_buffer (media->prop.scene));
+      status = TRUE;
+    }
+  else
+    {
+      status = media_start_unlocked (media, FALSE);
+    }
 
- fail:
   media_unlock (media);
-  return FALSE;
+  return status;
 }
 
 /**
@@ -1893,10 +4269,38 @@ lp_media_stop (lp_Media *media)
   media_lock (media);
 
   if (unlikely (!(media_state_started (media) ||
+                  media_state_pausing (media) ||
                   media_state_paused (media))))
     goto fail;                  /* nothing to do */
 
-  if (_lp_scene_is_paused (media->prop.scene))
+  if (media_state_pausing (media) || media_state_paused (media))
+  {
+    /*
+     * Pads blocked by lp_media_pause () can't be blocked again.  We stop
+     * the pause task, then manually call lp_media_stop_block_probe_callback
+     * () on each pad.  Deactivating a pad releases its pending buffer, so
+     * the pause probes are only removed afterwards.
+     */
+    media_set_state (media, STOPPING);
+    media_stop_pause_task (media);
+
+    if (media_has_audio (media)
+        && media_pad_flag_blocked (media->audio.flags))
+      MEDIA_PAD_FLAG_TOGGLE (media->audio.flags, PAD_FLAG_BLOCKED);
+
+    if (media_has_video (media)
+        && media_pad_flag_blocked (media->video.flags))
+      MEDIA_PAD_FLAG_TOGGLE (media->video.flags, PAD_FLAG_BLOCKED);
+
+    if (media_has_audio (media))
+      lp_media_stop_block_probe_callback (media->audio.pad, NULL, media);
+
+    if (media_has_video (media))
+      lp_media_stop_block_probe_callback (media->video.pad, NULL, media);
+
+    media_remove_pause_probes (media);
+  }
+  else if (_lp_scene_is_paused (media->prop.scene))
   {
     /*
      * Installing a block probe has no effect because pads are already
@@ -1918,18 +4322,9 @@ lp_media_stop (lp_Media *media)
     }
     gst_iterator_free (it);
   }
-  else if (media_state_paused(media) || media_state_pausing(media))
-  {
-    lp_EventStop *event;
-    media->state = STOPPING;
-
-    event = _lp_event_stop_new (media, media_has_drained (media));
-    g_assert_nonnull (event);
-    _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
-  }
   else
   {
-    media->state = STOPPING;
+    media_set_state (media, STOPPING);
     media_install_probe
       (media, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
        (GstPadProbeCallback) lp_media_stop_block_probe_callback, NULL, NULL);
@@ -1959,142 +4354,30 @@ lp_media_stop (lp_Media *media)
  * @media time.  Positive @offset values indicate an offset from @media
  * beginning and negative values indicate an offset from its end.
  *
+ * The seek is performed according to the #lp_SeekMode in property
+ * "seek-mode".  In refine mode, two seek events are dispatched: one when
+ * the key frame seek completes and another when the accurate seek
+ * completes.  Each seek event carries its mode and latency.
+ *
  * Returns: %TRUE if successful, or %FALSE otherwise
  */
 gboolean
 lp_media_seek (lp_Media *media, gboolean relative, gint64 offset)
 {
-  GstQuery *query;
-  gboolean seekable;
-  gulong id_audio;
-  gulong id_video;
-  gint64 duration;
-  guint64 now;
-  gint64 run;
-  gint64 sum;
-  gint64 abs;
-  gint flags;
   gboolean status;
 
   media_lock (media);
-
-  if (unlikely (!media_state_started (media)))
-    goto fail;                  /* nothing to do */
-
-  query = gst_query_new_seeking (GST_FORMAT_TIME);
-  g_assert_nonnull (query);
-  if (unlikely (!gst_element_query (media->decoder, query)))
-    {
-      gst_query_unref (query);
-      goto fail;                /* not seekable */
-    }
-
-  seekable = FALSE;
-  gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
-  gst_query_unref (query);
-
-  if (unlikely (!seekable))
-    goto fail;                  /* not seekable */
-
-  duration = GST_CLOCK_TIME_NONE;
-  if (!relative && offset < 0.0) /* resolve duration */
-    {
-      query = gst_query_new_duration (GST_FORMAT_TIME);
-      g_assert_nonnull (query);
-      if (unlikely (!gst_element_query (media->decoder, query)))
-        {
-          gst_query_unref (query);
-          goto fail;
-        }
-      gst_query_parse_duration (query, NULL, &duration);
-      gst_query_unref (query);
-    }
-
-  media->state = SEEKING;
-  media_install_probe
-    (media, GST_PAD_PROBE_TYPE_EVENT_FLUSH,
-     (GstPadProbeCallback) lp_media_seek_flush_probe_callback,
-     &id_audio, &id_video);
-
-  now = _lp_scene_get_running_time (media->prop.scene);
-  g_assert (GST_CLOCK_TIME_IS_VALID (now));
-  run = now - media->offset;
-  g_assert (run > 0);
-  sum = media->seek.sum;
-
-  if (relative)                 /* offset is relative */
-  {
-    abs = run + sum + offset;
-    if (abs > 0)
-      sum += offset;
-    else
-      abs = 0;
-  }
-  else                          /* offset is absolute */
-  {
-    abs = clamp (run + sum, 0, G_MAXINT64);
-    if (offset < 0)
-      {
-        g_assert (GST_CLOCK_STIME_IS_VALID (duration));
-        offset = duration + offset;
-      }
-    sum = sum + offset - abs;
-    abs = offset;
-  }
-
-  _lp_debug ("\n\
-seek (%s) %p\n\
-  now: %" GST_TIME_FORMAT "\n\
-  run: %" GST_TIME_FORMAT "\n\
-  sum: %" GST_STIME_FORMAT "\n\
-  abs: %" GST_TIME_FORMAT "\n",
-             relative ? "relative" : "absolute",
-             media,
-             GST_TIME_ARGS (now),
-             GST_TIME_ARGS (run),
-             GST_STIME_ARGS (sum),
-             GST_TIME_ARGS (abs));
-
-  media->seek.relative = relative; /* last seek type */
-  media->seek.last = offset;       /* last seek offset */
-
-  flags = 0
-    | GST_SEEK_FLAG_FLUSH       /* flush bin */
-    | GST_SEEK_FLAG_ACCURATE    /* be accurate */
-    | GST_SEEK_FLAG_TRICKMODE;  /* decode only key frames */
-
-  status = gst_element_seek_simple (media->bin, GST_FORMAT_TIME,
-                                    (GstSeekFlags) flags, abs);
-  if (unlikely (!status))
-    {
-      if (media_has_audio (media))
-        gst_pad_remove_probe (media->audio.pad, id_audio);
-      if (media_has_video (media))
-        gst_pad_remove_probe (media->video.pad, id_video);
-      goto fail;
-    }
-
-  /* Update the accumulate offset only in case of success.  */
-  media->seek.sum = sum;
-
-  if (media_has_audio (media))
-    gst_pad_set_offset (media->audio.pad, now);
-  if (media_has_video (media))
-    gst_pad_set_offset (media->video.pad, now);
-
+  status = media_seek_unlocked (media, relative, offset,
+                                media->prop.seek_mode);
   media_unlock (media);
 
-  if (media->prop.sync)
+  if (status && media->prop.sync)
   {
     _lp_scene_iterate_loop_until (media->prop.scene,
         (gboolean (*)(gpointer)) lp_media_has_started, media);
   }
 
-  return TRUE;
-
- fail:
-  media_unlock (media);
-  return FALSE;
+  return status;
 }
 
 /**
@@ -2136,201 +4419,133 @@ lp_media_get_running_time (lp_Media *media)
 gboolean
 lp_media_pause (lp_Media *media)
 {
-  GstIterator *it = NULL;
-  GValue value = G_VALUE_INIT;
-  gboolean ret = TRUE;
-
-  g_assert (media);
+  media_lock (media);
 
-  media_lock(media);
-  if (!media_state_started (media))
-  {
-    ret = FALSE;
-    goto finish;
-  }
+  if (unlikely (!media_state_started (media)))
+    goto fail;                  /* nothing to do */
 
-  media->state = PAUSING;
+  media_set_state (media, PAUSING);
   media->pause.time = _lp_scene_get_running_time (media->prop.scene);
+  g_assert (GST_CLOCK_TIME_IS_VALID (media->pause.time));
+
   if (media_is_frozen (media)) /* still image, nothing to do  */
   {
-    media->state = PAUSED;
+    media_set_state (media, PAUSED);
     _lp_scene_dispatch (media->prop.scene,
         LP_EVENT (_lp_event_pause_new (G_OBJECT(media))));
-    goto finish;
-  }
-
-  it = gst_element_iterate_src_pads (media->decoder);
-  while (gst_iterator_next (it, &value) == GST_ITERATOR_OK)
-  {
-    GstPad *p = NULL;
-
-    p = GST_PAD (g_value_get_object (&value));
-    gst_pad_add_probe (p, GST_PAD_PROBE_TYPE_BUFFER,
-        (GstPadProbeCallback) lp_media_pause_have_data_probe_callback,
-        media, NULL);
+    goto done;
   }
-  gst_iterator_free (it);
-
-finish:
-  media_unlock(media);
-
-  return ret;
-}
 
-/* Pushes the same video buffer while paused */
-static void
-_lp_media_push_pause_buffer (GstElement *src, arg_unused(guint size_),
-    gpointer data)
-{
-  static GstClockTime timestamp = 0;
-  GstBuffer *buffer = NULL;
-  GstFlowReturn ret;
-  lp_Media *media = NULL;
-  GstCaps *caps = NULL;
-
-  media = LP_MEDIA(data);
-  /* Do we need to lock media?
-   * I've tried to lock here and it led to dead lock
-   */
-  if (timestamp == 0)
-    timestamp = _lp_scene_get_running_time (media->prop.scene);
-
-  g_object_get (src,
-                "caps", &caps,
-                NULL);
-
-  g_assert_nonnull (caps);
-
-  buffer = gst_buffer_copy (media->pause.video_buffer);
-  GST_BUFFER_PTS (buffer) = timestamp;
-  GST_BUFFER_DURATION (buffer) = media->pause.duration;
-
-  timestamp += GST_BUFFER_DURATION (buffer);
+  media_install_probe
+    (media, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BLOCK
+                              | GST_PAD_PROBE_TYPE_BUFFER),
+     (GstPadProbeCallback) lp_media_pause_block_probe_callback,
+     &media->pause.probe_audio, &media->pause.probe_video);
 
-  g_signal_emit_by_name (src, "push-buffer", buffer, &ret);
-  g_assert (ret == GST_FLOW_OK);
+ done:
+  media_unlock (media);
+  return TRUE;
 
-  gst_buffer_unref (buffer);
+ fail:
+  media_unlock (media);
+  return FALSE;
 }
 
-
 /* Finishes async pause in @media.  */
 
 void
 _lp_media_finish_pause (lp_Media *media)
 {
   media_lock (media);
-  media->state = PAUSED;
-  gst_element_set_state (media->bin, GST_STATE_PAUSED);
 
-  if (media->pause.video_buffer && media->pause.caps)
+  if (media_state_pausing (media))
   {
-    GstPad *source = NULL;
-    GstPad *sink = NULL;
-    GstElement *pipeline = NULL;
-    GstCaps *caps = NULL;
-    GstStructure *structure = NULL;
-    const GValue *framerate;
-    gint numerator;
-    gint denominator;
-
-    media->pause.appsrc = gst_element_factory_make ("appsrc", NULL);
-    media->pause.convert = gst_element_factory_make ("videoconvert", NULL);
-
-    g_object_set (G_OBJECT (media->pause.appsrc),
-        "caps", media->pause.caps,
-        NULL);
-
-    gst_caps_unref(media->pause.caps);
-
-    g_signal_connect (media->pause.appsrc, "need-data",
-        G_CALLBACK (_lp_media_push_pause_buffer), media);
-
-    pipeline = _lp_scene_get_pipeline (media->prop.scene);
-
-    gst_bin_add_many (GST_BIN(pipeline), media->pause.appsrc,
-        media->pause.convert, NULL);
-
-    g_assert (gst_element_link_many (media->pause.appsrc,
-          media->pause.convert, NULL));
-
-    source = gst_element_get_static_pad (media->pause.convert, "src");
-    sink = gst_element_get_request_pad (
-        _lp_scene_get_video_mixer (media->prop.scene), "sink_%u");
-
-    g_assert (gst_pad_link (source, sink) == GST_PAD_LINK_OK);
-
-    g_object_set (G_OBJECT (media->pause.appsrc),
-        "format", GST_FORMAT_TIME,
-        "stream-type", 0,
-        NULL);
-
-    g_object_set (sink,
-       "xpos", media->prop.x,
-       "ypos", media->prop.y,
-       "zorder", media->prop.z,
-       "alpha", media->prop.alpha, NULL);
-
-    if (media->prop.width > 0)
-      g_object_set (sink, "width", media->prop.width, NULL);
-
-    if (media->prop.height > 0)
-      g_object_set (sink, "height", media->prop.height, NULL);
-
-    gst_object_unref (source);
-    gst_object_unref (sink);
-
-    source = gst_element_get_static_pad (
-        _lp_scene_get_video_mixer (media->prop.scene), "src");
-
-    g_object_get (source,
-        "caps", &caps,
-        NULL);
-    g_assert_nonnull (caps);
-
-    gst_object_unref (source);
-
-    structure = gst_caps_get_structure (caps, 0);
-    gst_caps_unref (caps);
-
-    framerate = gst_structure_get_value (structure, "framerate");
-
-    if (framerate == NULL ||
-        (numerator = gst_value_get_fraction_numerator (framerate),
-         denominator = gst_value_get_fraction_denominator(framerate),
-         numerator == 0 || denominator == 0))
-      media->pause.duration = 33 * GST_MSECOND;
-    else
-      media->pause.duration = (denominator * 1000 /*ms*/ /  numerator)
-        * GST_MSECOND;
-
-    gstx_element_sync_state_with_parent (media->pause.appsrc);
-    gstx_element_sync_state_with_parent (media->pause.convert);
+    g_assert (media_is_flag_set_on_all_pads (media, PAD_FLAG_BLOCKED));
+    media_set_state (media, PAUSED);
   }
+
   media_unlock (media);
 }
 
-
 /* Finishes async resume in @media.  */
 
 void
-_lp_media_finish_resume (arg_unused(lp_Media *media))
+_lp_media_finish_resume (lp_Media *media)
 {
-  /* TODO */
+  media_lock (media);
+
+  if (media_state_resuming (media))
+  {
+    g_assert (media_is_flag_not_set_on_all_pads (media, PAD_FLAG_BLOCKED));
+    media_set_state (media, STARTED);
+
+    /* Apply rate or loop set while pausing, paused or resuming.  */
+    media_update_segment_unlocked (media);
+  }
+
+  media_unlock (media);
 }
 
 /**
  * lp_media_resume:
  * @media: an #lp_Media
  *
- * Resumes @media asynchronously.
+ * Resumes @media asynchronously.  Decoding continues from the position
+ * where @media was paused.
  *
  * Returns: %TRUE if successful, or %FALSE otherwise
  */
 gboolean
-lp_media_resume (arg_unused(lp_Media *media))
+lp_media_resume (lp_Media *media)
 {
-  /* TODO */
+  lp_EventStart *event;
+  guint64 now;
+  gint64 delta;
+
+  media_lock (media);
+
+  if (unlikely (!media_state_paused (media)))
+    goto fail;                  /* nothing to do */
+
+  if (!media_is_frozen (media))
+  {
+    /* Shift the pad offsets by the time spent paused, so that the blocked
+       buffers are played from now on.  */
+    now = _lp_scene_get_running_time (media->prop.scene);
+    g_assert (GST_CLOCK_TIME_IS_VALID (now));
+    delta = (now > media->pause.time) ? (gint64)(now - media->pause.time) : 0;
+
+    if (media_has_audio (media))
+    {
+      media_link_audio_mixer (media);
+      gst_pad_set_offset (media->audio.pad,
+                          gst_pad_get_offset (media->audio.pad) + delta);
+    }
+
+    if (media_has_video (media))
+      gst_pad_set_offset (media->video.pad,
+                          gst_pad_get_offset (media->video.pad) + delta);
+
+    media->offset += (guint64) delta;
+    media->seek.base += (guint64) delta;
+
+    /* Stopped after the offsets are shifted, so that the segment sent
+       again to the compositor carries the new offset.  */
+    media_stop_pause_task (media);
+    media_toggle_flag_on_all_pads (media, PAD_FLAG_BLOCKED); /* unblock */
+    media_remove_pause_probes (media);
+  }
+
+  media_set_state (media, RESUMING);
+  event = _lp_event_start_new (G_OBJECT (media), TRUE);
+  g_assert_nonnull (event);
+  _lp_scene_dispatch (media->prop.scene, LP_EVENT (event));
+
+  media_unlock (media);
+  return TRUE;
+
+ fail:
+  media_unlock (media);
   return FALSE;
 }
 
@@ -0,0 +1,493 @@
+/* lp-mmap-src.c -- Memory-mapped local file source.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "play-internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/* Mapped file region.  Buffers pushed downstream keep a reference to the
+   region, so that the mapping outlives the source if needed.  */
+typedef struct _lp_MmapRegion
+{
+  gint ref;                     /* reference count */
+  guint8 *data;                 /* mapped data */
+  gsize size;                   /* mapped size in bytes */
+} lp_MmapRegion;
+
+/* Memory-mapped file source.  */
+struct _lp_MmapSrc
+{
+  GstBaseSrc parent;            /* parent object */
+  GMutex mutex;                 /* sync access to uri */
+  gchar *uri;                   /* file URI */
+  gchar *filename;              /* file name */
+  lp_MmapRegion *region;        /* current mapping (or NULL) */
+  int fd;                       /* mapped file (or -1) */
+  gsize size;                   /* file size at last check */
+  guint64 next;                 /* offset following last read */
+  gsize advised;                /* end of read-ahead window */
+};
+
+/* Size of the read-ahead window in bytes.  */
+#define MMAP_SRC_WINDOW  (8 * 1024 * 1024)
+
+/* Element name and rank.  The element is never autoplugged: it handles
+   only the private URI scheme that LibPlay media give to uridecodebin.  */
+#define MMAP_SRC_NAME    "lpmmapsrc"
+#define MMAP_SRC_RANK    GST_RANK_NONE
+#define MMAP_SRC_SCHEME  "lpfile"
+
+static void lp_mmap_src_uri_handler_init (gpointer, gpointer);
+
+/* Define the lp_MmapSrc type.  */
+GX_DEFINE_TYPE_WITH_CODE (lp_MmapSrc, lp_mmap_src, GST_TYPE_BASE_SRC,
+                          G_IMPLEMENT_INTERFACE
+                          (GST_TYPE_URI_HANDLER,
+                           lp_mmap_src_uri_handler_init))
+
+#define src_lock(src)    g_mutex_lock (&(src)->mutex)
+#define src_unlock(src)  g_mutex_unlock (&(src)->mutex)
+
+static GstStaticPadTemplate src_template =
+  GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+                           GST_STATIC_CAPS_ANY);
+
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+
+static void
+mmap_region_unref (lp_MmapRegion *region)
+{
+  if (!g_atomic_int_dec_and_test (&region->ref))
+    return;
+
+  if (region->data != NULL)
+    munmap (region->data, region->size);
+  g_free (region);
+}
+
+static lp_MmapRegion *
+mmap_region_ref (lp_MmapRegion *region)
+{
+  g_atomic_int_inc (&region->ref);
+  return region;
+}
+
+/* Advises the kernel that @src will soon read from @offset.  Pages are
+   requested one window ahead of the current position, and the window is
+   moved once half of it has been consumed or after a seek.  */
+
+static void
+mmap_src_advise (lp_MmapSrc *src, gsize offset, gsize length)
+{
+#if defined HAVE_MADVISE && HAVE_MADVISE
+  lp_MmapRegion *region;
+  gsize page;
+  gsize start;
+  gsize end;
+
+  region = src->region;
+  if (offset + length + MMAP_SRC_WINDOW / 2 <= src->advised
+      && offset + MMAP_SRC_WINDOW >= src->advised)
+    return;                     /* still inside window */
+
+  page = (gsize) sysconf (_SC_PAGESIZE);
+  start = offset - (offset % page);
+  end = min (offset + length + MMAP_SRC_WINDOW, region->size);
+  if (end > start)
+    madvise (region->data + start, end - start, MADV_WILLNEED);
+  src->advised = end;
+#else
+  (void) src;
+  (void) offset;
+  (void) length;
+#endif
+}
+
+#endif /* HAVE_SYS_MMAN_H */
+
+
+/* methods */
+
+static void
+lp_mmap_src_init (lp_MmapSrc *src)
+{
+  g_mutex_init (&src->mutex);
+  src->uri = NULL;
+  src->filename = NULL;
+  src->region = NULL;
+  src->fd = -1;
+  src->size = 0;
+  src->next = 0;
+  src->advised = 0;
+  gst_base_src_set_blocksize (GST_BASE_SRC (src), 64 * 1024);
+}
+
+static void
+lp_mmap_src_finalize (GObject *object)
+{
+  lp_MmapSrc *src;
+
+  src = LP_MMAP_SRC (object);
+  g_free (src->uri);
+  g_free (src->filename);
+  g_mutex_clear (&src->mutex);
+  G_OBJECT_CLASS (lp_mmap_src_parent_class)->finalize (object);
+}
+
+static gboolean
+lp_mmap_src_start (GstBaseSrc *basesrc)
+{
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+  lp_MmapSrc *src;
+  lp_MmapRegion *region;
+  struct stat st;
+  gchar *filename;
+  int fd;
+
+  src = LP_MMAP_SRC (basesrc);
+  src_lock (src);
+  filename = g_strdup (src->filename);
+  src_unlock (src);
+
+  if (unlikely (filename == NULL))
+    {
+      GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+                         ("No file name specified for reading."), (NULL));
+      return FALSE;
+    }
+
+  fd = open (filename, O_RDONLY);
+  if (unlikely (fd < 0))
+    {
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+                         ("Could not open file \"%s\" for reading.",
+                          filename), GST_ERROR_SYSTEM);
+      g_free (filename);
+      return FALSE;
+    }
+
+  if (unlikely (fstat (fd, &st) < 0 || !S_ISREG (st.st_mode)))
+    {
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+                         ("\"%s\" is not a regular file.", filename),
+                         (NULL));
+      close (fd);
+      g_free (filename);
+      return FALSE;
+    }
+
+  region = g_new0 (lp_MmapRegion, 1);
+  region->ref = 1;
+  region->size = (gsize) st.st_size;
+  if (region->size > 0)
+    {
+      void *data;
+
+      data = mmap (NULL, region->size, PROT_READ, MAP_SHARED, fd, 0);
+      if (unlikely (data == MAP_FAILED))
+        {
+          GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+                             ("Could not map file \"%s\".", filename),
+                             GST_ERROR_SYSTEM);
+          g_free (region);
+          close (fd);
+          g_free (filename);
+          return FALSE;
+        }
+      region->data = (guint8 *) data;
+#if defined HAVE_MADVISE && HAVE_MADVISE
+      madvise (region->data, region->size, MADV_SEQUENTIAL);
+#endif
+    }
+
+  g_free (filename);
+
+  src->region = region;
+  src->fd = fd;                 /* kept to detect truncation */
+  src->size = region->size;
+  src->next = 0;
+  src->advised = 0;
+  return TRUE;
+#else
+  GST_ELEMENT_ERROR (basesrc, RESOURCE, OPEN_READ,
+                     ("Memory mapping is not supported."), (NULL));
+  return FALSE;
+#endif
+}
+
+static gboolean
+lp_mmap_src_stop (GstBaseSrc *basesrc)
+{
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+  lp_MmapSrc *src;
+
+  src = LP_MMAP_SRC (basesrc);
+  if (src->region != NULL)
+    {
+      mmap_region_unref (src->region);
+      src->region = NULL;
+    }
+  if (src->fd >= 0)
+    {
+      close (src->fd);
+      src->fd = -1;
+    }
+#else
+  (void) basesrc;
+#endif
+  return TRUE;
+}
+
+static gboolean
+lp_mmap_src_is_seekable (arg_unused (GstBaseSrc *basesrc))
+{
+  return TRUE;
+}
+
+static gboolean
+lp_mmap_src_get_size (GstBaseSrc *basesrc, guint64 *size)
+{
+  lp_MmapSrc *src;
+
+  src = LP_MMAP_SRC (basesrc);
+  if (src->region == NULL)
+    return FALSE;
+
+  *size = src->region->size;
+  return TRUE;
+}
+
+/* Wraps the requested range of the mapping into a read-only buffer; no
+   data is copied.  The file may have been truncated since it was mapped,
+   and touching pages past its end raises SIGBUS, so the range is first
+   clamped to the file size.  The size is cached and re-checked only
+   after a seek or when a read reaches the cached end of file, to avoid
+   a system call per block on sequential reads.  */
+
+static GstFlowReturn
+lp_mmap_src_create (GstBaseSrc *basesrc, guint64 offset, guint length,
+                    GstBuffer **buffer)
+{
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+  lp_MmapSrc *src;
+  lp_MmapRegion *region;
+  GstBuffer *buf;
+  struct stat st;
+  gsize size;
+  gsize len;
+
+  src = LP_MMAP_SRC (basesrc);
+  region = src->region;
+  g_assert_nonnull (region);
+
+  if (offset != src->next || offset + length > src->size)
+    {
+      if (unlikely (fstat (src->fd, &st) < 0))
+        {
+          GST_ELEMENT_ERROR (src, RESOURCE, READ,
+                             ("Could not get the size of the mapped file."),
+                             GST_ERROR_SYSTEM);
+          return GST_FLOW_ERROR;
+        }
+      src->size = min (region->size, (gsize) st.st_size);
+    }
+
+  size = src->size;
+  if (offset >= size)
+    return GST_FLOW_EOS;
+
+  len = min ((gsize) length, size - (gsize) offset);
+  mmap_src_advise (src, (gsize) offset, len);
+
+  buf = gst_buffer_new_wrapped_full
+    (GST_MEMORY_FLAG_READONLY, region->data, region->size,
+     (gsize) offset, len, mmap_region_ref (region),
+     (GDestroyNotify) mmap_region_unref);
+  g_assert_nonnull (buf);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + len;
+  *buffer = buf;
+  src->next = offset + len;
+
+  return GST_FLOW_OK;
+#else
+  (void) basesrc;
+  (void) offset;
+  (void) length;
+  (void) buffer;
+  return GST_FLOW_ERROR;
+#endif
+}
+
+static void
+lp_mmap_src_class_init (lp_MmapSrcClass *cls)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseSrcClass *basesrc_class;
+
+  gobject_class = (GObjectClass *) cls;
+  gobject_class->finalize = lp_mmap_src_finalize;
+
+  element_class = (GstElementClass *) cls;
+  gst_element_class_add_static_pad_template (element_class,
+                                             &src_template);
+  gst_element_class_set_static_metadata
+    (element_class, "LibPlay memory-mapped file source", "Source/File",
+     "Read from a memory-mapped local file",
+     "PUC-Rio/Laboratorio TeleMidia");
+
+  basesrc_class = (GstBaseSrcClass *) cls;
+  basesrc_class->start = lp_mmap_src_start;
+  basesrc_class->stop = lp_mmap_src_stop;
+  basesrc_class->is_seekable = lp_mmap_src_is_seekable;
+  basesrc_class->get_size = lp_mmap_src_get_size;
+  basesrc_class->create = lp_mmap_src_create;
+}
+
+
+/* uri handler */
+
+static GstURIType
+lp_mmap_src_uri_get_type (arg_unused (GType type))
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+lp_mmap_src_uri_get_protocols (arg_unused (GType type))
+{
+  static const gchar *protocols[] = {MMAP_SRC_SCHEME, NULL};
+  return protocols;
+}
+
+static gchar *
+lp_mmap_src_uri_get_uri (GstURIHandler *handler)
+{
+  lp_MmapSrc *src;
+  gchar *uri;
+
+  src = LP_MMAP_SRC (handler);
+  src_lock (src);
+  uri = g_strdup (src->uri);
+  src_unlock (src);
+
+  return uri;
+}
+
+static gboolean
+lp_mmap_src_uri_set_uri (GstURIHandler *handler, const gchar *uri,
+                         GError **error)
+{
+  lp_MmapSrc *src;
+  gchar *filename;
+  GstState state;
+
+  src = LP_MMAP_SRC (handler);
+
+  GST_OBJECT_LOCK (src);
+  state = GST_STATE (src);
+  GST_OBJECT_UNLOCK (src);
+
+  if (unlikely (state != GST_STATE_READY && state != GST_STATE_NULL))
+    {
+      g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+                   "cannot change uri while element is running");
+      return FALSE;
+    }
+
+  filename = NULL;
+  if (g_str_has_prefix (uri, MMAP_SRC_SCHEME ":"))
+    {
+      gchar *file_uri;
+
+      file_uri = g_strconcat ("file", uri + strlen (MMAP_SRC_SCHEME),
+                              NULL);
+      filename = g_filename_from_uri (file_uri, NULL, NULL);
+      g_free (file_uri);
+    }
+  if (unlikely (filename == NULL))
+    {
+      g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+                   "invalid file uri: %s", uri);
+      return FALSE;
+    }
+
+  src_lock (src);
+  g_free (src->uri);
+  g_free (src->filename);
+  src->uri = g_strdup (uri);
+  src->filename = filename;
+  src_unlock (src);
+
+  return TRUE;
+}
+
+static void
+lp_mmap_src_uri_handler_init (gpointer g_iface,
+                              arg_unused (gpointer iface_data))
+{
+  GstURIHandlerInterface *iface;
+
+  iface = (GstURIHandlerInterface *) g_iface;
+  iface->get_type = lp_mmap_src_uri_get_type;
+  iface->get_protocols = lp_mmap_src_uri_get_protocols;
+  iface->get_uri = lp_mmap_src_uri_get_uri;
+  iface->set_uri = lp_mmap_src_uri_set_uri;
+}
+
+
+/* internal */
+
+/* Registers the memory-mapped file source.  It is not autoplugged, so
+   filesrc keeps handling file:// URIs outside LibPlay.  Does nothing if
+   mmap() is not available.  */
+
+void
+_lp_mmap_src_register (void)
+{
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+  g_assert (gst_element_register (NULL, MMAP_SRC_NAME, MMAP_SRC_RANK,
+                                  LP_TYPE_MMAP_SRC));
+#endif
+}
+
+/* Returns the URI through which uridecodebin reads @uri: file:// URIs are
+   rewritten to the private scheme of the memory-mapped source, when it is
+   available, and other URIs are copied.  */
+
+gchar *
+_lp_mmap_src_get_uri (const gchar *uri)
+{
+  g_assert_nonnull (uri);
+
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+  if (g_str_has_prefix (uri, "file:"))
+    return g_strconcat (MMAP_SRC_SCHEME, uri + strlen ("file"), NULL);
+#endif
+
+  return g_strdup (uri);
+}
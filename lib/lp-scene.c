@@ -18,6 +18,8 @@ along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include <config.h>
 #include "play-internal.h"
+
+#include <gst/app/gstappsink.h>
 PRAGMA_DIAG_IGNORE (-Wunused-macros)
 
 /* Scene state.  */
@@ -55,16 +57,49 @@ struct _lp_Scene
   lp_SceneState state;          /* current state */
   GList *events;                /* pending events */
   GList *children;              /* child media objects */
+  lp_ImageCache *image_cache;   /* decoded image cache */
+  lp_Trace *trace;              /* trace recorder (or NULL) */
+  guint events_pending;         /* number of pending events */
+  struct
+  {                             /* lock accounting: */
+    guint depth;                /* recursion depth */
+  } lock;
+  struct
+  {                             /* published on unlock (lock-free reads): */
+    gx_seqlock_t seq;           /* sync access to published fields */
+    lp_SceneState state;        /* current state */
+    GstClockTime offset;        /* start time offset */
+    gint width;                 /* cached width */
+    gint height;                /* cached height */
+    guint64 ticks;              /* total number of ticks */
+  } pub;
+  struct
+  {                             /* statistics (atomic): */
+    gsize frames_composed;      /* frames composed by video mixer */
+    gsize frames_dropped;       /* frames dropped by video sink */
+    gsize events_dispatched;    /* events queued */
+    gsize events_received;      /* events received */
+    gsize events_masked;        /* events discarded by mask */
+    gsize events_pending_max;   /* event queue high-water mark */
+    gsize media[LP_MEDIA_GROUP_NONE]; /* child media per state group */
+    guint64 lock_time;          /* time waiting for lock (nanoseconds) */
+    gsize lock_contended;       /* scene or media lock found taken */
+  } stats;
   struct
   {
     GstClockID id;              /* last clock id */
     GstClock *clock;            /* pipeline clock */
     GstClockTime offset;        /* start time offset */
+    GstNetTimeProvider *provider; /* network clock provider (or NULL) */
+    gboolean shared;            /* true if clock is another scene's */
   } clock;
   struct
   {
     GstElement *blank;          /* blank audio source */
+    GstBuffer *silence;         /* silence pushed by blank (if silent) */
     GstElement *mixer;          /* audio mixer */
+    GstElement *caps;           /* audio mixer output caps */
+    GstElement *tee;            /* audio output tee */
     GstElement *sink;           /* audio sink */
   } audio;
   struct
@@ -73,9 +108,23 @@ struct _lp_Scene
     GstElement *mixer;          /* video mixer */
     GstElement *text;           /* text overlay */
     GstElement *convert;        /* video convert */
+    GstElement *tee;            /* video output tee */
     GstElement *sink;           /* video sink */
   } video;
   struct
+  {                             /* shared-memory export: */
+    GstElement *queue;          /* export queue */
+    GstElement *convert;        /* export video convert */
+    GstElement *sink;           /* export app sink */
+    lp_ShmWriter *writer;       /* frame ring writer */
+  } shm;
+  struct
+  {                             /* additional outputs: */
+    GList *list;                /* attached outputs */
+    GList *pending;             /* detached outputs being drained */
+    guint last_id;              /* id of last output attached */
+  } output;
+  struct
   {
     gint mask;                  /* event mask */
     gint width;                 /* cached width */
@@ -91,14 +140,30 @@ struct _lp_Scene
     guint text_color;           /* cached text color */
     gchar *text_font;           /* cached text font */
     gboolean sync;              /* synchronous mode */
+    guint64 image_cache_budget; /* image cache budget (bytes) */
+    guint thread_budget;        /* total decoding threads (0=automatic) */
+    guint64 latency;            /* latency budget (0=automatic) */
+    gchar *trace_file;          /* trace output file */
+    gboolean headless;          /* headless mode */
+    gint audio_rate;            /* audio sample rate (0=negotiated) */
+    gint audio_channels;        /* audio channels (0=negotiated) */
+    gchar *audio_format;        /* audio sample format (NULL=negotiated) */
+    gint resample_quality;      /* audio resampler quality */
+    gchar *shm_export;          /* shared-memory export name */
+    guint shm_export_slots;     /* shared-memory export ring size */
+    gboolean shm_export_blocking; /* block instead of dropping frames */
+    gchar *net_clock_publish;   /* address to publish clock on */
+    gchar *net_clock_follow;    /* address of clock to follow */
+    gint net_clock_port;        /* network clock port */
   } prop;
 };
 
 /* Maps GStreamer elements to offsets in lp_Scene.  */
 static const gstx_eltmap_t lp_scene_eltmap[] = {
   {"pipeline",      offsetof (lp_Scene, pipeline)},
-  {"audiotestsrc",  offsetof (lp_Scene, audio.blank)},
   {"audiomixer",    offsetof (lp_Scene, audio.mixer)},
+  {"capsfilter",    offsetof (lp_Scene, audio.caps)},
+  {"tee",           offsetof (lp_Scene, audio.tee)},
   {"autoaudiosink", offsetof (lp_Scene, audio.sink)},
   {NULL, 0},
 };
@@ -108,10 +173,18 @@ static const gstx_eltmap_t lp_scene_eltmap_video[] = {
   {"compositor",    offsetof (lp_Scene, video.mixer)},
   {"textoverlay",   offsetof (lp_Scene, video.text)},
   {"videoconvert",  offsetof (lp_Scene, video.convert)},
+  {"tee",           offsetof (lp_Scene, video.tee)},
   {"xvimagesink",   offsetof (lp_Scene, video.sink)},
   {NULL, 0},
 };
 
+static const gstx_eltmap_t lp_scene_eltmap_shm[] = {
+  {"queue",         offsetof (lp_Scene, shm.queue)},
+  {"videoconvert",  offsetof (lp_Scene, shm.convert)},
+  {"appsink",       offsetof (lp_Scene, shm.sink)},
+  {NULL, 0},
+};
+
 /* Scene properties.  */
 enum
 {
@@ -130,15 +203,45 @@ enum
   PROP_TEXT_COLOR,
   PROP_TEXT_FONT,
   PROP_SYNCHRONOUS,
+  PROP_IMAGE_CACHE_BUDGET,
+  PROP_IMAGE_CACHE_SIZE,
+  PROP_THREAD_BUDGET,
+  PROP_LATENCY,
+  PROP_TRACE_FILE,
+  PROP_HEADLESS,
+  PROP_AUDIO_RATE,
+  PROP_AUDIO_CHANNELS,
+  PROP_AUDIO_FORMAT,
+  PROP_RESAMPLE_QUALITY,
+  PROP_SHM_EXPORT,
+  PROP_SHM_EXPORT_SLOTS,
+  PROP_SHM_EXPORT_BLOCKING,
+  PROP_NET_CLOCK_PUBLISH,
+  PROP_NET_CLOCK_FOLLOW,
+  PROP_NET_CLOCK_PORT,
+  PROP_CLOCK_SCENE,
   PROP_LAST
 };
 
+/* The "silence" wave of audiotestsrc.  */
+#define WAVE_SILENCE         4
+
+/* Format of the silence pushed by the blank audio source, for fields not
+   fixed by the scene audio properties.  */
+#define SILENCE_RATE         48000
+#define SILENCE_CHANNELS     2
+#define SILENCE_FORMAT       GST_AUDIO_NE (F32)
+#define SILENCE_SAMPLES      1024 /* samples per buffer */
+
+/* Time to wait for a snapshot to be converted.  */
+#define SNAPSHOT_TIMEOUT     (5 * GST_SECOND)
+
 /* Property defaults.  */
 #define DEFAULT_MASK         LP_EVENT_MASK_ANY /* any event */
 #define DEFAULT_WIDTH        0                 /* no video output */
 #define DEFAULT_HEIGHT       0                 /* no video output */
 #define DEFAULT_BACKGROUND   0                 /* transparent */
-#define DEFAULT_WAVE         4                 /* silence */
+#define DEFAULT_WAVE         WAVE_SILENCE      /* silence */
 #define DEFAULT_TICKS        0                 /* no ticks */
 #define DEFAULT_INTERVAL     GST_SECOND        /* one tick per second */
 #define DEFAULT_TIME         0                 /* zero nanoseconds */
@@ -148,14 +251,104 @@ enum
 #define DEFAULT_TEXT_COLOR   0xffffffff        /* white */
 #define DEFAULT_TEXT_FONT    NULL              /* not initialized */
 #define DEFAULT_SYNCHRONOUS  FALSE             /* synchronous mode */
+#define DEFAULT_IMAGE_CACHE_BUDGET (64 * 1024 * 1024) /* 64 MiB */
+#define DEFAULT_THREAD_BUDGET 0                /* automatic */
+#define DEFAULT_LATENCY      0                 /* automatic */
+#define DEFAULT_TRACE_FILE   NULL              /* no tracing */
+#define DEFAULT_HEADLESS     FALSE             /* real output devices */
+#define DEFAULT_AUDIO_RATE   0                 /* negotiated */
+#define DEFAULT_AUDIO_CHANNELS 0               /* negotiated */
+#define DEFAULT_AUDIO_FORMAT NULL              /* negotiated */
+#define DEFAULT_RESAMPLE_QUALITY 4             /* audioresample default */
+#define DEFAULT_SHM_EXPORT   NULL              /* no export */
+#define DEFAULT_SHM_EXPORT_SLOTS 4             /* four frames */
+#define DEFAULT_SHM_EXPORT_BLOCKING FALSE      /* drop frames */
+#define DEFAULT_NET_CLOCK_PUBLISH NULL         /* not published */
+#define DEFAULT_NET_CLOCK_FOLLOW NULL          /* local clock */
+#define DEFAULT_NET_CLOCK_PORT 0               /* any port */
 
 /* Define the lp_Scene type.  */
 GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
 
 
-/* Scene locking and unlocking.  */
-#define scene_lock(sc)    g_rec_mutex_lock (&(sc)->mutex)
-#define scene_unlock(sc)  g_rec_mutex_unlock (&(sc)->mutex)
+/* Scene statistics.  Counters are pointer-sized atomics, so that they
+   can be read without taking the scene lock.  */
+#define scene_stats_add(s, field, n)                            \
+  g_atomic_pointer_add (&(s)->stats.field, (gssize)(n))
+
+#define scene_stats_set(s, field, n)                            \
+  g_atomic_pointer_set (&(s)->stats.field, (gsize)(n))
+
+#define scene_stats_get(s, field)                               \
+  ((guint64)(gsize) g_atomic_pointer_get (&(s)->stats.field))
+
+/* The lock time counts nanoseconds, which overflow a 32-bit gsize after a
+   few seconds, so it is a 64-bit atomic.  */
+#define scene_stats_add_lock_time(s, n)                         \
+  gx_atomic_uint64_add (&(s)->stats.lock_time, (n))
+
+#define scene_stats_get_lock_time(s)                            \
+  gx_atomic_uint64_get (&(s)->stats.lock_time)
+
+/* Publishes the hot fields of scene @s, so that they can be read
+   without taking the scene lock.  Must be called with the lock held.  */
+#define scene_publish(s)                                        \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    gx_seqlock_write_begin (&(s)->pub.seq);                     \
+    (s)->pub.state = (s)->state;                                \
+    (s)->pub.offset = (s)->clock.offset;                        \
+    (s)->pub.width = (s)->prop.width;                           \
+    (s)->pub.height = (s)->prop.height;                         \
+    (s)->pub.ticks = (s)->prop.ticks;                           \
+    gx_seqlock_write_end (&(s)->pub.seq);                       \
+  }                                                             \
+  STMT_END
+
+/* Publishes the hot fields of scene @s only if some of them has changed
+   since they were last published, so that the many unlocks that change
+   nothing do not disturb the readers.  Must be called with the lock
+   held.  */
+#define scene_publish_changes(s)                                \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    if ((s)->pub.state != (s)->state                            \
+        || (s)->pub.offset != (s)->clock.offset                 \
+        || (s)->pub.width != (s)->prop.width                    \
+        || (s)->pub.height != (s)->prop.height                  \
+        || (s)->pub.ticks != (s)->prop.ticks)                   \
+      scene_publish ((s));                                      \
+  }                                                             \
+  STMT_END
+
+/* Scene locking and unlocking.  The uncontended path takes no time
+   sample: only when the lock is found taken is the time spent waiting
+   for it added to the scene statistics.  The hot fields are published
+   when the outermost lock is released, if they have changed.  */
+#define scene_lock(sc)                                          \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    if (!g_rec_mutex_trylock (&(sc)->mutex))                    \
+      {                                                         \
+        gint64 __since = g_get_monotonic_time ();               \
+        g_rec_mutex_lock (&(sc)->mutex);                        \
+        scene_stats_add ((sc), lock_contended, 1);              \
+        scene_stats_add_lock_time                               \
+          ((sc), (guint64)(g_get_monotonic_time () - __since)   \
+           * 1000);                                             \
+      }                                                         \
+    (sc)->lock.depth++;                                         \
+  }                                                             \
+  STMT_END
+
+#define scene_unlock(sc)                                        \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    if ((sc)->lock.depth > 0 && --(sc)->lock.depth == 0)        \
+      scene_publish_changes ((sc));                             \
+    g_rec_mutex_unlock (&(sc)->mutex);                          \
+  }                                                             \
+  STMT_END
 
 /* Scene state queries.  */
 #define scene_state_started(s)           ((s)->state == STARTED)
@@ -166,6 +359,15 @@ GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
 #define scene_state_disposed(s)          ((s)->state == DISPOSED)
 #define scene_state_started_or_paused(s) ((s)->state <= PAUSED)
 
+/* Sets the state of scene @s to @st and records the transition.  */
+#define scene_set_state(s, st)                                  \
+  STMT_BEGIN                                                    \
+  {                                                             \
+    scene_trace_state ((s), (s)->state, (st));                  \
+    (s)->state = (st);                                          \
+  }                                                             \
+  STMT_END
+
 
 /* Scene run-time data.  */
 #define scene_reset_run_time_data(s)            \
@@ -175,10 +377,17 @@ GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
     (s)->loop = NULL;                           \
     (s)->state = STOPPED;                       \
     (s)->events = NULL;                         \
+    (s)->events_pending = 0;                    \
     (s)->children = NULL;                       \
     (s)->clock.id = NULL;                       \
     (s)->clock.clock = NULL;                    \
     (s)->clock.offset = GST_CLOCK_TIME_NONE;    \
+    (s)->clock.provider = NULL;                 \
+    (s)->clock.shared = FALSE;                  \
+    (s)->audio.blank = NULL;                    \
+    (s)->audio.silence = NULL;                  \
+    (s)->shm.writer = NULL;                     \
+    (s)->output.pending = NULL;                 \
   }                                             \
   STMT_END
 
@@ -191,7 +400,19 @@ GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
     g_list_free_full ((s)->events, (GDestroyNotify) g_object_unref);    \
     if (scene->clock.id != NULL)                                        \
       gst_clock_id_unref ((s)->clock.id);                               \
+    if ((s)->clock.provider != NULL)                                    \
+      gst_object_unref ((s)->clock.provider);                           \
     g_object_unref ((s)->clock.clock);                                  \
+    if ((s)->audio.silence != NULL)                                     \
+      gst_buffer_unref ((s)->audio.silence);                            \
+    if ((s)->shm.writer != NULL)                                        \
+      _lp_shm_writer_free ((s)->shm.writer);                            \
+    g_list_foreach ((s)->output.list, (GFunc) scene_output_unplugged,   \
+                    NULL);                                              \
+    g_list_foreach ((s)->output.pending,                                \
+                    (GFunc) scene_output_unplugged, NULL);              \
+    g_list_free_full ((s)->output.pending,                              \
+                      (GDestroyNotify) scene_output_free);              \
     scene_reset_run_time_data ((s));                                    \
   }                                                                     \
   STMT_END
@@ -214,6 +435,21 @@ GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
     (s)->prop.text_color = DEFAULT_TEXT_COLOR;          \
     (s)->prop.text_font = DEFAULT_TEXT_FONT;            \
     (s)->prop.sync = DEFAULT_SYNCHRONOUS;               \
+    (s)->prop.image_cache_budget = DEFAULT_IMAGE_CACHE_BUDGET;\
+    (s)->prop.thread_budget = DEFAULT_THREAD_BUDGET;    \
+    (s)->prop.latency = DEFAULT_LATENCY;                \
+    (s)->prop.trace_file = DEFAULT_TRACE_FILE;          \
+    (s)->prop.headless = DEFAULT_HEADLESS;              \
+    (s)->prop.audio_rate = DEFAULT_AUDIO_RATE;          \
+    (s)->prop.audio_channels = DEFAULT_AUDIO_CHANNELS;  \
+    (s)->prop.audio_format = DEFAULT_AUDIO_FORMAT;      \
+    (s)->prop.resample_quality = DEFAULT_RESAMPLE_QUALITY;\
+    (s)->prop.shm_export = DEFAULT_SHM_EXPORT;          \
+    (s)->prop.shm_export_slots = DEFAULT_SHM_EXPORT_SLOTS;\
+    (s)->prop.shm_export_blocking = DEFAULT_SHM_EXPORT_BLOCKING;\
+    (s)->prop.net_clock_publish = DEFAULT_NET_CLOCK_PUBLISH;\
+    (s)->prop.net_clock_follow = DEFAULT_NET_CLOCK_FOLLOW;\
+    (s)->prop.net_clock_port = DEFAULT_NET_CLOCK_PORT;  \
   }                                                     \
   STMT_END
 
@@ -222,9 +458,60 @@ GX_DEFINE_TYPE (lp_Scene, lp_scene, G_TYPE_OBJECT)
   {                                             \
     g_free ((s)->prop.text);                    \
     g_free ((s)->prop.text_font);               \
+    g_free ((s)->prop.trace_file);              \
+    g_free ((s)->prop.audio_format);            \
+    g_free ((s)->prop.shm_export);              \
+    g_free ((s)->prop.net_clock_publish);       \
+    g_free ((s)->prop.net_clock_follow);        \
   }                                             \
   STMT_END
 
+/* Scene state names, indexed by lp_SceneState.  */
+static const gchar *scene_state_names[] = {
+  "started",
+  "paused",
+  "starting",
+  "stopped",
+  "stopping",
+  "disposed",
+};
+
+/* Records the transition of @scene from state @from to state @to into
+   the scene trace.  Transient states and the paused state are recorded as
+   spans.  */
+
+static void
+scene_trace_state (lp_Scene *scene, lp_SceneState from, lp_SceneState to)
+{
+  if (likely (scene->trace == NULL) || from == to)
+    return;                     /* nothing to do */
+
+  switch (from)
+    {
+    case STARTING:              /* fall through */
+    case STOPPING:              /* fall through */
+    case PAUSED:
+      _lp_trace_end (scene->trace, "scene", scene_state_names[from], scene);
+      break;
+    default:
+      break;
+    }
+
+  switch (to)
+    {
+    case STARTING:              /* fall through */
+    case STOPPING:              /* fall through */
+    case PAUSED:
+      _lp_trace_begin (scene->trace, "scene", scene_state_names[to],
+                       scene, NULL);
+      break;
+    default:
+      _lp_trace_instant (scene->trace, "scene", scene_state_names[to],
+                         scene, NULL);
+      break;
+    }
+}
+
 /* Forward declarations.  */
 
 static ATTR_USE_RESULT gboolean scene_step_unlocked (lp_Scene *, gboolean);
@@ -234,6 +521,10 @@ static gint lp_scene_tick_callback (GstClock *, GstClockTime, GstClockID,
 
 static gboolean lp_scene_bus_callback (GstBus *, GstMessage *, lp_Scene *);
 
+static GstPadProbeReturn lp_scene_mixer_probe_callback (GstPad *,
+                                                        GstPadProbeInfo *,
+                                                        lp_Scene *);
+
 static gboolean lp_scene_has_started (lp_Scene *);
 
 /* Enslaves @scene's audio sink clock to @scene clock.  */
@@ -249,7 +540,11 @@ scene_enslave_audio_clock (lp_Scene *scene)
 
   sink = _lp_scene_get_real_audio_sink (scene);
   g_assert_nonnull (sink);
-  g_assert (GST_IS_AUDIO_BASE_SINK (sink));
+  if (unlikely (!GST_IS_AUDIO_BASE_SINK (sink)))
+    {
+      gst_object_unref (sink);
+      return;                   /* headless, no audio clock */
+    }
 
   GST_OBJECT_FLAG_SET (GST_OBJECT (sink), GST_CLOCK_FLAG_CAN_SET_MASTER);
 
@@ -263,6 +558,17 @@ scene_enslave_audio_clock (lp_Scene *scene)
   gst_object_unref (sink);
 }
 
+/* Applies the latency budget of @scene to its pipeline.  A zero budget
+   lets the pipeline compute its latency from the latency query.  */
+
+static void
+scene_update_latency (lp_Scene *scene)
+{
+  gst_pipeline_set_latency (GST_PIPELINE (scene->pipeline),
+                            (scene->prop.latency > 0)
+                            ? scene->prop.latency : GST_CLOCK_TIME_NONE);
+}
+
 /* Returns the real sink (determined by @offset) of @scene.  */
 
 static ATTR_USE_RESULT GstElement *
@@ -329,6 +635,610 @@ done:
 }
 
 
+/* Returns the caps of @scene audio mixer output as determined by its
+   audio properties; fields whose property is not set are left to
+   negotiation.  If @fixed is %TRUE, returns NULL unless all fields are
+   set.  */
+
+static GstCaps *
+scene_get_audio_caps (lp_Scene *scene, gboolean fixed)
+{
+  GstCaps *caps;
+
+  if (fixed && (scene->prop.audio_rate == 0
+                || scene->prop.audio_channels == 0
+                || scene->prop.audio_format == NULL))
+    return NULL;                /* not pinned */
+
+  caps = gst_caps_new_simple ("audio/x-raw",
+                              "layout", G_TYPE_STRING, "interleaved",
+                              NULL);
+  g_assert_nonnull (caps);
+
+  if (scene->prop.audio_rate > 0)
+    gst_caps_set_simple (caps, "rate", G_TYPE_INT,
+                         scene->prop.audio_rate, NULL);
+  if (scene->prop.audio_channels > 0)
+    gst_caps_set_simple (caps, "channels", G_TYPE_INT,
+                         scene->prop.audio_channels, NULL);
+  if (scene->prop.audio_format != NULL)
+    gst_caps_set_simple (caps, "format", G_TYPE_STRING,
+                         scene->prop.audio_format, NULL);
+
+  return caps;
+}
+
+/* Applies the audio properties of @scene to its audio mixer output, so
+   that the mixer does not renegotiate as media with different formats
+   join.  */
+
+static void
+scene_update_audio_caps (lp_Scene *scene)
+{
+  GstCaps *caps;
+
+  caps = scene_get_audio_caps (scene, FALSE);
+  g_assert_nonnull (caps);
+  g_object_set (scene->audio.caps, "caps", caps, NULL);
+  gst_caps_unref (caps);
+}
+
+/* Signals that the blank audio source needs data.  Here we push a new
+   buffer that shares the memory of the zeroed @silence buffer, which is
+   flagged as a gap so that the audio mixer skips it, and whose timestamp
+   is that of the next buffer.  This runs in the source streaming thread
+   and must not lock the scene.  */
+
+static void
+lp_scene_silence_need_data_callback (GstElement *src,
+                                     arg_unused (guint size),
+                                     GstBuffer *silence)
+{
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+
+  buffer = gst_buffer_copy (silence); /* shares memory */
+  g_assert_nonnull (buffer);
+  GST_BUFFER_PTS (silence) += GST_BUFFER_DURATION (silence);
+
+  g_signal_emit_by_name (src, "push-buffer", buffer, &ret);
+  gst_buffer_unref (buffer);
+}
+
+/* Creates the blank audio source of @scene.  If the scene wave is silence,
+   the source is an appsrc that pushes gap buffers; otherwise, it is an
+   audiotestsrc that generates the wave.  */
+
+static GstElement *
+scene_make_audio_blank (lp_Scene *scene)
+{
+  GstElement *blank;
+  GstAudioInfo info;
+  GstCaps *caps;
+  gsize size;
+
+  if (scene->prop.wave != WAVE_SILENCE)
+    {
+      blank = gst_element_factory_make ("audiotestsrc", NULL);
+      if (unlikely (blank == NULL))
+        _lp_error ("missing GStreamer plugin: %s", "audiotestsrc");
+      g_object_set (blank, "wave", scene->prop.wave, NULL);
+      return blank;
+    }
+
+  blank = gst_element_factory_make ("appsrc", NULL);
+  if (unlikely (blank == NULL))
+    _lp_error ("missing GStreamer plugin: %s", "appsrc");
+
+  caps = gst_caps_new_simple
+    ("audio/x-raw",
+     "format", G_TYPE_STRING, (scene->prop.audio_format != NULL)
+     ? scene->prop.audio_format : SILENCE_FORMAT,
+     "rate", G_TYPE_INT, (scene->prop.audio_rate > 0)
+     ? scene->prop.audio_rate : SILENCE_RATE,
+     "channels", G_TYPE_INT, (scene->prop.audio_channels > 0)
+     ? scene->prop.audio_channels : SILENCE_CHANNELS,
+     "layout", G_TYPE_STRING, "interleaved",
+     NULL);
+  g_assert_nonnull (caps);
+  g_assert (gst_audio_info_from_caps (&info, caps));
+
+  g_assert_null (scene->audio.silence);
+  size = (gsize) GST_AUDIO_INFO_BPF (&info) * SILENCE_SAMPLES;
+  scene->audio.silence = gst_buffer_new_allocate (NULL, size, NULL);
+  g_assert_nonnull (scene->audio.silence);
+  gst_buffer_memset (scene->audio.silence, 0, 0, size);
+  GST_BUFFER_FLAG_SET (scene->audio.silence, GST_BUFFER_FLAG_GAP);
+  GST_BUFFER_DURATION (scene->audio.silence) = gst_util_uint64_scale_int
+    (SILENCE_SAMPLES, GST_SECOND, GST_AUDIO_INFO_RATE (&info));
+  GST_BUFFER_PTS (scene->audio.silence) = 0;
+
+  g_object_set (blank,
+                "caps", caps,
+                "format", GST_FORMAT_TIME,
+                NULL);
+  gst_caps_unref (caps);
+  g_signal_connect (blank, "need-data",
+                    G_CALLBACK (lp_scene_silence_need_data_callback),
+                    scene->audio.silence);
+
+  return blank;
+}
+
+/* Applies the wave of @scene to its blank audio source.  If the wave has
+   changed from or to silence, replaces the source: the new source is
+   linked to the mixer at the current running time before the old one is
+   released.  */
+
+static void
+scene_update_audio_blank (lp_Scene *scene)
+{
+  GstElement *old;
+  GstBuffer *silence;
+  GstPad *src;
+  GstPad *sink;
+
+  if ((scene->prop.wave == WAVE_SILENCE) == (scene->audio.silence != NULL))
+    {
+      if (scene->audio.silence == NULL)
+        g_object_set (scene->audio.blank, "wave", scene->prop.wave, NULL);
+      return;                   /* same kind of source */
+    }
+
+  old = scene->audio.blank;
+  silence = scene->audio.silence;
+  scene->audio.silence = NULL;
+
+  scene->audio.blank = scene_make_audio_blank (scene);
+  gstx_bin_add (scene->pipeline, scene->audio.blank);
+  src = gst_element_get_static_pad (scene->audio.blank, "src");
+  g_assert_nonnull (src);
+  gst_pad_set_offset (src, (gint64) _lp_scene_get_running_time (scene));
+  gst_object_unref (src);
+  gstx_element_link (scene->audio.blank, scene->audio.mixer);
+  gstx_element_sync_state_with_parent (scene->audio.blank);
+
+  src = gst_element_get_static_pad (old, "src");
+  g_assert_nonnull (src);
+  sink = gst_pad_get_peer (src);
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_unlink (src, sink));
+  gst_element_release_request_pad (scene->audio.mixer, sink);
+  gst_object_unref (sink);
+  gst_object_unref (src);
+  gstx_element_set_state (old, GST_STATE_NULL);
+  gstx_bin_remove (scene->pipeline, old);
+
+  if (silence != NULL)
+    gst_buffer_unref (silence);
+}
+
+/* Replaces the sink pointed by @sink with a fake sink that consumes
+   buffers in sync with the pipeline clock.  */
+
+static void
+scene_make_headless_sink (GstElement **sink)
+{
+  gst_object_unref (*sink);
+  *sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert_nonnull (*sink);
+  g_object_set (*sink,
+                "sync", TRUE,
+                "enable-last-sample", TRUE,
+                NULL);
+}
+
+/* Copies each frame of the export branch of a scene into the
+   shared-memory ring @writer.  Runs in the export streaming thread.  */
+
+static GstFlowReturn
+lp_scene_shm_new_sample_callback (GstAppSink *sink, lp_ShmWriter *writer)
+{
+  GstSample *sample;
+  GstBuffer *buffer;
+
+  sample = gst_app_sink_pull_sample (sink);
+  if (unlikely (sample == NULL))
+    return GST_FLOW_EOS;
+
+  buffer = gst_sample_get_buffer (sample);
+  g_assert_nonnull (buffer);
+  _lp_shm_writer_write (writer, buffer, GST_BUFFER_PTS (buffer));
+  gst_sample_unref (sample);
+
+  return GST_FLOW_OK;
+}
+
+/* Creates the shared-memory ring of @scene and links the export branch
+   to its video output tee.  Under the drop policy, the export queue is
+   leaky, so that a slow export never stalls the sink.  Does nothing if
+   the ring cannot be created.  */
+
+static void
+scene_add_shm_export (lp_Scene *scene)
+{
+  GstAppSinkCallbacks callbacks;
+  GstCaps *caps;
+
+  g_assert_null (scene->shm.writer);
+  scene->shm.writer = _lp_shm_writer_new
+    (scene->prop.shm_export, scene->prop.shm_export_slots,
+     scene->prop.width, scene->prop.height,
+     scene->prop.shm_export_blocking);
+  if (unlikely (scene->shm.writer == NULL))
+    return;                     /* nothing to do */
+
+  _lp_eltmap_alloc_check (scene, lp_scene_eltmap_shm);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+                              "format", G_TYPE_STRING, "BGRA",
+                              "width", G_TYPE_INT, scene->prop.width,
+                              "height", G_TYPE_INT, scene->prop.height,
+                              NULL);
+  g_assert_nonnull (caps);
+  g_object_set (scene->shm.sink, "caps", caps, "sync", FALSE,
+                "async", FALSE, "enable-last-sample", FALSE, NULL);
+  gst_caps_unref (caps);
+
+  memset (&callbacks, 0, sizeof (callbacks));
+  callbacks.new_sample = (GstFlowReturn (*)(GstAppSink *, gpointer))
+    lp_scene_shm_new_sample_callback;
+  gst_app_sink_set_callbacks (GST_APP_SINK (scene->shm.sink), &callbacks,
+                              scene->shm.writer, NULL);
+
+  if (!scene->prop.shm_export_blocking)
+    g_object_set (scene->shm.queue, "leaky", 2, /* downstream */
+                  "max-size-buffers", 1, "max-size-bytes", 0,
+                  "max-size-time", (guint64) 0, NULL);
+
+  gstx_bin_add (scene->pipeline, scene->shm.queue);
+  gstx_bin_add (scene->pipeline, scene->shm.convert);
+  gstx_bin_add (scene->pipeline, scene->shm.sink);
+  gstx_element_link (scene->video.tee, scene->shm.queue);
+  gstx_element_link (scene->shm.queue, scene->shm.convert);
+  gstx_element_link (scene->shm.convert, scene->shm.sink);
+}
+
+/* True if @scene publishes or follows a network clock.  */
+#define scene_has_net_clock(s)\
+  ((s)->prop.net_clock_publish != NULL || (s)->prop.net_clock_follow != NULL)
+
+/* Signals that the network clock followed by @scene has gained or lost
+   synchronization.  */
+
+static void
+lp_scene_net_clock_synced_callback (arg_unused (GstClock *remote),
+                                    gboolean synced, lp_Scene *scene)
+{
+  _lp_debug ("%p network clock %s", scene, synced ? "synced" : "unsynced");
+  _lp_trace_instant (scene->trace, "scene", synced
+                     ? "net-clock-synced" : "net-clock-unsynced",
+                     scene, NULL);
+}
+
+/* Publishes the clock of @scene on the network, or makes it follow a
+   published clock, as requested by the scene properties.  A followed
+   clock is not waited for: the scene starts at once and its clock
+   converges to the followed one as the network clock synchronizes.  If
+   the clock cannot be published, the "net-clock-publish" property is
+   cleared.  A scene that shares the clock of another scene (cf. property
+   "clock-scene") can neither publish nor follow a network clock, as that
+   belongs to the scene that owns the clock; in this case, both network
+   clock properties are cleared.  */
+
+static void
+scene_setup_net_clock (lp_Scene *scene)
+{
+  GstClock *remote;
+  const gchar *address;
+  gint port;
+
+  if (unlikely (scene->clock.shared))
+    {
+      _lp_warn ("cannot use a network clock in %p: "
+                "its clock belongs to another scene", scene);
+      g_clear_pointer (&scene->prop.net_clock_publish, g_free);
+      g_clear_pointer (&scene->prop.net_clock_follow, g_free);
+      return;
+    }
+
+  port = scene->prop.net_clock_port;
+  if (scene->prop.net_clock_publish != NULL)
+    {
+      address = scene->prop.net_clock_publish;
+      scene->clock.provider = gst_net_time_provider_new
+        (scene->clock.clock, address, port);
+      if (unlikely (scene->clock.provider == NULL))
+        {
+          _lp_warn ("cannot publish scene clock on %s:%d", address, port);
+          g_free (scene->prop.net_clock_publish);
+          scene->prop.net_clock_publish = NULL;
+          return;
+        }
+      g_object_get (scene->clock.provider, "port",
+                    &scene->prop.net_clock_port, NULL);
+      return;
+    }
+
+  if (unlikely (port == 0))
+    {
+      _lp_warn ("cannot follow network clock: no port given");
+      return;
+    }
+
+  address = scene->prop.net_clock_follow;
+  remote = gst_net_client_clock_new (NULL, address, port, 0);
+  g_assert_nonnull (remote);
+  g_signal_connect_object (remote, "synced",
+                           G_CALLBACK (lp_scene_net_clock_synced_callback),
+                           scene, (GConnectFlags) 0);
+
+  if (unlikely (!_lp_clock_set_source (LP_CLOCK (scene->clock.clock),
+                                       remote)))
+    {
+      _lp_warn ("cannot follow network clock: scene clock in use");
+      g_clear_pointer (&scene->prop.net_clock_follow, g_free);
+    }
+  gst_object_unref (remote);
+}
+
+
+/* Sends a step of @time nanoseconds to the sinks of @scene, whose clock
+   has already been advanced.  Returns the number of sinks that will
+   report the step.  */
+
+static guint
+scene_step_begin (lp_Scene *scene, GstClockTime time)
+{
+  guint sinks = 1;
+
+  gst_element_send_event (scene->audio.sink,
+      gst_event_new_step (GST_FORMAT_TIME, time, 1.0, TRUE, FALSE));
+
+  if (_lp_scene_has_video (scene))
+  {
+    sinks++;
+    gst_element_send_event (scene->video.sink,
+        gst_event_new_step (GST_FORMAT_TIME, time, 1.0, TRUE, FALSE));
+  }
+
+  return sinks;
+}
+
+/* Waits until @sinks sinks of @scene have completed their step,
+   dispatching the messages popped from @scene @bus meanwhile, then
+   restores the bus watch of @scene and releases @bus.  The bus watch must
+   have been removed before the step was started.  */
+
+static void
+scene_step_finish (lp_Scene *scene, GstBus *bus, guint sinks)
+{
+  gboolean stepdone = FALSE;
+
+  while (!stepdone)
+  {
+    GstMessage *msg = gst_bus_timed_pop (bus, GST_CLOCK_TIME_NONE);
+
+    stepdone = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STEP_DONE &&
+      (--sinks, sinks == 0);
+    lp_scene_bus_callback (bus, msg, scene);
+    gst_message_unref(msg);
+  }
+
+  g_assert (gst_bus_add_watch (bus,
+        (GstBusFunc) lp_scene_bus_callback, scene) > 0);
+  _lp_debug ("advance: step done");
+  gst_object_unref (bus);
+}
+
+
+/* Scene outputs.  An output is a bin attached to the video or audio
+   output tee of a scene, behind a leaky queue.  Outputs persist across
+   scene restarts; their elements exist only while the scene runs.  */
+typedef struct _lp_SceneOutput
+{
+  guint id;                     /* output id */
+  lp_OutputType type;           /* output type */
+  gchar *description;           /* output bin description */
+  GstElement *queue;            /* leaky queue (while running) */
+  GstElement *bin;              /* output bin (while running) */
+  GstPad *pad;                  /* tee source pad (while running) */
+  guint sinks;                  /* sinks yet to get EOS (while removing) */
+} lp_SceneOutput;
+
+static void
+scene_output_free (lp_SceneOutput *output)
+{
+  g_assert_null (output->pad);
+  g_free (output->description);
+  g_free (output);
+}
+
+/* Forgets the elements of @output after its pipeline has been
+   disposed.  */
+
+static void
+scene_output_unplugged (lp_SceneOutput *output)
+{
+  if (output->pad != NULL)
+    gst_object_unref (output->pad);
+  output->queue = NULL;
+  output->bin = NULL;
+  output->pad = NULL;
+}
+
+/* Creates the elements of @output and links them to the output tee of
+   @scene.  Returns true if successful, or false if the description of
+   @output is invalid.  */
+
+static gboolean
+scene_output_plug (lp_Scene *scene, lp_SceneOutput *output)
+{
+  GstElement *tee;
+  GstPad *sink;
+  GError *error = NULL;
+  gchar *desc;
+
+  g_assert_null (output->pad);
+
+  tee = (output->type == LP_OUTPUT_VIDEO)
+    ? scene->video.tee : scene->audio.tee;
+  g_assert_nonnull (tee);
+
+  desc = g_strdup_printf ("%s ! %s", (output->type == LP_OUTPUT_VIDEO)
+                          ? "videoconvert"
+                          : "audioconvert ! audioresample",
+                          output->description);
+  output->bin = gst_parse_bin_from_description (desc, TRUE, &error);
+  g_free (desc);
+  if (unlikely (error != NULL))
+    {
+      _lp_warn ("bad output '%s': %s", output->description,
+                error->message);
+      g_error_free (error);
+      if (output->bin != NULL)
+        gst_object_unref (output->bin);
+      output->bin = NULL;
+      return FALSE;
+    }
+  g_assert_nonnull (output->bin);
+
+  /* Forward the EOS of each sink, so that the scene can tell when the
+     output has been drained.  */
+  g_object_set (output->bin, "message-forward", TRUE, NULL);
+
+  output->queue = gst_element_factory_make ("queue", NULL);
+  g_assert_nonnull (output->queue);
+  g_object_set (output->queue, "leaky", 2, NULL); /* downstream */
+
+  gstx_bin_add (scene->pipeline, output->queue);
+  gstx_bin_add (scene->pipeline, output->bin);
+  gstx_element_link (output->queue, output->bin);
+
+  output->pad = gst_element_get_request_pad (tee, "src_%u");
+  g_assert_nonnull (output->pad);
+  sink = gst_element_get_static_pad (output->queue, "sink");
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_link (output->pad, sink) == GST_PAD_LINK_OK);
+  gst_object_unref (sink);
+
+  if (!scene_state_stopped (scene))
+    {
+      gstx_element_sync_state_with_parent (output->bin);
+      gstx_element_sync_state_with_parent (output->queue);
+    }
+
+  return TRUE;
+}
+
+/* Returns the number of sinks in the bin of @output.  */
+
+static guint
+scene_output_count_sinks (lp_SceneOutput *output)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gboolean done;
+  guint n;
+
+  it = gst_bin_iterate_sinks (GST_BIN (output->bin));
+  g_assert_nonnull (it);
+
+  n = 0;
+  done = FALSE;
+  while (!done)
+    {
+      switch (gst_iterator_next (it, &item))
+        {
+        case GST_ITERATOR_OK:
+          n++;
+          g_value_reset (&item);
+          break;
+        case GST_ITERATOR_RESYNC:
+          gst_iterator_resync (it);
+          n = 0;
+          break;
+        case GST_ITERATOR_ERROR:  /* fall through */
+        case GST_ITERATOR_DONE:
+          done = TRUE;
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+    }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return n;
+}
+
+/* Unlinks @output from its tee once the tee source pad @pad is idle, and
+   sends EOS into it, so that muxers can finish their files.  The output
+   is torn down by the bus callback, once its sinks have received EOS.
+   Does not take the scene lock.  */
+
+static GstPadProbeReturn
+lp_scene_output_idle_probe_callback (GstPad *pad,
+                                     arg_unused (GstPadProbeInfo *info),
+                                     lp_SceneOutput *output)
+{
+  GstPad *sink;
+
+  sink = gst_element_get_static_pad (output->queue, "sink");
+  g_assert_nonnull (sink);
+  g_assert (gst_pad_unlink (pad, sink));
+  gst_pad_send_event (sink, gst_event_new_eos ());
+  gst_object_unref (sink);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Signals that a sink in the output bin @bin of @scene has received EOS.
+   Once all of them have, releases the tee pad of the output, disposes its
+   elements, and frees it.  Does nothing if @bin is not the bin of an
+   output being removed.  */
+
+static void
+scene_output_sink_eos (lp_Scene *scene, GstObject *bin)
+{
+  lp_SceneOutput *output = NULL;
+  GstElement *tee;
+  GList *l;
+
+  scene_lock (scene);
+
+  for (l = scene->output.pending; l != NULL; l = l->next)
+    {
+      if ((GstObject *) ((lp_SceneOutput *) l->data)->bin == bin)
+        {
+          output = (lp_SceneOutput *) l->data;
+          break;
+        }
+    }
+
+  if (output == NULL || (output->sinks > 0 && --output->sinks > 0))
+    {
+      scene_unlock (scene);
+      return;                   /* nothing to do */
+    }
+
+  scene->output.pending = g_list_delete_link (scene->output.pending, l);
+
+  tee = gst_pad_get_parent_element (output->pad);
+  g_assert_nonnull (tee);
+  gst_element_release_request_pad (tee, output->pad);
+  gst_object_unref (tee);
+
+  gstx_element_set_state_sync (output->queue, GST_STATE_NULL);
+  gstx_element_set_state_sync (output->bin, GST_STATE_NULL);
+  gstx_bin_remove (scene->pipeline, output->queue);
+  gstx_bin_remove (scene->pipeline, output->bin);
+  scene_output_unplugged (output);
+  scene_output_free (output);
+
+  scene_unlock (scene);
+}
+
 /* Creates scene pipeline and starts @scene.
    Returns %TRUE if successful, or %FALSE otherwise.
 
@@ -339,6 +1249,8 @@ scene_start_unlocked (lp_Scene *scene)
 {
   GstElement *pipeline;
   GstBus *bus;
+  GstPad *pad;
+  GList *l;
   gulong id;
   gboolean done;
   gboolean syncmode;
@@ -351,9 +1263,19 @@ scene_start_unlocked (lp_Scene *scene)
     goto fail;                  /* nothing to do */
 
   _lp_eltmap_alloc_check (scene, lp_scene_eltmap);
+  if (scene->prop.headless)
+    scene_make_headless_sink (&scene->audio.sink);
 
   gst_pipeline_set_clock (GST_PIPELINE(scene->pipeline),
       scene->clock.clock);
+  if (scene_has_net_clock (scene))
+    {
+      /* Running time is clock time, so that it agrees across all
+         scenes that share the clock.  */
+      gst_element_set_start_time (scene->pipeline, GST_CLOCK_TIME_NONE);
+      gst_element_set_base_time (scene->pipeline, 0);
+    }
+  scene_update_latency (scene);
 
   pipeline = scene->pipeline;
   g_assert_nonnull (pipeline);
@@ -367,18 +1289,25 @@ scene_start_unlocked (lp_Scene *scene)
   g_assert (id > 0);
   gst_object_unref (bus);
 
+  scene->audio.blank = scene_make_audio_blank (scene);
   gstx_bin_add (pipeline, scene->audio.blank);
   gstx_bin_add (pipeline, scene->audio.mixer);
+  gstx_bin_add (pipeline, scene->audio.caps);
+  gstx_bin_add (pipeline, scene->audio.tee);
   gstx_bin_add (pipeline, scene->audio.sink);
   gstx_element_link (scene->audio.blank, scene->audio.mixer);
-  gstx_element_link (scene->audio.mixer, scene->audio.sink);
-  g_object_set (scene->audio.blank, "wave", scene->prop.wave, NULL);
+  gstx_element_link (scene->audio.mixer, scene->audio.caps);
+  gstx_element_link (scene->audio.caps, scene->audio.tee);
+  gstx_element_link (scene->audio.tee, scene->audio.sink);
+  scene_update_audio_caps (scene);
 
   if (_lp_scene_has_video (scene))
   {
     GstCaps *caps;
 
     _lp_eltmap_alloc_check (scene, lp_scene_eltmap_video);
+    if (scene->prop.headless)
+      scene_make_headless_sink (&scene->video.sink);
 
     caps = gst_caps_new_simple ("video/x-raw",
         "format", G_TYPE_STRING, "ARGB",
@@ -398,19 +1327,39 @@ scene_start_unlocked (lp_Scene *scene)
     gstx_bin_add (pipeline, scene->video.mixer);
     gstx_bin_add (pipeline, scene->video.text);
     gstx_bin_add (pipeline, scene->video.convert);
+    gstx_bin_add (pipeline, scene->video.tee);
     gstx_bin_add (pipeline, scene->video.sink);
     gstx_element_link (scene->video.blank, scene->video.mixer);
     gstx_element_link (scene->video.mixer, scene->video.text);
     gstx_element_link (scene->video.text, scene->video.convert);
-    gstx_element_link (scene->video.convert, scene->video.sink);
+    gstx_element_link (scene->video.convert, scene->video.tee);
+    gstx_element_link (scene->video.tee, scene->video.sink);
+    if (scene->prop.shm_export != NULL)
+      scene_add_shm_export (scene);
 
     g_object_set (scene->video.mixer,
         "background", scene->prop.background, NULL);
+
+    pad = gst_element_get_static_pad (scene->video.mixer, "src");
+    g_assert_nonnull (pad);
+    id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) lp_scene_mixer_probe_callback, scene, NULL);
+    g_assert (id > 0);
+    gst_object_unref (pad);
     g_signal_connect (scene->video.blank, "need-data",
         G_CALLBACK (_lp_common_appsrc_transparent_data), scene);
   }
 
-  scene->state = STARTING;
+  for (l = scene->output.list; l != NULL; l = l->next)
+    {
+      lp_SceneOutput *output = (lp_SceneOutput *) l->data;
+
+      if (output->type == LP_OUTPUT_VIDEO && !_lp_scene_has_video (scene))
+        continue;               /* no video tee */
+      scene_output_plug (scene, output);
+    }
+
+  scene_set_state (scene, STARTING);
 
   syncmode = scene->prop.sync;
 
@@ -468,7 +1417,7 @@ scene_start_unlocked_finish (lp_Scene *scene)
   lp_Event *event;
   scene_lock (scene);
 
-  scene->state = STARTED;
+  scene_set_state (scene, STARTED);
 
   if (scene->prop.slave_audio)
     scene_enslave_audio_clock (scene);
@@ -513,11 +1462,15 @@ scene_stop_unlocked (lp_Scene *scene)
   g_assert (gst_bus_remove_watch (bus));
   gst_object_unref (bus);
 
-  scene->state = STOPPING;
+  if (scene->shm.writer != NULL) /* unblock export */
+    _lp_shm_writer_set_flushing (scene->shm.writer, TRUE);
+
+  scene_set_state (scene, STOPPING);
   scene_unlock (scene);
   gstx_element_set_state_sync (pipeline, GST_STATE_NULL);
   scene_lock (scene);
 
+  scene_set_state (scene, STOPPED);
   scene_release_run_time_data (scene);
   scene_unlock (scene);
   return TRUE;
@@ -622,6 +1575,17 @@ fail:
   return FALSE;
 }
 
+/* Signals that the video mixer has composed a frame.  */
+
+static GstPadProbeReturn
+lp_scene_mixer_probe_callback (arg_unused (GstPad *pad),
+                               arg_unused (GstPadProbeInfo *info),
+                               lp_Scene *scene)
+{
+  scene_stats_add (scene, frames_composed, 1);
+  return GST_PAD_PROBE_OK;
+}
+
 /* Signals that scene pipeline has received a message.  */
 
 static gboolean
@@ -639,6 +1603,7 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
       const GstStructure *st;
       lp_Event *event;
       lp_EventMask mask;
+      gboolean internal = FALSE;
 
       st = gst_message_get_structure (msg);
       g_assert_nonnull (st);
@@ -763,8 +1728,16 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
               _lp_media_finish_error (media);
               break;
             case LP_EVENT_MASK_START:
-              _lp_media_finish_start (media);
+            {
+              gboolean resume;
+
+              g_object_get (event, "resume", &resume, NULL);
+              if (resume)
+                _lp_media_finish_resume (media);
+              else
+                _lp_media_finish_start (media);
               break;
+            }
             case LP_EVENT_MASK_STOP:
               _lp_media_finish_stop (media);
               break;
@@ -772,7 +1745,7 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
               _lp_media_finish_pause (media);
               break;
             case LP_EVENT_MASK_SEEK:
-              _lp_media_finish_seek (media);
+              internal = !_lp_media_finish_seek (media);
               break;
             default:
               g_assert_not_reached ();
@@ -783,11 +1756,23 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
           g_assert_not_reached ();
       }
 
+      if (internal)
+      {
+        g_object_unref (event);   /* not requested by the application */
+        break;
+      }
+
       scene_lock (scene);
       if (likely (scene_state_started_or_paused (scene)))
       {
         scene->events = g_list_append (scene->events, event);
         g_assert_nonnull (scene->events);
+        scene->events_pending++;
+        scene_stats_add (scene, events_dispatched, 1);
+        if (scene->events_pending > scene_stats_get (scene,
+                                                     events_pending_max))
+          scene_stats_set (scene, events_pending_max,
+                           scene->events_pending);
       }
       scene_unlock (scene);
       break;
@@ -797,7 +1782,20 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
     case GST_MESSAGE_ASYNC_START:
       break;
     case GST_MESSAGE_BUFFERING:
+    {
+      lp_Media *media;
+      gint percent;
+
+      /* Media pipelines share the scene clock, so buffering is reported
+         per media instead of pausing the whole scene.  */
+      media = _lp_media_find_media (GST_MESSAGE_SRC (msg));
+      if (media == NULL)
+        break;                /* not from a media */
+
+      gst_message_parse_buffering (msg, &percent);
+      _lp_media_update_buffering (media, percent);
       break;
+    }
     case GST_MESSAGE_CLOCK_LOST:
       break;
     case GST_MESSAGE_CLOCK_PROVIDE:
@@ -814,6 +1812,34 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
       GstEvent *from = NULL;
       lp_Event *to = NULL;
 
+      if (gst_message_has_name (msg, "GstBinForwarded"))
+      {
+        GstMessage *fwd = NULL;
+
+        gst_structure_get (gst_message_get_structure (msg),
+                           "message", GST_TYPE_MESSAGE, &fwd, NULL);
+        if (fwd != NULL && GST_MESSAGE_TYPE (fwd) == GST_MESSAGE_EOS)
+          scene_output_sink_eos (scene, GST_MESSAGE_SRC (msg));
+        if (fwd != NULL)
+          gst_message_unref (fwd);
+        break;
+      }
+
+      if (gst_message_has_name (msg, "lp_Media-preroll-seek"))
+      {
+        lp_Media *media;
+
+        media = _lp_media_find_media (GST_MESSAGE_SRC (msg));
+        if (unlikely (media == NULL))
+          break;              /* media is gone */
+
+        _lp_media_finish_preroll (media);
+        break;
+      }
+
+      if (gst_message_has_name (msg, "lp_Media-segment-done"))
+        break;                /* segment already restarted by media */
+
       if (gst_navigation_message_get_type (msg)
           != GST_NAVIGATION_MESSAGE_EVENT)
         break;                /* nothing to do */
@@ -920,7 +1946,11 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
     case GST_MESSAGE_INFO:
       break;
     case GST_MESSAGE_LATENCY:
+    {
+      /* Some element changed its latency; redistribute it.  */
+      gst_bin_recalculate_latency (GST_BIN (scene->pipeline));
       break;
+    }
     case GST_MESSAGE_NEED_CONTEXT:
       break;
     case GST_MESSAGE_NEW_CLOCK:
@@ -934,7 +1964,30 @@ lp_scene_bus_callback (arg_unused (GstBus *bus),
     case GST_MESSAGE_PROGRESS:
       break;
     case GST_MESSAGE_QOS:
+    {
+      lp_Media *media;
+      GstFormat format;
+      guint64 dropped;
+
+      gst_message_parse_qos_stats (msg, &format, NULL, &dropped);
+      if (dropped == (guint64) -1)
+        break;                /* unknown */
+
+      media = _lp_media_find_media (GST_MESSAGE_SRC (msg));
+      if (media == NULL)
+      {
+        /* Video sinks count frames; audio sinks count samples.  */
+        if (format == GST_FORMAT_BUFFERS)
+          scene_stats_set (scene, frames_dropped, dropped);
+        break;
+      }
+
+      if (format != GST_FORMAT_BUFFERS && format != GST_FORMAT_DEFAULT)
+        break;                /* not counting frames */
+
+      _lp_media_update_qos (media, dropped);
       break;
+    }
     case GST_MESSAGE_REQUEST_STATE:
       break;
     case GST_MESSAGE_RESET_TIME:
@@ -990,9 +2043,15 @@ static void
 lp_scene_init (lp_Scene *scene)
 {
   g_rec_mutex_init (&scene->mutex);
+  scene->lock.depth = 0;
+  memset (&scene->stats, 0, sizeof (scene->stats));
+  scene->output.list = NULL;
+  scene->output.last_id = 0;
 
   scene_reset_run_time_data (scene);
   scene_reset_property_cache (scene);
+  gx_seqlock_init (&scene->pub.seq);
+  scene_publish (scene);
 
   /*
    * If we ceate the clock only on lp_scene_constructed(),
@@ -1001,6 +2060,10 @@ lp_scene_init (lp_Scene *scene)
    */
   scene->clock.clock = GST_CLOCK (g_object_new (LP_TYPE_CLOCK, NULL));
   g_assert_nonnull (scene->clock.clock);
+
+  scene->image_cache = _lp_image_cache_new (scene->prop.image_cache_budget);
+  g_assert_nonnull (scene->image_cache);
+  scene->trace = NULL;
 }
 
 static void
@@ -1008,8 +2071,35 @@ lp_scene_get_property (GObject *object, guint prop_id,
                        GValue *value, GParamSpec *pspec)
 {
   lp_Scene *scene;
+  gint n;
+  guint64 ticks;
+  GstClockTime time;
 
   scene = LP_SCENE (object);
+
+  switch (prop_id)              /* published, don't take the lock */
+  {
+    case PROP_WIDTH:
+      gx_seqlock_read (&scene->pub.seq, n, scene->pub.width);
+      g_value_set_int (value, n);
+      return;
+    case PROP_HEIGHT:
+      gx_seqlock_read (&scene->pub.seq, n, scene->pub.height);
+      g_value_set_int (value, n);
+      return;
+    case PROP_TICKS:
+      gx_seqlock_read (&scene->pub.seq, ticks, scene->pub.ticks);
+      g_value_set_uint64 (value, ticks);
+      return;
+    case PROP_TIME:
+      time = _lp_scene_get_running_time (scene);
+      g_assert (GST_CLOCK_TIME_IS_VALID (time));
+      g_value_set_uint64 (value, time);
+      return;
+    default:
+      break;
+  }
+
   scene_lock (scene);
 
   switch (prop_id)
@@ -1017,30 +2107,19 @@ lp_scene_get_property (GObject *object, guint prop_id,
     case PROP_MASK:
       g_value_set_int (value, scene->prop.mask);
       break;
-    case PROP_WIDTH:
-      g_value_set_int (value, scene->prop.width);
-      break;
-    case PROP_HEIGHT:
-      g_value_set_int (value, scene->prop.height);
-      break;
     case PROP_BACKGROUND:
       g_value_set_int (value, scene->prop.background);
       break;
     case PROP_WAVE:
       g_value_set_int (value, scene->prop.wave);
       break;
-    case PROP_TICKS:
-      g_value_set_uint64 (value, scene->prop.ticks);
-      break;
     case PROP_INTERVAL:
       g_value_set_uint64 (value, scene->prop.interval);
       break;
-    case PROP_TIME:
-      scene->prop.time = _lp_scene_get_running_time (scene);
-      g_assert (GST_CLOCK_TIME_IS_VALID (scene->prop.time));
-      g_value_set_uint64 (value, scene->prop.time);
-      break;
     case PROP_LOCKSTEP:
+      if (scene->clock.shared)  /* mode of the shared clock */
+        g_object_get (scene->clock.clock, "lockstep",
+                      &scene->prop.lockstep, NULL);
       g_value_set_boolean (value, scene->prop.lockstep);
       break;
     case PROP_SLAVE_AUDIO:
@@ -1058,6 +2137,55 @@ lp_scene_get_property (GObject *object, guint prop_id,
     case PROP_SYNCHRONOUS:
       g_value_set_boolean (value, scene->prop.sync);
       break;
+    case PROP_IMAGE_CACHE_BUDGET:
+      g_value_set_uint64 (value, scene->prop.image_cache_budget);
+      break;
+    case PROP_IMAGE_CACHE_SIZE:
+      g_value_set_uint64 (value,
+                          _lp_image_cache_get_size (scene->image_cache));
+      break;
+    case PROP_THREAD_BUDGET:
+      g_value_set_uint (value, scene->prop.thread_budget);
+      break;
+    case PROP_LATENCY:
+      g_value_set_uint64 (value, scene->prop.latency);
+      break;
+    case PROP_TRACE_FILE:
+      g_value_set_string (value, scene->prop.trace_file);
+      break;
+    case PROP_HEADLESS:
+      g_value_set_boolean (value, scene->prop.headless);
+      break;
+    case PROP_AUDIO_RATE:
+      g_value_set_int (value, scene->prop.audio_rate);
+      break;
+    case PROP_AUDIO_CHANNELS:
+      g_value_set_int (value, scene->prop.audio_channels);
+      break;
+    case PROP_AUDIO_FORMAT:
+      g_value_set_string (value, scene->prop.audio_format);
+      break;
+    case PROP_RESAMPLE_QUALITY:
+      g_value_set_int (value, scene->prop.resample_quality);
+      break;
+    case PROP_SHM_EXPORT:
+      g_value_set_string (value, scene->prop.shm_export);
+      break;
+    case PROP_SHM_EXPORT_SLOTS:
+      g_value_set_uint (value, scene->prop.shm_export_slots);
+      break;
+    case PROP_SHM_EXPORT_BLOCKING:
+      g_value_set_boolean (value, scene->prop.shm_export_blocking);
+      break;
+    case PROP_NET_CLOCK_PUBLISH:
+      g_value_set_string (value, scene->prop.net_clock_publish);
+      break;
+    case PROP_NET_CLOCK_FOLLOW:
+      g_value_set_string (value, scene->prop.net_clock_follow);
+      break;
+    case PROP_NET_CLOCK_PORT:
+      g_value_set_int (value, scene->prop.net_clock_port);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1090,7 +2218,8 @@ lp_scene_set_property (GObject *object, guint prop_id,
       break;
     case PROP_WAVE:
       scene->prop.wave = g_value_get_int (value);
-      g_object_set (scene->audio.blank, "wave", scene->prop.wave, NULL);
+      if (scene->audio.blank != NULL)
+        scene_update_audio_blank (scene);
       break;
     case PROP_TICKS:
       g_assert_not_reached ();  /* read-only */
@@ -1102,13 +2231,34 @@ lp_scene_set_property (GObject *object, guint prop_id,
       g_assert_not_reached ();  /* read-only */
       break;
     case PROP_LOCKSTEP:
-      scene->prop.lockstep = g_value_get_boolean (value);
-      g_object_set (scene->clock.clock, "lockstep",
-                    scene->prop.lockstep, NULL);
+    {
+      gboolean lockstep;
+
+      lockstep = g_value_get_boolean (value);
+      if (scene->clock.shared)
+        {
+          gboolean current;
+
+          /* The mode of a shared clock is changed only through the scene
+             that owns it; the others can only follow it.  */
+          g_object_get (scene->clock.clock, "lockstep", &current, NULL);
+          if (unlikely (lockstep != current))
+            {
+              _lp_warn ("cannot set lock-step mode of %p: "
+                        "its clock belongs to another scene", scene);
+              goto done;
+            }
+        }
+      else
+        {
+          g_object_set (scene->clock.clock, "lockstep", lockstep, NULL);
+        }
+      scene->prop.lockstep = lockstep;
 
       if (scene->pipeline && !scene_state_paused (scene))
         gstx_element_set_state_sync (scene->pipeline, GST_STATE_PAUSED);
       break;
+    }
     case PROP_SLAVE_AUDIO:
       scene->prop.slave_audio = g_value_get_boolean (value);
 
@@ -1130,6 +2280,93 @@ lp_scene_set_property (GObject *object, guint prop_id,
     case PROP_SYNCHRONOUS:
       scene->prop.sync = g_value_get_boolean (value);
       break;
+    case PROP_IMAGE_CACHE_BUDGET:
+      scene->prop.image_cache_budget = g_value_get_uint64 (value);
+      _lp_image_cache_set_budget (scene->image_cache,
+                                  scene->prop.image_cache_budget);
+      break;
+    case PROP_IMAGE_CACHE_SIZE:
+      g_assert_not_reached ();  /* read-only */
+      break;
+    case PROP_THREAD_BUDGET:
+      scene->prop.thread_budget = g_value_get_uint (value);
+      break;
+    case PROP_LATENCY:
+      scene->prop.latency = g_value_get_uint64 (value);
+      break;
+    case PROP_TRACE_FILE:
+      g_free (scene->prop.trace_file);
+      scene->prop.trace_file = g_value_dup_string (value);
+      break;
+    case PROP_HEADLESS:
+      scene->prop.headless = g_value_get_boolean (value);
+      break;
+    case PROP_AUDIO_RATE:
+      scene->prop.audio_rate = g_value_get_int (value);
+      break;
+    case PROP_AUDIO_CHANNELS:
+      scene->prop.audio_channels = g_value_get_int (value);
+      break;
+    case PROP_AUDIO_FORMAT:
+      {
+        const gchar *format;
+
+        format = g_value_get_string (value);
+        if (unlikely (format != NULL
+                      && gst_audio_format_from_string (format)
+                      == GST_AUDIO_FORMAT_UNKNOWN))
+          {
+            _lp_warn ("invalid audio format %s", format);
+            break;
+          }
+
+        g_free (scene->prop.audio_format);
+        scene->prop.audio_format = g_strdup (format);
+        break;
+      }
+    case PROP_RESAMPLE_QUALITY:
+      scene->prop.resample_quality = g_value_get_int (value);
+      break;
+    case PROP_SHM_EXPORT:
+      g_free (scene->prop.shm_export);
+      scene->prop.shm_export = g_value_dup_string (value);
+      break;
+    case PROP_SHM_EXPORT_SLOTS:
+      scene->prop.shm_export_slots = g_value_get_uint (value);
+      break;
+    case PROP_SHM_EXPORT_BLOCKING:
+      scene->prop.shm_export_blocking = g_value_get_boolean (value);
+      break;
+    case PROP_NET_CLOCK_PUBLISH:
+      g_free (scene->prop.net_clock_publish);
+      scene->prop.net_clock_publish = g_value_dup_string (value);
+      break;
+    case PROP_NET_CLOCK_FOLLOW:
+      g_free (scene->prop.net_clock_follow);
+      scene->prop.net_clock_follow = g_value_dup_string (value);
+      break;
+    case PROP_NET_CLOCK_PORT:
+      scene->prop.net_clock_port = g_value_get_int (value);
+      break;
+    case PROP_CLOCK_SCENE:
+    {
+      lp_Scene *other;
+
+      other = (lp_Scene *) g_value_get_object (value);
+      if (other == NULL)
+        break;                  /* own clock */
+
+      g_assert_nonnull (other->clock.clock);
+      g_object_unref (scene->clock.clock);
+      scene->clock.clock = GST_CLOCK (gst_object_ref (other->clock.clock));
+      scene->clock.shared = TRUE;
+
+      /* Lock-step mode is that of the shared clock, which is changed
+         only through the scene that owns it.  */
+      g_object_get (scene->clock.clock, "lockstep",
+                    &scene->prop.lockstep, NULL);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1144,6 +2381,11 @@ lp_scene_set_property (GObject *object, guint prop_id,
       scene_update_clock_id (scene);
       break;
     }
+    case PROP_LATENCY:
+    {
+      scene_update_latency (scene);
+      break;
+    }
     case PROP_BACKGROUND:       /* fall through */
     case PROP_TEXT:             /* fall through */
     case PROP_TEXT_COLOR:       /* fall through */
@@ -1182,13 +2424,30 @@ lp_scene_set_property (GObject *object, guint prop_id,
 
  done:
   scene_unlock (scene);
+
+  /* Media are locked while rebalancing, so this must be done without
+     holding the scene lock.  */
+  if (prop_id == PROP_THREAD_BUDGET)
+    _lp_scene_rebalance_threads (scene);
 }
 
 static void
 lp_scene_constructed (GObject *object)
 {
+  lp_Scene *scene;
+  const gchar *path;
+
+  scene = LP_SCENE (object);
+  path = (scene->prop.trace_file != NULL)
+    ? scene->prop.trace_file : g_getenv ("LP_TRACE");
+  if (path != NULL && *path != '\0')
+    scene->trace = _lp_trace_open (path);
+
+  if (scene_has_net_clock (scene))
+    scene_setup_net_clock (scene);
+
   /* FIXME: Handle bootstrap errors gracefully.  */
-  g_assert (scene_start_unlocked (LP_SCENE (object)));
+  g_assert (scene_start_unlocked (scene));
 }
 
 static void
@@ -1217,7 +2476,9 @@ lp_scene_dispose (GObject *object)
 
   g_assert (scene_state_stopped (scene));
   scene_release_property_cache (scene);
-  scene->state = DISPOSED;
+  g_list_free_full (scene->output.list, (GDestroyNotify) scene_output_free);
+  scene->output.list = NULL;
+  scene_set_state (scene, DISPOSED);
   scene_unlock (scene);
 
   G_OBJECT_CLASS (lp_scene_parent_class)->dispose (object);
@@ -1230,6 +2491,9 @@ lp_scene_finalize (GObject *object)
 
   scene = LP_SCENE (object);
   g_assert (scene_state_disposed (scene));
+  _lp_image_cache_free (scene->image_cache);
+  if (scene->trace != NULL)
+    _lp_trace_close (scene->trace);
   g_rec_mutex_clear (&scene->mutex);
 
   G_OBJECT_CLASS (lp_scene_parent_class)->finalize (object);
@@ -1331,6 +2595,132 @@ lp_scene_class_init (lp_SceneClass *cls)
       DEFAULT_SYNCHRONOUS,
       (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
 
+  g_object_class_install_property
+    (gobject_class, PROP_IMAGE_CACHE_BUDGET, g_param_spec_uint64
+     ("image-cache-budget", "image cache budget",
+      "memory budget of the decoded image cache (in bytes)",
+      0, G_MAXUINT64, DEFAULT_IMAGE_CACHE_BUDGET,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_IMAGE_CACHE_SIZE, g_param_spec_uint64
+     ("image-cache-size", "image cache size",
+      "memory held by the decoded image cache (in bytes)",
+      0, G_MAXUINT64, 0,
+      (GParamFlags)(G_PARAM_READABLE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_THREAD_BUDGET, g_param_spec_uint
+     ("thread-budget", "thread budget",
+      "total number of decoding and conversion threads (0=automatic)",
+      0, G_MAXUINT, DEFAULT_THREAD_BUDGET,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_LATENCY, g_param_spec_uint64
+     ("latency", "latency",
+      "target pipeline latency (in nanoseconds, 0=automatic)",
+      0, G_MAXUINT64, DEFAULT_LATENCY,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_TRACE_FILE, g_param_spec_string
+     ("trace-file", "trace file",
+      "file to write Chrome trace events to (overrides LP_TRACE)",
+      DEFAULT_TRACE_FILE,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_HEADLESS, g_param_spec_boolean
+     ("headless", "headless",
+      "discard output instead of rendering it to devices",
+      DEFAULT_HEADLESS,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_AUDIO_RATE, g_param_spec_int
+     ("audio-rate", "audio rate",
+      "audio mixer sample rate (in Hz, 0=negotiated)",
+      0, G_MAXINT, DEFAULT_AUDIO_RATE,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_AUDIO_CHANNELS, g_param_spec_int
+     ("audio-channels", "audio channels",
+      "audio mixer number of channels (0=negotiated)",
+      0, G_MAXINT, DEFAULT_AUDIO_CHANNELS,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_AUDIO_FORMAT, g_param_spec_string
+     ("audio-format", "audio format",
+      "audio mixer sample format, e.g., S16LE or F32LE (NULL=negotiated)",
+      DEFAULT_AUDIO_FORMAT,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_RESAMPLE_QUALITY, g_param_spec_int
+     ("resample-quality", "resample quality",
+      "quality of audio resampling in media started afterwards "
+      "(0=fastest, 10=best)",
+      0, 10, DEFAULT_RESAMPLE_QUALITY,
+      (GParamFlags)(G_PARAM_READWRITE)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_SHM_EXPORT, g_param_spec_string
+     ("shm-export", "shared-memory export",
+      "name of the shared-memory ring composed frames are exported to "
+      "(NULL=no export), see lp_shm_reader_open()",
+      DEFAULT_SHM_EXPORT,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_SHM_EXPORT_SLOTS, g_param_spec_uint
+     ("shm-export-slots", "shared-memory export slots",
+      "number of frames in the shared-memory ring",
+      1, 64, DEFAULT_SHM_EXPORT_SLOTS,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_SHM_EXPORT_BLOCKING, g_param_spec_boolean
+     ("shm-export-blocking", "shared-memory export blocking",
+      "stall the scene while the shared-memory ring is full, "
+      "instead of overwriting unread frames (unless the reader stalls)",
+      DEFAULT_SHM_EXPORT_BLOCKING,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_NET_CLOCK_PUBLISH, g_param_spec_string
+     ("net-clock-publish", "network clock publish",
+      "local address on which the scene clock is published "
+      "(NULL=not published)",
+      DEFAULT_NET_CLOCK_PUBLISH,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_NET_CLOCK_FOLLOW, g_param_spec_string
+     ("net-clock-follow", "network clock follow",
+      "address of a published scene clock the scene clock follows "
+      "(NULL=local clock)",
+      DEFAULT_NET_CLOCK_FOLLOW,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_NET_CLOCK_PORT, g_param_spec_int
+     ("net-clock-port", "network clock port",
+      "UDP port of the published or followed clock "
+      "(0=any port, when publishing)",
+      0, G_MAXUINT16, DEFAULT_NET_CLOCK_PORT,
+      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property
+    (gobject_class, PROP_CLOCK_SCENE, g_param_spec_object
+     ("clock-scene", "clock scene",
+      "scene whose clock is shared by this scene (NULL=own clock), "
+      "see lp_scene_advance_group()",
+      LP_TYPE_SCENE,
+      (GParamFlags)(G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY)));
+
   if (!gst_is_initialized ())
   {
     GError *error = NULL;
@@ -1341,6 +2731,8 @@ lp_scene_class_init (lp_SceneClass *cls)
       g_error_free (error);
     }
   }
+
+  _lp_mmap_src_register ();
 }
 
 
@@ -1348,20 +2740,52 @@ lp_scene_class_init (lp_SceneClass *cls)
 
 /* Adds @media to @scene and takes ownership of @media.  */
 
-void
+gboolean
 _lp_scene_add_media (lp_Scene *scene, lp_Media *media)
 {
+  gboolean status;
+
   scene_lock (scene);
 
+  status = FALSE;
   if (unlikely (!scene_state_started (scene)))
     goto done;                  /* nothing to do */
 
   g_assert (scene_state_started (scene));
   scene->children = g_list_append (scene->children, media);
   g_assert_nonnull (scene->children);
+  _lp_scene_count_media (scene, LP_MEDIA_GROUP_NONE,
+                         LP_MEDIA_GROUP_STOPPED);
+  status = TRUE;
 
  done:
   scene_unlock (scene);
+  return status;
+}
+
+/* Updates the number of child media in @scene after a child moves from
+   state group @from to state group @to.  Does not take the scene lock.  */
+
+void
+_lp_scene_count_media (lp_Scene *scene, lp_MediaGroup from,
+                       lp_MediaGroup to)
+{
+  if (from == to)
+    return;                     /* nothing to do */
+
+  if (from != LP_MEDIA_GROUP_NONE)
+    scene_stats_add (scene, media[from], -1);
+  if (to != LP_MEDIA_GROUP_NONE)
+    scene_stats_add (scene, media[to], 1);
+}
+
+/* Counts one contended acquisition of a lock of @scene or of one of its
+   children.  Does not take the scene lock.  */
+
+void
+_lp_scene_count_contention (lp_Scene *scene)
+{
+  scene_stats_add (scene, lock_contended, 1);
 }
 
 /* Returns @scene pipeline.  */
@@ -1386,42 +2810,50 @@ _lp_scene_get_pipeline (lp_Scene *scene)
   return NULL;
 }
 
-/* Returns the @scene running time (in nanoseconds).  */
+/* Returns the @scene running time (in nanoseconds), or
+   GST_CLOCK_TIME_NONE if @scene is not started.  Does not take the scene
+   lock.  */
 
 GstClockTime
 _lp_scene_get_running_time (lp_Scene *scene)
 {
-  GstClockTime time;
-
-  scene_lock (scene);
+  lp_SceneState state;
+  GstClockTime offset;
+  gint seq;
 
-  if (unlikely (!scene_state_started (scene)))
-    goto fail;                  /* nothing to do */
-
-  g_assert (scene_state_started (scene));
-  time = gstx_element_get_clock_time (scene->pipeline);
-  time = time - scene->clock.offset;
+  do
+    {
+      seq = gx_seqlock_read_begin (&scene->pub.seq);
+      state = scene->pub.state;
+      offset = scene->pub.offset;
+    }
+  while (gx_seqlock_read_retry (&scene->pub.seq, seq));
 
-  scene_unlock (scene);
-  return time;
+  if (unlikely (state != STARTED))
+    return GST_CLOCK_TIME_NONE; /* nothing to do */
 
-fail:
-  scene_unlock (scene);
-  return GST_CLOCK_TIME_NONE;
+  return gst_clock_get_time (scene->clock.clock) - offset;
 }
 
+/* Returns the @scene start time offset, or GST_CLOCK_TIME_NONE if @scene
+   is not started or paused.  Does not take the scene lock.  */
+
 GstClockTime
 _lp_scene_get_start_time (lp_Scene *scene)
 {
-  GstClockTime time = GST_CLOCK_TIME_NONE;
-
-  scene_lock (scene);
+  lp_SceneState state;
+  GstClockTime offset;
+  gint seq;
 
-  if (scene_state_started_or_paused (scene))
-    time = scene->clock.offset;
+  do
+    {
+      seq = gx_seqlock_read_begin (&scene->pub.seq);
+      state = scene->pub.state;
+      offset = scene->pub.offset;
+    }
+  while (gx_seqlock_read_retry (&scene->pub.seq, seq));
 
-  scene_unlock (scene);
-  return time;
+  return (state <= PAUSED) ? offset : GST_CLOCK_TIME_NONE;
 }
 
 /* Returns @scene audio mixer.  */
@@ -1518,6 +2950,129 @@ fail:
   return NULL;
 }
 
+/* Returns @scene decoded image cache.  */
+
+lp_ImageCache *
+_lp_scene_get_image_cache (lp_Scene *scene)
+{
+  return scene->image_cache;    /* cache has its own lock */
+}
+
+/* Returns the caps to which @scene pins its audio mixer output, or NULL
+   if some of them is left to negotiation.  */
+
+GstCaps *
+_lp_scene_get_audio_caps (lp_Scene *scene)
+{
+  GstCaps *caps;
+
+  scene_lock (scene);
+  caps = scene_get_audio_caps (scene, TRUE);
+  scene_unlock (scene);
+
+  return caps;
+}
+
+/* Returns the quality of audio resampling in @scene media.  */
+
+gint
+_lp_scene_get_resample_quality (lp_Scene *scene)
+{
+  gint quality;
+
+  scene_lock (scene);
+  quality = scene->prop.resample_quality;
+  scene_unlock (scene);
+
+  return quality;
+}
+
+/* Returns @scene trace recorder, or NULL if tracing is disabled.  */
+
+lp_Trace *
+_lp_scene_get_trace (lp_Scene *scene)
+{
+  return scene->trace;          /* trace has its own lock */
+}
+
+/* Divides the thread budget of @scene among its started media in
+   proportion to their displayed area, and among the compositor, which
+   gets the share of an average media.  Media without video get a single
+   thread.  Does nothing if the budget is zero (automatic).  */
+
+void
+_lp_scene_rebalance_threads (lp_Scene *scene)
+{
+  GList *children;
+  GList *l;
+  guint64 *area;
+  guint64 total;
+  guint budget;
+  guint nvideo;
+  guint n;
+  guint i;
+
+  scene_lock (scene);
+
+  budget = scene->prop.thread_budget;
+  if (budget == 0 || !scene_state_started_or_paused (scene))
+    {
+      scene_unlock (scene);
+      return;                   /* nothing to do */
+    }
+
+  children = g_list_copy_deep (scene->children,
+                               (GCopyFunc) g_object_ref, NULL);
+  scene_unlock (scene);
+
+  n = g_list_length (children);
+  area = g_new0 (guint64, max (n, 1));
+  total = 0;
+  nvideo = 0;
+
+  for (l = children, i = 0; l != NULL; l = l->next, i++)
+    {
+      area[i] = _lp_media_get_display_area (LP_MEDIA (l->data));
+      total += area[i];
+      if (area[i] > 0)
+        nvideo++;
+    }
+
+  if (nvideo > 0)
+    {
+      GstElement *mixer;
+      GType type;
+
+      /* Compositor share; only set if the compositor has workers.  */
+      mixer = _lp_scene_get_video_mixer (scene);
+      if (mixer != NULL)
+        {
+          guint share = max (budget / (nvideo + 1), 1);
+
+          type = gx_object_find_property_type (G_OBJECT (mixer),
+                                               "max-threads");
+          if (type == G_TYPE_UINT)
+            {
+              g_object_set (mixer, "max-threads", share, NULL);
+              budget = budget > share ? budget - share : 1;
+            }
+        }
+    }
+
+  for (l = children, i = 0; l != NULL; l = l->next, i++)
+    {
+      guint threads = 1;
+
+      if (area[i] > 0)
+        threads = (guint) max ((budget * area[i]) / total, 1);
+
+      _lp_media_set_threads (LP_MEDIA (l->data), threads);
+    }
+
+  g_free (area);
+  g_list_free_full (children, g_object_unref);
+}
+
 /* Returns true if @scene has video output.  */
 
 gboolean
@@ -1661,7 +3216,8 @@ lp_scene_to_string (lp_Scene *scene)
  *
  * Advances the scene clock by @time nanoseconds.  This function should only
  * be used when @scene is in lock-step mode, i.e., when its "lockstep"
- * property is set to %TRUE.
+ * property is set to %TRUE.  If @scene shares its clock with other scenes,
+ * use lp_scene_advance_group() instead, which steps all of them.
  *
  * Returns: %TRUE successful, or %FALSE otherwise
  */
@@ -1669,8 +3225,7 @@ gboolean
 lp_scene_advance (lp_Scene *scene, guint64 time)
 {
   GstBus *bus;
-  int sinks = 1;
-  gboolean stepdone = FALSE;
+  guint sinks;
 
   scene_lock (scene);
   if (unlikely (!scene_state_started (scene) || !scene->prop.lockstep))
@@ -1684,30 +3239,8 @@ lp_scene_advance (lp_Scene *scene, guint64 time)
   gst_bus_remove_watch (bus);
   scene_unlock (scene);
 
-  gst_element_send_event (scene->audio.sink,
-      gst_event_new_step (GST_FORMAT_TIME, time, 1.0, TRUE, FALSE));
-
-  if (_lp_scene_has_video (scene))
-  {
-    sinks++;
-    gst_element_send_event (scene->video.sink,
-        gst_event_new_step (GST_FORMAT_TIME, time, 1.0, TRUE, FALSE));
-  }
-
-  while (!stepdone)
-  {
-    GstMessage *msg = gst_bus_timed_pop (bus, GST_CLOCK_TIME_NONE);
-
-    stepdone = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_STEP_DONE &&
-      (--sinks, sinks == 0);
-    lp_scene_bus_callback (bus, msg, scene);
-    gst_message_unref(msg);
-  }
-
-  g_assert (gst_bus_add_watch (bus,
-        (GstBusFunc) lp_scene_bus_callback, scene) > 0);
-  _lp_debug ("advance: step done");
-  gst_object_unref (bus);
+  sinks = scene_step_begin (scene, time);
+  scene_step_finish (scene, bus, sinks);
 
   return TRUE;
 
@@ -1716,6 +3249,71 @@ fail:
   return FALSE;
 }
 
+/**
+ * lp_scene_advance_group:
+ * @scenes: (array length=n): scenes that share a clock
+ * @n: number of scenes in @scenes
+ * @time: the amount of time to advance (in nanoseconds)
+ *
+ * Advances the clock shared by @scenes by @time nanoseconds, and steps
+ * every scene in @scenes accordingly.  The scenes must have been created
+ * with their "clock-scene" property pointing to the same scene (or be that
+ * scene), and must all be in lock-step mode.  The scenes are stepped
+ * concurrently, so advancing a group is cheaper than advancing each scene
+ * in turn.
+ *
+ * Returns: %TRUE successful, or %FALSE otherwise
+ */
+gboolean
+lp_scene_advance_group (lp_Scene **scenes, guint n, guint64 time)
+{
+  GstClock *clock;
+  GstBus **bus;
+  guint *sinks;
+  guint i;
+
+  g_assert_nonnull (scenes);
+  if (unlikely (n == 0))
+    return FALSE;               /* nothing to do */
+
+  clock = NULL;
+  for (i = 0; i < n; i++)
+    {
+      lp_Scene *scene = scenes[i];
+      gboolean ok;
+
+      scene_lock (scene);
+      ok = scene_state_started (scene) && scene->prop.lockstep
+        && (clock == NULL || clock == scene->clock.clock);
+      clock = scene->clock.clock;
+      scene_unlock (scene);
+
+      if (unlikely (!ok))
+        return FALSE;           /* nothing to do */
+    }
+
+  _lp_clock_advance (LP_CLOCK (clock), time);
+
+  bus = g_new (GstBus *, n);
+  sinks = g_new (guint, n);
+  for (i = 0; i < n; i++)
+    {
+      scene_lock (scenes[i]);
+      bus[i] = gst_pipeline_get_bus (GST_PIPELINE (scenes[i]->pipeline));
+      gst_bus_remove_watch (bus[i]);
+      scene_unlock (scenes[i]);
+    }
+
+  for (i = 0; i < n; i++)
+    sinks[i] = scene_step_begin (scenes[i], time);
+  for (i = 0; i < n; i++)
+    scene_step_finish (scenes[i], bus[i], sinks[i]);
+
+  g_free (bus);
+  g_free (sinks);
+  return TRUE;
+}
+
 /**
  * lp_scene_receive:
  * @scene: an #lp_Scene
@@ -1769,13 +3367,18 @@ retry:
   event = LP_EVENT (scene->events->data);
   g_assert_nonnull (event);
   scene->events = g_list_delete_link (scene->events, scene->events);
+  g_assert (scene->events_pending > 0);
+  scene->events_pending--;
 
   if ((lp_event_get_mask (event) & scene->prop.mask) == 0)
   {
     g_object_unref (event);   /* consume event */
+    scene_stats_add (scene, events_masked, 1);
     goto retry;
   }
 
+  scene_stats_add (scene, events_received, 1);
+
  done:
   scene_unlock (scene);
   return event;
@@ -1829,7 +3432,7 @@ lp_scene_pause (lp_Scene *scene)
   if (!scene->prop.lockstep)
     gstx_element_set_state_sync (scene->pipeline, GST_STATE_PAUSED);
 
-  scene->state = PAUSED;
+  scene_set_state (scene, PAUSED);
 
   event = LP_EVENT (_lp_event_pause_new (G_OBJECT(scene)));
   g_assert_nonnull (event);
@@ -1866,7 +3469,7 @@ lp_scene_resume (lp_Scene *scene)
     gstx_element_set_state_sync (scene->pipeline, GST_STATE_PLAYING);
   }
 
-  scene->state = STARTED;
+  scene_set_state (scene, STARTED);
   event = LP_EVENT (_lp_event_start_new (G_OBJECT(scene), TRUE));
   g_assert_nonnull (event);
   _lp_scene_dispatch (scene, event);
@@ -1898,11 +3501,355 @@ _lp_scene_is_paused (lp_Scene *scene)
 guint64
 lp_scene_get_current_time (lp_Scene *scene)
 {
-  guint64 time;
+  GstClockTime offset;
+
+  gx_seqlock_read (&scene->pub.seq, offset, scene->pub.offset);
+  return gst_clock_get_time (scene->clock.clock) - offset;
+}
+
+/**
+ * lp_scene_get_stats:
+ * @scene: an #lp_Scene
+ * @stats: (out): return location for the statistics
+ *
+ * Stores the run-time statistics of @scene into @stats.  Statistics are
+ * collected since @scene creation.  This function does not take the scene
+ * lock and can be called from any thread; counters are read one by one,
+ * so @stats is not an atomic snapshot.
+ */
+void
+lp_scene_get_stats (lp_Scene *scene, lp_SceneStats *stats)
+{
+  g_assert_nonnull (stats);
+
+  stats->frames_composed = scene_stats_get (scene, frames_composed);
+  stats->frames_dropped = scene_stats_get (scene, frames_dropped);
+  stats->events_dispatched = scene_stats_get (scene, events_dispatched);
+  stats->events_received = scene_stats_get (scene, events_received);
+  stats->events_masked = scene_stats_get (scene, events_masked);
+  stats->events_pending_max = scene_stats_get (scene, events_pending_max);
+  stats->media_stopped = scene_stats_get
+    (scene, media[LP_MEDIA_GROUP_STOPPED]);
+  stats->media_started = scene_stats_get
+    (scene, media[LP_MEDIA_GROUP_STARTED]);
+  stats->media_paused = scene_stats_get
+    (scene, media[LP_MEDIA_GROUP_PAUSED]);
+  stats->media_busy = scene_stats_get (scene, media[LP_MEDIA_GROUP_BUSY]);
+  stats->lock_time = scene_stats_get_lock_time (scene);
+  stats->lock_contended = scene_stats_get (scene, lock_contended);
+}
+
+/**
+ * lp_scene_get_latency:
+ * @scene: an #lp_Scene
+ * @latency: (out): return location for the latency
+ *
+ * Queries the latency of @scene and stores it, broken down by processing
+ * stage, into @latency.  The decode and convert stages report the slowest
+ * media; the mixer and sink stages report the latency each adds on top of
+ * the previous stages.  If "latency" is set, @latency->total is the
+ * requested budget.
+ *
+ * Returns: %TRUE if successful, or %FALSE otherwise
+ */
+gboolean
+lp_scene_get_latency (lp_Scene *scene, lp_Latency *latency)
+{
+  GstElement *pipeline;
+  GstElement *mixer;
+  GstPad *pad;
+  GList *children;
+  GList *l;
+  gboolean video;
+  GstQuery *query;
+  GstClockTime media_max;
+  GstClockTime mixer_out;
+  GstClockTime total;
+  gboolean live;
+
+  g_assert_nonnull (latency);
+
+  scene_lock (scene);
+
+  if (unlikely (!scene_state_started_or_paused (scene)))
+    {
+      scene_unlock (scene);
+      return FALSE;
+    }
+
+  video = _lp_scene_has_video (scene);
+  pipeline = (GstElement *) gst_object_ref (scene->pipeline);
+  mixer = (GstElement *) gst_object_ref
+    (video ? scene->video.mixer : scene->audio.mixer);
+  children = g_list_copy_deep (scene->children,
+                               (GCopyFunc) g_object_ref, NULL);
+
+  scene_unlock (scene);
+
+  memset (latency, 0, sizeof (*latency));
+  total = 0;
+  live = FALSE;
+
+  /* Media stages.  */
+  media_max = 0;
+  for (l = children; l != NULL; l = l->next)
+    {
+      GstClockTime decode;
+      GstClockTime convert;
+
+      if (!_lp_media_get_latency (LP_MEDIA (l->data), video,
+                                  &decode, &convert))
+        continue;
+
+      latency->decode = max (latency->decode, decode);
+      latency->convert = max (latency->convert, convert);
+      media_max = max (media_max, decode + convert);
+    }
+
+  /* Mixer stage.  */
+  pad = gst_element_get_static_pad (mixer, "src");
+  g_assert_nonnull (pad);
+  mixer_out = gstx_pad_query_latency (pad, NULL);
+  gst_object_unref (pad);
+  latency->mixer = (mixer_out > media_max) ? mixer_out - media_max : 0;
+
+  /* Whole pipeline, including the sink.  */
+  query = gst_query_new_latency ();
+  g_assert_nonnull (query);
+  if (gst_element_query (pipeline, query))
+    gst_query_parse_latency (query, &live, &total, NULL);
+  gst_query_unref (query);
+
+  if (!GST_CLOCK_TIME_IS_VALID (total))
+    total = 0;
+
+  latency->live = live;
+  latency->sink = (total > mixer_out) ? total - mixer_out : 0;
+  latency->total = max (total, mixer_out);
+
+  if (GST_CLOCK_TIME_IS_VALID
+      (gst_pipeline_get_latency (GST_PIPELINE (pipeline))))
+    latency->total = gst_pipeline_get_latency (GST_PIPELINE (pipeline));
+
+  g_list_free_full (children, g_object_unref);
+  gst_object_unref (mixer);
+  gst_object_unref (pipeline);
+
+  return TRUE;
+}
+
+/**
+ * lp_scene_add_output:
+ * @scene: an #lp_Scene
+ * @type: whether the output receives composed video or mixed audio
+ * @description: output bin description in gst-launch syntax, e.g.,
+ * "x264enc ! matroskamux ! filesink location=out.mkv"
+ *
+ * Attaches an output to @scene, in addition to its display and audio
+ * device.  Composition and mixing are done once and shared by all
+ * outputs through a tee.  Each output sits behind its own leaky queue,
+ * so a slow output drops buffers instead of stalling the others.  The
+ * output is preceded by a converter (and a resampler, for audio), so
+ * @description need not match the scene format.
+ *
+ * Outputs can be attached and detached while @scene is running, and are
+ * kept across scene restarts.
+ *
+ * Returns: the id of the new output if successful, or zero otherwise
+ */
+guint
+lp_scene_add_output (lp_Scene *scene, lp_OutputType type,
+                     const gchar *description)
+{
+  lp_SceneOutput *output;
+  guint id = 0;
+
+  g_assert_nonnull (description);
+  g_assert (type == LP_OUTPUT_VIDEO || type == LP_OUTPUT_AUDIO);
+
+  scene_lock (scene);
+
+  if (unlikely (scene_state_stopping (scene)
+                || scene_state_disposed (scene)))
+    goto done;                  /* nothing to do */
+
+  if (unlikely (type == LP_OUTPUT_VIDEO && !_lp_scene_has_video (scene)))
+    goto done;                  /* no video */
+
+  output = g_new0 (lp_SceneOutput, 1);
+  output->type = type;
+  output->description = g_strdup (description);
+
+  if (!scene_state_stopped (scene)
+      && unlikely (!scene_output_plug (scene, output)))
+    {
+      scene_output_free (output);
+      goto done;
+    }
+
+  output->id = ++scene->output.last_id;
+  scene->output.list = g_list_append (scene->output.list, output);
+  id = output->id;
+
+ done:
+  scene_unlock (scene);
+  return id;
+}
+
+/**
+ * lp_scene_remove_output:
+ * @scene: an #lp_Scene
+ * @id: output id returned by lp_scene_add_output()
+ *
+ * Detaches output @id from @scene.  If @scene is running, the output is
+ * unlinked as soon as its tee branch is idle, without disturbing the
+ * other outputs, and is then sent EOS, so that muxers in it can finish
+ * their files.  It is torn down once all of its sinks have received EOS,
+ * or when @scene stops.
+ *
+ * Returns: %TRUE if successful, or %FALSE if there is no such output
+ */
+gboolean
+lp_scene_remove_output (lp_Scene *scene, guint id)
+{
+  lp_SceneOutput *output = NULL;
+  GList *l;
+
+  scene_lock (scene);
+
+  for (l = scene->output.list; l != NULL; l = l->next)
+    {
+      if (((lp_SceneOutput *) l->data)->id == id)
+        {
+          output = (lp_SceneOutput *) l->data;
+          scene->output.list = g_list_delete_link (scene->output.list, l);
+          break;
+        }
+    }
+
+  if (unlikely (output == NULL))
+    {
+      scene_unlock (scene);
+      return FALSE;             /* no such output */
+    }
+
+  if (output->pad != NULL)
+    {
+      output->sinks = scene_output_count_sinks (output);
+      scene->output.pending = g_list_append (scene->output.pending,
+                                             output);
+      gst_pad_add_probe (output->pad, GST_PAD_PROBE_TYPE_IDLE,
+                         (GstPadProbeCallback)
+                         lp_scene_output_idle_probe_callback, output,
+                         NULL);
+    }
+  else
+    {
+      scene_output_free (output);
+    }
+
+  scene_unlock (scene);
+  return TRUE;
+}
+
+/**
+ * lp_scene_snapshot:
+ * @scene: an #lp_Scene
+ * @format: "png", "jpeg", or the name of a raw video format, e.g., "RGBA"
+ * @width: snapshot width, or zero to keep the scene width
+ * @height: snapshot height, or zero to keep the scene height
+ *
+ * Takes a snapshot of the last frame composed by @scene, scaled to @width
+ * x @height and converted to @format.  The scene lock is held only to
+ * fetch the frame; scaling, conversion and encoding run in a separate
+ * pipeline waited on by the calling thread, so @scene keeps rendering
+ * meanwhile.  Raw frame rows are padded to a multiple of four bytes.
+ *
+ * Returns: (transfer full): the snapshot data if successful, or %NULL
+ * otherwise
+ */
+GBytes *
+lp_scene_snapshot (lp_Scene *scene, const gchar *format,
+                   gint width, gint height)
+{
+  GstElement *sink;
+  GstSample *sample = NULL;
+  GstSample *result;
+  GstCaps *caps;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  GBytes *bytes;
+  GError *error = NULL;
+
+  g_assert_nonnull (format);
+
+  if (g_str_equal (format, "png"))
+    {
+      caps = gst_caps_new_empty_simple ("image/png");
+    }
+  else if (g_str_equal (format, "jpeg") || g_str_equal (format, "jpg"))
+    {
+      caps = gst_caps_new_empty_simple ("image/jpeg");
+    }
+  else if (gst_video_format_from_string (format)
+           != GST_VIDEO_FORMAT_UNKNOWN)
+    {
+      caps = gst_caps_new_simple ("video/x-raw",
+                                  "format", G_TYPE_STRING, format,
+                                  "pixel-aspect-ratio", GST_TYPE_FRACTION,
+                                  1, 1, NULL);
+    }
+  else
+    {
+      _lp_warn ("unknown snapshot format %s", format);
+      return NULL;
+    }
+  g_assert_nonnull (caps);
+
+  if (width > 0)
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, width, NULL);
+  if (height > 0)
+    gst_caps_set_simple (caps, "height", G_TYPE_INT, height, NULL);
+
   scene_lock (scene);
 
-  time = gst_clock_get_time (scene->clock.clock) - scene->clock.offset;
+  if (unlikely (!scene_state_started (scene)
+                || !_lp_scene_has_video (scene)))
+    {
+      scene_unlock (scene);
+      gst_caps_unref (caps);
+      return NULL;              /* nothing to do */
+    }
 
+  sink = scene_get_real_sink (scene, offsetof (lp_Scene, video.sink));
   scene_unlock (scene);
-  return time;
+
+  g_object_get (sink, "last-sample", &sample, NULL);
+  gst_object_unref (sink);
+  if (unlikely (sample == NULL))
+    {
+      gst_caps_unref (caps);
+      return NULL;              /* nothing composed yet */
+    }
+
+  result = gst_video_convert_sample (sample, caps, SNAPSHOT_TIMEOUT,
+                                     &error);
+  gst_sample_unref (sample);
+  gst_caps_unref (caps);
+  if (unlikely (result == NULL))
+    {
+      _lp_warn ("cannot convert snapshot: %s",
+                (error != NULL) ? error->message : "timeout");
+      g_clear_error (&error);
+      return NULL;
+    }
+
+  buffer = gst_sample_get_buffer (result);
+  g_assert_nonnull (buffer);
+  g_assert (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  bytes = g_bytes_new (info.data, info.size);
+  gst_buffer_unmap (buffer, &info);
+  gst_sample_unref (result);
+
+  return bytes;
 }
@@ -0,0 +1,490 @@
+/* lp-shm.c -- Shared-memory frame ring.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "play-internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined HAVE_SYS_MMAN_H && HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+/* The ring is a shared-memory object that holds a header, followed by
+   one slot descriptor per slot, followed by the slots' frame data (each
+   one page aligned).  Frames are numbered from 1; frame k is written
+   into slot (k - 1) % slots.  Counters are 32-bit and compared modulo
+   2^32.
+
+   The writer zeroes the descriptor sequence of a slot, copies the frame
+   into it, and then stores the frame number into the descriptor and
+   into the header's write sequence.  A reader owns the frame it has
+   acquired until it releases it.  Under the drop policy the writer never
+   waits, so a held frame may be overwritten; lp_shm_reader_release()
+   reports that.  Under the block policy the writer waits while an
+   attached reader has not released the frame it is about to overwrite;
+   if the reader makes no progress for SHM_BLOCK_TIMEOUT (e.g., because
+   it died without detaching) the writer falls back to the drop policy
+   until the reader releases a frame again.  */
+
+#define SHM_MAGIC          0x4c505348 /* "LPSH" */
+#define SHM_VERSION        1
+#define SHM_POLL_INTERVAL  500        /* microseconds */
+#define SHM_BLOCK_TIMEOUT  G_USEC_PER_SEC /* microseconds */
+
+/* Slot descriptor.  */
+typedef struct _lp_ShmSlot
+{
+  gint seq;                     /* frame number, or 0 while written */
+  guint32 padding;              /* unused */
+  guint64 pts;                  /* frame timestamp (nanoseconds) */
+} lp_ShmSlot;
+
+/* Ring header.  */
+typedef struct _lp_ShmHeader
+{
+  guint32 magic;                /* SHM_MAGIC */
+  guint32 version;              /* SHM_VERSION */
+  guint32 slots;                /* number of slots */
+  guint32 slot_size;            /* bytes of frame data per slot */
+  gint32 width;                 /* frame width */
+  gint32 height;                /* frame height */
+  gint32 stride;                /* frame row stride in bytes */
+  gint blocking;                /* true if policy is block */
+  gint write_seq;               /* last frame written */
+  gint read_seq;                /* last frame released (block policy) */
+  gint readers;                 /* number of attached readers */
+  gint closed;                  /* true if writer is gone */
+  guint64 data_offset;          /* offset of first slot data */
+  lp_ShmSlot slot[];            /* slot descriptors */
+} lp_ShmHeader;
+
+#define shm_seq_get(p)       ((guint) g_atomic_int_get ((p)))
+#define shm_seq_set(p, n)    g_atomic_int_set ((p), (gint)(n))
+#define shm_slot(h, k)       (&(h)->slot[((k) - 1) % (h)->slots])
+#define shm_slot_data(h, k)\
+  ((guint8 *)(h) + (h)->data_offset\
+   + (gsize)(((k) - 1) % (h)->slots) * (h)->slot_size)
+
+/* Shared-memory ring writer.  */
+struct _lp_ShmWriter
+{
+  gchar *name;                  /* shared-memory object name */
+  lp_ShmHeader *header;         /* mapped ring */
+  gsize size;                   /* mapped size in bytes */
+  gint flushing;                /* true if writes must not block */
+  gboolean stalled;             /* true if reader stopped releasing */
+  guint stalled_seq;            /* read sequence when reader stalled */
+};
+
+/* Shared-memory ring reader.  */
+struct _lp_ShmReader
+{
+  lp_ShmHeader *header;         /* mapped ring */
+  gsize size;                   /* mapped size in bytes */
+  guint last;                   /* last frame acquired */
+  guint held;                   /* frame currently held (or 0) */
+};
+
+
+/* internal */
+
+/* Creates the shared-memory ring @name with @slots slots for BGRA
+   frames of @width x @height.  If @blocking is true, writes block while
+   an attached reader lags the writer by @slots frames; otherwise, old
+   frames are overwritten; the block policy supports a single reader.
+   Fails if a ring named @name already exists.  Returns the new writer if
+   successful, or NULL otherwise.  */
+
+lp_ShmWriter *
+_lp_shm_writer_new (const gchar *name, guint slots, gint width,
+                    gint height, gboolean blocking)
+{
+#if defined HAVE_SHM_OPEN && HAVE_SHM_OPEN
+  lp_ShmWriter *writer;
+  lp_ShmHeader *header;
+  gsize page;
+  gsize slot_size;
+  gsize data_offset;
+  gsize size;
+  gpointer data;
+  gint fd;
+
+  g_assert_nonnull (name);
+  g_assert (slots > 0);
+  g_assert (width > 0 && height > 0);
+
+  page = (gsize) sysconf (_SC_PAGESIZE);
+  slot_size = GST_ROUND_UP_N ((gsize) width * height * 4, page);
+  data_offset = GST_ROUND_UP_N (sizeof (lp_ShmHeader)
+                                + slots * sizeof (lp_ShmSlot), page);
+  size = data_offset + slots * slot_size;
+
+  fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (unlikely (fd < 0))
+    {
+      _lp_warn ("cannot create shared memory %s: %s", name,
+                g_strerror (errno));
+      return NULL;
+    }
+
+  if (unlikely (ftruncate (fd, (off_t) size) < 0))
+    {
+      _lp_warn ("cannot resize shared memory %s: %s", name,
+                g_strerror (errno));
+      goto fail;
+    }
+
+  data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (unlikely (data == MAP_FAILED))
+    {
+      _lp_warn ("cannot map shared memory %s: %s", name,
+                g_strerror (errno));
+      goto fail;
+    }
+  close (fd);
+
+  header = (lp_ShmHeader *) data;
+  header->slots = slots;
+  header->slot_size = (guint32) slot_size;
+  header->width = width;
+  header->height = height;
+  header->stride = width * 4;
+  header->blocking = blocking;
+  header->data_offset = data_offset;
+  header->version = SHM_VERSION;
+  g_atomic_int_set ((gint *) &header->magic, SHM_MAGIC); /* ready */
+
+  writer = g_new0 (lp_ShmWriter, 1);
+  writer->name = g_strdup (name);
+  writer->header = header;
+  writer->size = size;
+  writer->flushing = FALSE;
+  writer->stalled = FALSE;
+  writer->stalled_seq = 0;
+
+  return writer;
+
+ fail:
+  close (fd);
+  shm_unlink (name);
+  return NULL;
+#else
+  _lp_warn ("shared memory is not supported: %s", name);
+  return NULL;
+#endif
+}
+
+/* Closes the ring of @writer, unlinks it, and releases @writer.  Readers
+   already attached keep their mapping.  */
+
+void
+_lp_shm_writer_free (lp_ShmWriter *writer)
+{
+#if defined HAVE_SHM_OPEN && HAVE_SHM_OPEN
+  g_atomic_int_set (&writer->header->closed, TRUE);
+  munmap (writer->header, writer->size);
+  shm_unlink (writer->name);
+#endif
+  g_free (writer->name);
+  g_free (writer);
+}
+
+/* Sets whether writes to @writer must return without blocking.  Must be
+   set before the pipeline feeding @writer is stopped.  */
+
+void
+_lp_shm_writer_set_flushing (lp_ShmWriter *writer, gboolean flushing)
+{
+  g_atomic_int_set (&writer->flushing, flushing);
+}
+
+/* Copies frame @buffer with timestamp @pts into the next slot of
+   @writer.  Returns true if successful, or false if the frame was
+   discarded because @writer is flushing.  */
+
+gboolean
+_lp_shm_writer_write (lp_ShmWriter *writer, GstBuffer *buffer,
+                      GstClockTime pts)
+{
+  lp_ShmHeader *header;
+  lp_ShmSlot *slot;
+  gint64 deadline;
+  guint k;
+  guint r;
+
+  header = writer->header;
+  k = shm_seq_get (&header->write_seq) + 1;
+  deadline = 0;
+
+  while (header->blocking
+         && g_atomic_int_get (&header->readers) > 0
+         && k - (r = shm_seq_get (&header->read_seq)) > header->slots)
+    {
+      gint64 now;
+
+      if (g_atomic_int_get (&writer->flushing))
+        return FALSE;
+
+      if (writer->stalled)
+        {
+          if (r == writer->stalled_seq)
+            break;              /* reader is still stalled; drop */
+          writer->stalled = FALSE;
+        }
+
+      now = g_get_monotonic_time ();
+      if (deadline == 0)
+        deadline = now + SHM_BLOCK_TIMEOUT;
+      else if (now >= deadline)
+        {
+          _lp_warn ("shared memory %s: reader stalled, dropping frames",
+                    writer->name);
+          writer->stalled = TRUE;
+          writer->stalled_seq = r;
+          break;
+        }
+      g_usleep (SHM_POLL_INTERVAL);
+    }
+
+  slot = shm_slot (header, k);
+  shm_seq_set (&slot->seq, 0);
+  gst_buffer_extract (buffer, 0, shm_slot_data (header, k),
+                      header->slot_size);
+  slot->pts = pts;
+  shm_seq_set (&slot->seq, k);
+  shm_seq_set (&header->write_seq, k);
+
+  return TRUE;
+}
+
+
+/* public */
+
+/**
+ * lp_shm_reader_open:
+ * @name: name of the shared-memory ring, as set in the scene property
+ * "shm-export"
+ *
+ * Attaches to the frame ring exported by a scene, possibly of another
+ * process.  Frames are BGRA images; see lp_shm_reader_get_format().
+ * Readers start at the most recent frame.
+ *
+ * Returns: (transfer full): a new reader if successful, or %NULL
+ * otherwise
+ */
+lp_ShmReader *
+lp_shm_reader_open (const gchar *name)
+{
+#if defined HAVE_SHM_OPEN && HAVE_SHM_OPEN
+  lp_ShmReader *reader;
+  lp_ShmHeader *header;
+  lp_ShmHeader head;
+  struct stat st;
+  gpointer data;
+  gint fd;
+
+  g_assert_nonnull (name);
+
+  fd = shm_open (name, O_RDWR, 0);
+  if (unlikely (fd < 0))
+    return NULL;
+
+  /* Validate the header before mapping the ring, so that a foreign or
+     truncated object is never indexed.  The magic is stored last by the
+     writer, hence a ring still being created is rejected too.  */
+  if (unlikely (fstat (fd, &st) < 0
+                || (gsize) st.st_size < sizeof (lp_ShmHeader)
+                || pread (fd, &head, sizeof (head), 0)
+                != (ssize_t) sizeof (head)
+                || head.magic != SHM_MAGIC
+                || head.version != SHM_VERSION
+                || head.slots == 0
+                || head.slot_size == 0
+                || head.width <= 0 || head.height <= 0
+                || (guint64) head.stride * (guint64) head.height
+                > head.slot_size
+                || head.data_offset < sizeof (lp_ShmHeader)
+                + (guint64) head.slots * sizeof (lp_ShmSlot)
+                || head.data_offset
+                + (guint64) head.slots * head.slot_size
+                > (guint64) st.st_size))
+    {
+      close (fd);
+      return NULL;
+    }
+
+  data = mmap (NULL, (gsize) st.st_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+  close (fd);
+  if (unlikely (data == MAP_FAILED))
+    return NULL;
+
+  header = (lp_ShmHeader *) data;
+  if (unlikely (header->slots != head.slots
+                || header->slot_size != head.slot_size
+                || header->data_offset != head.data_offset))
+    {
+      munmap (data, (gsize) st.st_size); /* changed while mapping */
+      return NULL;
+    }
+
+  reader = g_new0 (lp_ShmReader, 1);
+  reader->header = header;
+  reader->size = (gsize) st.st_size;
+  reader->last = shm_seq_get (&header->write_seq);
+  reader->held = 0;
+
+  g_atomic_int_inc (&header->readers);
+  if (header->blocking)
+    shm_seq_set (&header->read_seq, reader->last);
+
+  return reader;
+#else
+  (void) name;
+  return NULL;
+#endif
+}
+
+/**
+ * lp_shm_reader_close:
+ * @reader: an #lp_ShmReader
+ *
+ * Releases the frame held by @reader, if any, detaches @reader from its
+ * ring, and frees it.
+ */
+void
+lp_shm_reader_close (lp_ShmReader *reader)
+{
+  if (reader->held != 0)
+    lp_shm_reader_release (reader);
+#if defined HAVE_SHM_OPEN && HAVE_SHM_OPEN
+  g_atomic_int_add (&reader->header->readers, -1);
+  munmap (reader->header, reader->size);
+#endif
+  g_free (reader);
+}
+
+/**
+ * lp_shm_reader_get_format:
+ * @reader: an #lp_ShmReader
+ * @width: (out) (optional): return location for the frame width
+ * @height: (out) (optional): return location for the frame height
+ * @stride: (out) (optional): return location for the frame row stride
+ *
+ * Gets the format of the frames of @reader.  Frames are BGRA images of
+ * @width x @height pixels whose rows are @stride bytes apart.
+ */
+void
+lp_shm_reader_get_format (lp_ShmReader *reader, gint *width, gint *height,
+                          gint *stride)
+{
+  set_if_nonnull (width, reader->header->width);
+  set_if_nonnull (height, reader->header->height);
+  set_if_nonnull (stride, reader->header->stride);
+}
+
+/**
+ * lp_shm_reader_acquire:
+ * @reader: an #lp_ShmReader
+ * @timeout: maximum time to wait (in nanoseconds), or
+ * %LP_CLOCK_TIME_INVALID to wait forever
+ * @seq: (out) (optional): return location for the frame number
+ * @pts: (out) (optional): return location for the frame timestamp
+ *
+ * Waits for a frame newer than the last one acquired by @reader and
+ * holds it.  Under the block policy, this is the next frame in sequence,
+ * unless @reader stalled long enough for the scene to overwrite it;
+ * under the drop policy, it is the most recent frame.  Gaps in @seq
+ * count the frames missed.  The frame data is read in place, without
+ * copies, until lp_shm_reader_release() is called.
+ *
+ * Returns: (transfer none): the frame data if successful, or %NULL on
+ * timeout or if the ring has been closed by its scene
+ */
+gconstpointer
+lp_shm_reader_acquire (lp_ShmReader *reader, guint64 timeout, guint *seq,
+                       guint64 *pts)
+{
+  lp_ShmHeader *header;
+  gint64 deadline;
+  guint k;
+
+  g_assert (reader->held == 0);
+  header = reader->header;
+  deadline = (timeout == LP_CLOCK_TIME_INVALID) ? G_MAXINT64
+    : g_get_monotonic_time () + (gint64)(timeout / 1000);
+
+  for (;;)
+    {
+      guint w;
+
+      w = shm_seq_get (&header->write_seq);
+      if (w != reader->last)
+        {
+          /* Under the block policy, a reader that stalled may have
+             been overrun; it then resumes at the most recent frame.  */
+          k = (header->blocking && w - reader->last <= header->slots)
+            ? reader->last + 1 : w;
+          if (shm_seq_get (&shm_slot (header, k)->seq) == k)
+            break;              /* frame is complete */
+        }
+
+      if (g_atomic_int_get (&header->closed)
+          || g_get_monotonic_time () >= deadline)
+        return NULL;
+
+      g_usleep (SHM_POLL_INTERVAL);
+    }
+
+  reader->held = k;
+  set_if_nonnull (seq, k);
+  set_if_nonnull (pts, shm_slot (header, k)->pts);
+
+  return shm_slot_data (header, k);
+}
+
+/**
+ * lp_shm_reader_release:
+ * @reader: an #lp_ShmReader
+ *
+ * Releases the frame held by @reader.  Under the block policy, this lets
+ * the scene reuse its slot.
+ *
+ * Returns: %TRUE if the frame was intact while held, or %FALSE if it was
+ * overwritten by the scene (drop policy or stalled reader)
+ */
+gboolean
+lp_shm_reader_release (lp_ShmReader *reader)
+{
+  lp_ShmHeader *header;
+  guint k;
+
+  g_assert (reader->held != 0);
+  header = reader->header;
+  k = reader->held;
+
+  reader->last = k;
+  reader->held = 0;
+  if (header->blocking)
+    shm_seq_set (&header->read_seq, k);
+
+  return shm_seq_get (&shm_slot (header, k)->seq) == k;
+}
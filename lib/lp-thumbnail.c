@@ -0,0 +1,463 @@
+/* lp-thumbnail.c -- Thumbnail generation.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "play-internal.h"
+
+#include <gst/app/gstappsink.h>
+
+/* Maximum number of thumbnail worker threads.  */
+#define THUMBNAIL_MAX_THREADS  4
+
+/* Time to wait for a thumbnail pipeline to preroll.  */
+#define THUMBNAIL_TIMEOUT      (10 * GST_SECOND)
+
+/* Format of thumbnail images.  */
+#define THUMBNAIL_FORMAT       "RGBA"
+#define THUMBNAIL_BPP          4  /* bytes per pixel */
+
+/* Thumbnail strip request.  */
+typedef struct _lp_ThumbnailStrip
+{
+  GMutex mutex;                 /* serializes calls to func */
+  gchar *uri;                   /* content URI */
+  guint n;                      /* number of thumbnails */
+  gint width;                   /* thumbnail width */
+  gint height;                  /* thumbnail height */
+  lp_ThumbnailFunc func;        /* user callback */
+  gpointer data;                /* user data */
+  gint pending;                 /* jobs not yet finished */
+} lp_ThumbnailStrip;
+
+/* Thumbnail job: thumbnails @first, @first + @step, ... of a strip, which
+   are decoded by a single pipeline.  */
+typedef struct _lp_ThumbnailJob
+{
+  lp_ThumbnailStrip *strip;     /* parent strip */
+  guint first;                  /* index of first thumbnail */
+  guint step;                   /* distance between thumbnail indices */
+} lp_ThumbnailJob;
+
+/* Shared worker pool.  */
+static GThreadPool *thumbnail_pool = NULL;
+
+static void
+thumbnail_strip_unref (lp_ThumbnailStrip *strip)
+{
+  if (!g_atomic_int_dec_and_test (&strip->pending))
+    return;
+
+  g_mutex_clear (&strip->mutex);
+  g_free (strip->uri);
+  g_free (strip);
+}
+
+/* Stops the thumbnail decoder from plugging decoders for the audio and
+   subtitle streams, which are exposed as they are and then discarded.  */
+
+static gboolean
+lp_thumbnail_autoplug_continue_callback (arg_unused (GstElement *decoder),
+                                         arg_unused (GstPad *pad),
+                                         GstCaps *caps,
+                                         arg_unused (gpointer data))
+{
+  const gchar *name;
+
+  if (gst_caps_is_empty (caps) || gst_caps_is_any (caps))
+    return TRUE;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  return !(g_str_has_prefix (name, "audio/")
+           || g_str_has_prefix (name, "text/")
+           || g_str_has_prefix (name, "subpicture/"));
+}
+
+/* Links the video pads of the thumbnail decoder to the scaler @scale,
+   and discards the other streams.  */
+
+static void
+lp_thumbnail_pad_added_callback (GstElement *decoder, GstPad *pad,
+                                 GstElement *scale)
+{
+  GstCaps *caps;
+  GstElement *pipeline;
+  GstElement *sink;
+  GstPad *sinkpad;
+  const gchar *name;
+
+  caps = gst_pad_query_caps (pad, NULL);
+  g_assert_nonnull (caps);
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  if (g_str_equal (name, "video/x-raw"))
+    {
+      sinkpad = gst_element_get_static_pad (scale, "sink");
+      g_assert_nonnull (sinkpad);
+      if (!gst_pad_is_linked (sinkpad))
+        g_assert (gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK);
+      gst_object_unref (sinkpad);
+      gst_caps_unref (caps);
+      return;
+    }
+  gst_caps_unref (caps);
+
+  pipeline = GST_ELEMENT (gst_element_get_parent (decoder));
+  g_assert_nonnull (pipeline);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_assert_nonnull (sink);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gstx_bin_add (pipeline, sink);
+  gstx_element_sync_state_with_parent (sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  g_assert_nonnull (sinkpad);
+  g_assert (gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+  gst_object_unref (pipeline);
+}
+
+/* Sends EOS to scaler @scale if the thumbnail decoder has found no video
+   stream, so that the pipeline prerolls without a frame.  */
+
+static void
+lp_thumbnail_no_more_pads_callback (arg_unused (GstElement *decoder),
+                                    GstElement *scale)
+{
+  GstPad *sinkpad;
+
+  sinkpad = gst_element_get_static_pad (scale, "sink");
+  g_assert_nonnull (sinkpad);
+  if (!gst_pad_is_linked (sinkpad))
+    gst_pad_send_event (sinkpad, gst_event_new_eos ());
+  gst_object_unref (sinkpad);
+}
+
+/* Builds the pipeline that decodes @uri and outputs frames scaled to
+   @width x @height into *@appsink.  Frames are scaled before they are
+   converted, so that the conversion works on thumbnail-sized frames, and
+   the size is fixed by the caps of the sink, so that decoders that can
+   output downscaled frames negotiate them.  Audio and subtitle streams
+   are linked to fake sinks without being decoded.  */
+
+static GstElement *
+thumbnail_pipeline_new (const gchar *uri, gint width, gint height,
+                        GstElement **appsink)
+{
+  GstElement *pipeline;
+  GstElement *decoder;
+  GstElement *convert;
+  GstElement *scale;
+  GstElement *sink;
+  GstCaps *caps;
+
+  pipeline = gst_pipeline_new (NULL);
+  decoder = gst_element_factory_make ("uridecodebin", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  scale = gst_element_factory_make ("videoscale", NULL);
+  sink = gst_element_factory_make ("appsink", NULL);
+  g_assert_nonnull (pipeline);
+  g_assert_nonnull (decoder);
+  g_assert_nonnull (convert);
+  g_assert_nonnull (scale);
+  g_assert_nonnull (sink);
+
+  caps = gst_caps_new_empty_simple ("video/x-raw");
+  g_assert_nonnull (caps);
+  g_object_set (decoder, "uri", uri, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_new_simple ("video/x-raw",
+                              "format", G_TYPE_STRING, THUMBNAIL_FORMAT,
+                              "width", G_TYPE_INT, width,
+                              "height", G_TYPE_INT, height,
+                              "pixel-aspect-ratio", GST_TYPE_FRACTION,
+                              1, 1, NULL);
+  g_assert_nonnull (caps);
+  g_object_set (sink, "caps", caps, "sync", FALSE,
+                "max-buffers", 1, "drop", TRUE, NULL);
+  gst_caps_unref (caps);
+
+  gstx_bin_add (pipeline, decoder);
+  gstx_bin_add (pipeline, scale);
+  gstx_bin_add (pipeline, convert);
+  gstx_bin_add (pipeline, sink);
+  gstx_element_link (scale, convert);
+  gstx_element_link (convert, sink);
+
+  g_signal_connect (decoder, "autoplug-continue",
+                    G_CALLBACK (lp_thumbnail_autoplug_continue_callback),
+                    NULL);
+  g_signal_connect (decoder, "pad-added",
+                    G_CALLBACK (lp_thumbnail_pad_added_callback), scale);
+  g_signal_connect (decoder, "no-more-pads",
+                    G_CALLBACK (lp_thumbnail_no_more_pads_callback),
+                    scale);
+
+  *appsink = sink;
+  return pipeline;
+}
+
+/* Waits for @pipeline to preroll.  Returns true if successful.  */
+
+static gboolean
+thumbnail_pipeline_preroll (GstElement *pipeline)
+{
+  GstStateChangeReturn ret;
+
+  ret = gst_element_get_state (pipeline, NULL, NULL, THUMBNAIL_TIMEOUT);
+  return ret == GST_STATE_CHANGE_SUCCESS
+    || ret == GST_STATE_CHANGE_NO_PREROLL;
+}
+
+/* Pulls the frame prerolled by @sink as a thumbnail image of @strip.
+   Returns the image (or NULL on failure) and, if the frame has a
+   timestamp, stores it into *@time.  */
+
+static GBytes *
+thumbnail_pull_image (lp_ThumbnailStrip *strip, GstElement *sink,
+                      guint64 *time)
+{
+  GstSample *sample;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  GBytes *image = NULL;
+
+  sample = gst_app_sink_pull_preroll (GST_APP_SINK (sink));
+  if (unlikely (sample == NULL))
+    return NULL;
+
+  buffer = gst_sample_get_buffer (sample);
+  g_assert_nonnull (buffer);
+  if (GST_BUFFER_PTS_IS_VALID (buffer))
+    *time = GST_BUFFER_PTS (buffer);
+  g_assert (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  if (info.size == (gsize) strip->width * strip->height * THUMBNAIL_BPP)
+    image = g_bytes_new (info.data, info.size);
+  gst_buffer_unmap (buffer, &info);
+  gst_sample_unref (sample);
+
+  return image;
+}
+
+/* Decodes the thumbnail @index of @strip from @pipeline, which has
+   prerolled, outputs into @sink, and plays a stream of @duration.  The
+   pipeline is reused: each thumbnail is reached by a flushing key frame
+   seek from wherever the last one left it, at the middle of its
+   interval.  Returns the thumbnail image (or NULL on failure) and stores
+   its stream time into *@time.  */
+
+static GBytes *
+thumbnail_decode (lp_ThumbnailStrip *strip, GstElement *pipeline,
+                  GstElement *sink, gint64 duration, guint index,
+                  guint64 *time)
+{
+  *time = gst_util_uint64_scale ((guint64) duration, 2 * index + 1,
+                                 2 * strip->n);
+  if (!gst_element_seek_simple
+      (pipeline, GST_FORMAT_TIME,
+       (GstSeekFlags)(GST_SEEK_FLAG_FLUSH
+                      | GST_SEEK_FLAG_KEY_UNIT
+                      | GST_SEEK_FLAG_SNAP_NEAREST),
+       (gint64) *time)
+      || !thumbnail_pipeline_preroll (pipeline))
+    return NULL;
+
+  return thumbnail_pull_image (strip, sink, time);
+}
+
+/* Runs thumbnail job @job in a worker thread.  The job builds a single
+   pipeline, prerolls it once, and then seeks it to each of its
+   thumbnails in turn.  */
+
+static void
+thumbnail_job_run (lp_ThumbnailJob *job, arg_unused (gpointer data))
+{
+  lp_ThumbnailStrip *strip;
+  GstElement *pipeline;
+  GstElement *sink;
+  GBytes *first = NULL;
+  guint64 first_time = 0;
+  gboolean prerolled;
+  gint64 duration = -1;
+  guint i;
+
+  strip = job->strip;
+  pipeline = thumbnail_pipeline_new (strip->uri, strip->width,
+                                     strip->height, &sink);
+
+  prerolled = gst_element_set_state (pipeline, GST_STATE_PAUSED)
+    != GST_STATE_CHANGE_FAILURE
+    && thumbnail_pipeline_preroll (pipeline);
+
+  /* Still images and streams of unknown duration yield their first
+     frame at every index.  */
+  if (prerolled
+      && (!gst_element_query_duration (pipeline, GST_FORMAT_TIME,
+                                       &duration)
+          || duration <= 0))
+    {
+      duration = -1;
+      first = thumbnail_pull_image (strip, sink, &first_time);
+    }
+
+  for (i = job->first; i < strip->n; i += job->step)
+    {
+      GBytes *image = NULL;
+      guint64 time = 0;
+
+      if (first != NULL)
+        {
+          image = g_bytes_ref (first);
+          time = first_time;
+        }
+      else if (prerolled && duration > 0)
+        image = thumbnail_decode (strip, pipeline, sink, duration, i,
+                                  &time);
+
+      g_mutex_lock (&strip->mutex);
+      strip->func (strip->uri, i, time, image, strip->data);
+      g_mutex_unlock (&strip->mutex);
+
+      if (image != NULL)
+        g_bytes_unref (image);
+    }
+
+  if (first != NULL)
+    g_bytes_unref (first);
+  gstx_element_set_state_sync (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  thumbnail_strip_unref (strip);
+  g_free (job);
+}
+
+static gpointer
+thumbnail_pool_init (arg_unused (gpointer data))
+{
+  GThreadPool *pool;
+  GError *error = NULL;
+
+  if (!gst_is_initialized ())
+    {
+      if (unlikely (!gst_init_check (NULL, NULL, &error)))
+        {
+          g_assert_nonnull (error);
+          _lp_error ("%s", error->message);
+          g_error_free (error);
+        }
+    }
+
+  pool = g_thread_pool_new ((GFunc) thumbnail_job_run, NULL,
+                            (gint) CLAMP (g_get_num_processors (), 1,
+                                          THUMBNAIL_MAX_THREADS),
+                            FALSE, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (pool);
+
+  return pool;
+}
+
+
+/* public */
+
+/**
+ * lp_media_generate_thumbnails:
+ * @uri: content URI or file name
+ * @n: number of thumbnails
+ * @width: thumbnail width
+ * @height: thumbnail height
+ * @func: (scope async): function called with each thumbnail
+ * @data: user data to pass to @func
+ *
+ * Generates @n thumbnails evenly spaced over the duration of @uri, each
+ * one an RGBA image of @width x @height pixels.  Thumbnails are taken
+ * from key frames and decoded by a small pool of worker threads, outside
+ * any scene; each worker reuses a single pipeline for its share of the
+ * thumbnails.  Audio streams are discarded without being decoded.
+ *
+ * This function returns immediately.  @func is called exactly @n times,
+ * from the worker threads but never concurrently for the same call, in
+ * no particular order.  It receives the index of the thumbnail, its
+ * stream time (in nanoseconds), and its image, or %NULL if the thumbnail
+ * could not be generated.  Still images yield @n copies of the image.
+ *
+ * Returns: %TRUE if successful, or %FALSE if @uri is invalid
+ */
+gboolean
+lp_media_generate_thumbnails (const gchar *uri, guint n,
+                              gint width, gint height,
+                              lp_ThumbnailFunc func, gpointer data)
+{
+  static GOnce once = G_ONCE_INIT;
+  lp_ThumbnailStrip *strip;
+  gchar *final_uri;
+  guint jobs;
+  guint i;
+
+  g_assert_nonnull (uri);
+  g_assert_nonnull (func);
+  g_assert (width > 0 && height > 0);
+
+  thumbnail_pool = (GThreadPool *) g_once (&once, thumbnail_pool_init,
+                                           NULL);
+
+  if (gst_uri_is_valid (uri))
+    {
+      final_uri = g_strdup (uri);
+    }
+  else
+    {
+      final_uri = gst_filename_to_uri (uri, NULL);
+      if (unlikely (final_uri == NULL))
+        {
+          _lp_warn ("bad URI: %s", uri);
+          return FALSE;
+        }
+    }
+
+  if (unlikely (n == 0))
+    {
+      g_free (final_uri);
+      return TRUE;              /* nothing to do */
+    }
+
+  strip = g_new0 (lp_ThumbnailStrip, 1);
+  g_mutex_init (&strip->mutex);
+  strip->uri = final_uri;
+  strip->n = n;
+  strip->width = width;
+  strip->height = height;
+  strip->func = func;
+  strip->data = data;
+
+  /* One job per worker thread, each with its own pipeline.  */
+  jobs = MIN (n, (guint) g_thread_pool_get_max_threads (thumbnail_pool));
+  strip->pending = (gint) jobs;
+
+  for (i = 0; i < jobs; i++)
+    {
+      lp_ThumbnailJob *job;
+
+      job = g_new0 (lp_ThumbnailJob, 1);
+      job->strip = strip;
+      job->first = i;
+      job->step = jobs;
+      g_assert (g_thread_pool_push (thumbnail_pool, job, NULL));
+    }
+
+  return TRUE;
+}
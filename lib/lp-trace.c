@@ -0,0 +1,152 @@
+/* lp-trace.c -- Trace recorder.
+   Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "play-internal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Trace recorder.  Events are written in the Chrome trace event format
+   (JSON array), which can be opened by chrome://tracing and Perfetto.  */
+struct _lp_Trace
+{
+  GMutex mutex;                 /* sync access to trace */
+  FILE *file;                   /* output file */
+  gint64 epoch;                 /* monotonic time of first event (us) */
+  gint pid;                     /* process id */
+  gboolean empty;               /* true if no event has been written */
+};
+
+#define trace_lock(t)    g_mutex_lock (&(t)->mutex)
+#define trace_unlock(t)  g_mutex_unlock (&(t)->mutex)
+
+/* Returns a copy of @str escaped as the contents of a JSON string.
+   Quotes and backslashes are escaped, control characters are written as
+   \u00XX, and any other byte (including UTF-8 sequences) is copied.  */
+
+static gchar *
+trace_json_escape (const gchar *str)
+{
+  GString *esc;
+  const guchar *p;
+
+  esc = g_string_sized_new (strlen (str));
+  for (p = (const guchar *) str; *p != '\0'; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        {
+          g_string_append_c (esc, '\\');
+          g_string_append_c (esc, (gchar) *p);
+        }
+      else if (*p < 0x20)
+        {
+          g_string_append_printf (esc, "\\u%04x", (guint) *p);
+        }
+      else
+        {
+          g_string_append_c (esc, (gchar) *p);
+        }
+    }
+
+  return g_string_free (esc, FALSE);
+}
+
+
+/* internal */
+
+/* Creates a new trace recorder that writes to file @path.
+   Returns the new recorder if successful, or NULL otherwise.  */
+
+lp_Trace *
+_lp_trace_open (const gchar *path)
+{
+  lp_Trace *trace;
+  FILE *file;
+
+  g_assert_nonnull (path);
+
+  file = fopen (path, "w");
+  if (unlikely (file == NULL))
+    {
+      _lp_warn ("cannot open trace file %s", path);
+      return NULL;
+    }
+
+  trace = g_new0 (lp_Trace, 1);
+  g_mutex_init (&trace->mutex);
+  trace->file = file;
+  trace->epoch = g_get_monotonic_time ();
+  trace->pid = (gint) getpid ();
+  trace->empty = TRUE;
+
+  fputs ("[", trace->file);
+  return trace;
+}
+
+/* Terminates the trace written by @trace and releases it.  */
+
+void
+_lp_trace_close (lp_Trace *trace)
+{
+  fputs ("\n]\n", trace->file);
+  fclose (trace->file);
+  g_mutex_clear (&trace->mutex);
+  g_free (trace);
+}
+
+/* Records an event with phase @phase ('b' begins and 'e' ends an async
+   span, 'i' is an instant) of category @cat and name @name into @trace.
+   Spans with the same @id, category and name are matched.  If @detail is
+   non-NULL, it is recorded as an argument of the event.  Does nothing if
+   @trace is NULL.  */
+
+void
+_lp_trace_event (lp_Trace *trace, gchar phase, const gchar *cat,
+                 const gchar *name, gconstpointer id, const gchar *detail)
+{
+  gint64 ts;
+  guint tid;
+  gchar *esc;
+
+  if (trace == NULL)
+    return;                     /* tracing disabled */
+
+  ts = g_get_monotonic_time ();
+  tid = (guint) GPOINTER_TO_SIZE (g_thread_self ());
+  esc = (detail != NULL) ? trace_json_escape (detail) : NULL;
+
+  trace_lock (trace);
+
+  fprintf (trace->file,
+           "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+           "\"ts\":%" G_GINT64_FORMAT ",\"pid\":%d,\"tid\":%u,"
+           "\"id\":\"%p\"",
+           trace->empty ? "" : ",", name, cat, phase,
+           ts - trace->epoch, trace->pid, tid, id);
+  if (phase == 'i')
+    fputs (",\"s\":\"t\"", trace->file);
+  if (esc != NULL)
+    fprintf (trace->file, ",\"args\":{\"detail\":\"%s\"}", esc);
+  fputs ("}", trace->file);
+  trace->empty = FALSE;
+
+  trace_unlock (trace);
+  g_free (esc);
+}
@@ -85,6 +85,9 @@ _lp_clock_advance (lp_Clock *, GstClockTime);
 gboolean
 _lp_clock_reset_time (lp_Clock *, guint64);
 
+gboolean
+_lp_clock_set_source (lp_Clock *, GstClock *);
+
 /* event */
 
 gchar *
@@ -121,19 +124,106 @@ lp_EventStop *
 _lp_event_stop_new (lp_Media *, gboolean);
 
 lp_EventSeek *
-_lp_event_seek_new (lp_Media *, gboolean, gint64);
+_lp_event_seek_new (lp_Media *, gboolean, gint64, lp_SeekMode, guint64);
 
 lp_EventPause *
 _lp_event_pause_new (GObject *);
 
+/* mmap source */
+
+#define LP_TYPE_MMAP_SRC (lp_mmap_src_get_type ())
+GX_DECLARE_FINAL_TYPE (lp_MmapSrc, lp_mmap_src, LP, MMAP_SRC, GstBaseSrc)
+
+void
+_lp_mmap_src_register (void);
+
+gchar *
+_lp_mmap_src_get_uri (const gchar *);
+
+/* image cache */
+
+typedef struct _lp_ImageCache lp_ImageCache;
+
+lp_ImageCache *
+_lp_image_cache_new (guint64);
+
+void
+_lp_image_cache_free (lp_ImageCache *);
+
+void
+_lp_image_cache_set_budget (lp_ImageCache *, guint64);
+
+guint64
+_lp_image_cache_get_size (lp_ImageCache *);
+
+gboolean
+_lp_image_cache_lookup (lp_ImageCache *, const gchar *,
+                        GstBuffer **, GstCaps **);
+
+void
+_lp_image_cache_insert (lp_ImageCache *, const gchar *,
+                        GstBuffer *, GstCaps *);
+
+/* trace */
+
+typedef struct _lp_Trace lp_Trace;
+
+lp_Trace *
+_lp_trace_open (const gchar *);
+
+void
+_lp_trace_close (lp_Trace *);
+
+void
+_lp_trace_event (lp_Trace *, gchar, const gchar *, const gchar *,
+                 gconstpointer, const gchar *);
+
+#define _lp_trace_begin(t, cat, name, id, detail)\
+  _lp_trace_event ((t), 'b', (cat), (name), (id), (detail))
+
+#define _lp_trace_end(t, cat, name, id)\
+  _lp_trace_event ((t), 'e', (cat), (name), (id), NULL)
+
+#define _lp_trace_instant(t, cat, name, id, detail)\
+  _lp_trace_event ((t), 'i', (cat), (name), (id), (detail))
+
+/* shared-memory frame ring */
+
+typedef struct _lp_ShmWriter lp_ShmWriter;
+
+lp_ShmWriter *
+_lp_shm_writer_new (const gchar *, guint, gint, gint, gboolean);
+
+void
+_lp_shm_writer_free (lp_ShmWriter *);
+
+void
+_lp_shm_writer_set_flushing (lp_ShmWriter *, gboolean);
+
+gboolean
+_lp_shm_writer_write (lp_ShmWriter *, GstBuffer *, GstClockTime);
+
 /* media */
 
+/* Groups of media states counted in scene statistics.  */
+typedef enum
+{
+  LP_MEDIA_GROUP_STOPPED = 0,   /* stopped */
+  LP_MEDIA_GROUP_STARTED,       /* started or seeking */
+  LP_MEDIA_GROUP_PAUSED,        /* paused */
+  LP_MEDIA_GROUP_BUSY,          /* starting, stopping, pausing, resuming */
+  LP_MEDIA_GROUP_NONE,          /* not counted */
+} lp_MediaGroup;
+
 lp_Media *
 _lp_media_find_media (GstObject *);
 
 void
 _lp_media_finish_error (lp_Media *);
 
+void
+_lp_media_finish_preroll (lp_Media *);
+
 void
 _lp_media_finish_start (lp_Media *);
 
@@ -143,12 +233,28 @@ _lp_media_finish_stop (lp_Media *);
 void
 _lp_media_finish_pause (lp_Media *);
 
-void
+gboolean
 _lp_media_finish_seek (lp_Media *);
 
 void
 _lp_media_finish_resume (lp_Media *);
 
+void
+_lp_media_update_buffering (lp_Media *, gint);
+
+void
+_lp_media_update_qos (lp_Media *, guint64);
+
+guint64
+_lp_media_get_display_area (lp_Media *);
+
+void
+_lp_media_set_threads (lp_Media *, guint);
+
+gboolean
+_lp_media_get_latency (lp_Media *, gboolean, GstClockTime *,
+                       GstClockTime *);
+
 /* scene */
 
 GstElement *
@@ -166,6 +272,18 @@ _lp_scene_get_real_audio_sink (lp_Scene *); /* transfer-full */
 GstElement *
 _lp_scene_get_real_video_sink (lp_Scene *); /* transfer-full */
 
+lp_ImageCache *
+_lp_scene_get_image_cache (lp_Scene *);
+
+lp_Trace *
+_lp_scene_get_trace (lp_Scene *);
+
+GstCaps *
+_lp_scene_get_audio_caps (lp_Scene *); /* transfer-full */
+
+gint
+_lp_scene_get_resample_quality (lp_Scene *);
+
 GstClockTime
 _lp_scene_get_running_time (lp_Scene *);
 
@@ -175,9 +293,15 @@ _lp_scene_get_start_time (lp_Scene *);
 gboolean
 _lp_scene_has_video (lp_Scene *);
 
-void
+gboolean
 _lp_scene_add_media (lp_Scene *, lp_Media *);
 
+void
+_lp_scene_count_media (lp_Scene *, lp_MediaGroup, lp_MediaGroup);
+
+void
+_lp_scene_count_contention (lp_Scene *);
+
 void
 _lp_scene_step (lp_Scene *, gboolean);
 
@@ -190,6 +314,9 @@ _lp_scene_is_paused (lp_Scene *);
 guint64
 _lp_scene_get_offset_last_buffer (lp_Scene *);
 
+void
+_lp_scene_rebalance_threads (lp_Scene *);
+
 /* common */
 void
 _lp_common_appsrc_transparent_data (GstElement *, guint, gpointer);
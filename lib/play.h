@@ -185,6 +185,119 @@ typedef enum
   LP_ERROR_LAST,                /* total number of error codes */
 } lp_Error;
 
+/**
+ * lp_SeekMode:
+ * @LP_SEEK_MODE_ACCURATE: Seek exactly to the requested position.
+ * @LP_SEEK_MODE_KEYFRAME: Seek to the nearest key frame.
+ * @LP_SEEK_MODE_REFINE: Seek to the nearest key frame, then seek exactly
+ * to the requested position.
+ * @LP_SEEK_MODE_LAST: Total number of #lp_SeekMode types.
+ *
+ * Types of seek.
+ */
+typedef enum
+{
+  LP_SEEK_MODE_ACCURATE = 0,    /* accurate seek */
+  LP_SEEK_MODE_KEYFRAME,        /* key frame seek */
+  LP_SEEK_MODE_REFINE,          /* key frame seek followed by accurate seek */
+  LP_SEEK_MODE_LAST,            /* total number of seek modes */
+} lp_SeekMode;
+
+/**
+ * lp_OutputType:
+ * @LP_OUTPUT_VIDEO: The output receives the composed video.
+ * @LP_OUTPUT_AUDIO: The output receives the mixed audio.
+ *
+ * Types of scene output.
+ */
+typedef enum
+{
+  LP_OUTPUT_VIDEO = 0,          /* composed video */
+  LP_OUTPUT_AUDIO,              /* mixed audio */
+} lp_OutputType;
+
+/**
+ * lp_Latency:
+ * @total: Total latency of the scene pipeline (in nanoseconds).
+ * @decode: Latency of the slowest media decoder (in nanoseconds).
+ * @convert: Latency of the slowest media converter (in nanoseconds).
+ * @mixer: Latency added by the scene mixer (in nanoseconds).
+ * @sink: Latency added after the mixer, including the sink (in
+ * nanoseconds).
+ * @live: Whether the scene pipeline is live.
+ *
+ * Latency of a scene broken down by processing stage.
+ */
+typedef struct _lp_Latency
+{
+  guint64 total;                /* total latency */
+  guint64 decode;               /* decoding latency */
+  guint64 convert;              /* conversion latency */
+  guint64 mixer;                /* mixing latency */
+  guint64 sink;                 /* output latency */
+  gboolean live;                /* true if pipeline is live */
+} lp_Latency;
+
+/**
+ * lp_SceneStats:
+ * @frames_composed: Number of video frames composed by the scene mixer.
+ * @frames_dropped: Number of video frames dropped by the scene sink.
+ * @events_dispatched: Number of events queued for the application.
+ * @events_received: Number of events returned by lp_scene_receive().
+ * @events_masked: Number of events discarded by the scene event mask.
+ * @events_pending_max: Largest number of events pending at once.
+ * @media_stopped: Number of child media that are stopped.
+ * @media_started: Number of child media that are playing.
+ * @media_paused: Number of child media that are paused.
+ * @media_busy: Number of child media that are starting, stopping,
+ * seeking, pausing or resuming.
+ * @lock_time: Total time threads have waited for the scene lock when it
+ * was found taken (in nanoseconds).
+ * @lock_contended: Number of times a thread had to wait for the scene lock
+ * or for the lock of a child media.
+ *
+ * Run-time statistics of a scene.
+ */
+typedef struct _lp_SceneStats
+{
+  guint64 frames_composed;      /* frames composed by mixer */
+  guint64 frames_dropped;       /* frames dropped by sink */
+  guint64 events_dispatched;    /* events queued */
+  guint64 events_received;      /* events received */
+  guint64 events_masked;        /* events discarded by mask */
+  guint64 events_pending_max;   /* event queue high-water mark */
+  guint64 media_stopped;        /* stopped media */
+  guint64 media_started;        /* playing media */
+  guint64 media_paused;         /* paused media */
+  guint64 media_busy;           /* media in transition */
+  guint64 lock_time;            /* time waiting for scene lock */
+  guint64 lock_contended;       /* waits for scene or media lock */
+} lp_SceneStats;
+
+/**
+ * lp_ThumbnailFunc:
+ * @uri: content URI
+ * @index: thumbnail index
+ * @time: thumbnail stream time (in nanoseconds)
+ * @image: (nullable): thumbnail RGBA image, or %NULL on failure
+ * @data: user data
+ *
+ * Function called by lp_media_generate_thumbnails() with each
+ * thumbnail.
+ */
+typedef void (*lp_ThumbnailFunc) (const gchar *uri, guint index,
+                                  guint64 time, GBytes *image,
+                                  gpointer data);
+
+/**
+ * lp_ShmReader:
+ *
+ * Reader of the frames exported by a scene into shared memory.
+ * #lp_ShmReader is an opaque data structure and can only be accessed
+ * using the lp_shm_reader_*() functions.
+ */
+typedef struct _lp_ShmReader lp_ShmReader;
+
 #define LP_ERROR lp_error_quark ()
 LP_API
 GQuark lp_error_quark (void);
@@ -235,6 +348,10 @@ lp_media_pause (lp_Media *);
 LP_API gboolean
 lp_media_resume (lp_Media *);
 
+LP_API gboolean
+lp_media_generate_thumbnails (const gchar *, guint, gint, gint,
+                              lp_ThumbnailFunc, gpointer);
+
 /* scene */
 
 LP_API lp_Scene *
@@ -246,6 +363,9 @@ lp_scene_to_string (lp_Scene *);
 LP_API gboolean
 lp_scene_advance (lp_Scene *, guint64);
 
+LP_API gboolean
+lp_scene_advance_group (lp_Scene **, guint, guint64);
+
 LP_API lp_Event *
 lp_scene_receive (lp_Scene *, gboolean);
 
@@ -261,6 +381,38 @@ lp_scene_resume (lp_Scene *);
 LP_API guint64
 lp_scene_get_current_time (lp_Scene *);
 
+LP_API gboolean
+lp_scene_get_latency (lp_Scene *, lp_Latency *);
+
+LP_API void
+lp_scene_get_stats (lp_Scene *, lp_SceneStats *);
+
+LP_API guint
+lp_scene_add_output (lp_Scene *, lp_OutputType, const gchar *);
+
+LP_API gboolean
+lp_scene_remove_output (lp_Scene *, guint);
+
+LP_API GBytes *
+lp_scene_snapshot (lp_Scene *, const gchar *, gint, gint);
+
+/* shared-memory frame reader */
+
+LP_API lp_ShmReader *
+lp_shm_reader_open (const gchar *);
+
+LP_API void
+lp_shm_reader_close (lp_ShmReader *);
+
+LP_API void
+lp_shm_reader_get_format (lp_ShmReader *, gint *, gint *, gint *);
+
+LP_API gconstpointer
+lp_shm_reader_acquire (lp_ShmReader *, guint64, guint *, guint64 *);
+
+LP_API gboolean
+lp_shm_reader_release (lp_ShmReader *);
+
 LP_END_DECLS
 
 #endif /* PLAY_H */
@@ -0,0 +1,93 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+#define READERS 4
+#define STEPS   10000
+
+static gint done = 0;
+
+/* Reads @data clock until told to stop; lock-step time must be
+   monotonic and advance in whole milliseconds.  */
+
+static gpointer
+reader (gpointer data)
+{
+  GstClock *clock;
+  GstClockTime last = 0;
+
+  clock = GST_CLOCK (data);
+  while (!g_atomic_int_get (&done))
+    {
+      GstClockTime time;
+
+      time = gst_clock_get_internal_time (clock);
+      g_assert (time >= last);
+      g_assert (time % GST_MSECOND == 0);
+      last = time;
+    }
+
+  return NULL;
+}
+
+int
+main (void)
+{
+  GstClock *clock;
+  GThread *thread[READERS];
+  GstClockTime time;
+  gint i;
+
+  clock = GST_CLOCK (g_object_new (LP_TYPE_CLOCK, "lockstep", TRUE, NULL));
+  g_assert_nonnull (clock);
+  g_assert (_lp_clock_reset_time (LP_CLOCK (clock), 0));
+
+  for (i = 0; i < READERS; i++)
+    {
+      thread[i] = g_thread_new ("reader", reader, clock);
+      g_assert_nonnull (thread[i]);
+    }
+
+  for (i = 0; i < STEPS; i++)
+    g_assert (_lp_clock_advance (LP_CLOCK (clock), GST_MSECOND));
+
+  g_atomic_int_set (&done, 1);
+  for (i = 0; i < READERS; i++)
+    g_thread_join (thread[i]);
+
+  g_assert (gst_clock_get_internal_time (clock) == STEPS * GST_MSECOND);
+
+  /* Real-time mode resumes from the lock-step time.  */
+  g_object_set (clock, "lockstep", FALSE, NULL);
+  time = gst_clock_get_internal_time (clock);
+  g_assert (time >= STEPS * GST_MSECOND);
+  g_assert (!_lp_clock_advance (LP_CLOCK (clock), GST_MSECOND));
+  g_usleep (1000);
+  g_assert (gst_clock_get_internal_time (clock) > time);
+
+  /* Lock-step mode freezes the real time.  */
+  g_object_set (clock, "lockstep", TRUE, NULL);
+  time = gst_clock_get_internal_time (clock);
+  g_usleep (1000);
+  g_assert (gst_clock_get_internal_time (clock) == time);
+
+  g_object_unref (clock);
+
+  exit (EXIT_SUCCESS);
+}
@@ -21,6 +21,6 @@ int
 main (void)
 {
   TEST_TEMPLATE_EVENT_XFAIL_SET
-    (_lp_event_seek_new (media, FALSE, 0));
+    (_lp_event_seek_new (media, FALSE, 0, LP_SEEK_MODE_ACCURATE, 0));
   exit (EXIT_SUCCESS);
 }
@@ -29,6 +29,8 @@ main (void)
   lp_EventMask mask = 0;
   gboolean relative = FALSE;
   gint64 offset = G_MAXINT64;
+  lp_SeekMode mode = LP_SEEK_MODE_LAST;
+  guint64 latency = 0;
 
   scene = LP_SCENE (g_object_new (LP_TYPE_SCENE, "lockstep", TRUE, NULL));
   g_assert_nonnull (scene);
@@ -36,14 +38,16 @@ main (void)
   media = lp_media_new (scene, SAMPLE_GNU);
   g_assert_nonnull (media);
 
-  event = _lp_event_seek_new (media, TRUE, 0);
+  event = _lp_event_seek_new (media, TRUE, 0, LP_SEEK_MODE_KEYFRAME, 1000);
   g_assert_nonnull (event);
 
   g_object_get (event,
                 "source", &source,
                 "mask", &mask,
                 "relative", &relative,
-                "offset", &offset, NULL);
+                "offset", &offset,
+                "mode", &mode,
+                "latency", &latency, NULL);
 
   str = lp_event_to_string (LP_EVENT (event));
   g_assert_nonnull (str);
@@ -54,6 +58,8 @@ main (void)
   g_assert (mask == LP_EVENT_MASK_SEEK);
   g_assert (relative == TRUE);
   g_assert (offset == 0);
+  g_assert (mode == LP_SEEK_MODE_KEYFRAME);
+  g_assert (latency == 1000);
 
   g_object_unref (event);
   g_object_unref (scene);
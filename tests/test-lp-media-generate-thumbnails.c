@@ -0,0 +1,111 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+#define N       4
+#define WIDTH   64
+#define HEIGHT  48
+
+/* Thumbnails received so far.  */
+static GMutex mutex;
+static GCond cond;
+static guint received;
+static guint64 times[N];
+static GBytes *images[N];
+
+static void
+collect (const gchar *uri, guint index, guint64 time, GBytes *image,
+         arg_unused (gpointer data))
+{
+  g_assert_nonnull (uri);
+  g_assert (index < N);
+
+  g_mutex_lock (&mutex);
+  g_assert_null (images[index]);
+  times[index] = time;
+  images[index] = (image != NULL) ? g_bytes_ref (image) : NULL;
+  received++;
+  g_cond_signal (&cond);
+  g_mutex_unlock (&mutex);
+}
+
+/* Generates the thumbnails of @uri and waits for all of them.  */
+
+static void
+generate (const gchar *uri)
+{
+  guint i;
+
+  g_mutex_lock (&mutex);
+  received = 0;
+  for (i = 0; i < N; i++)
+    {
+      if (images[i] != NULL)
+        g_bytes_unref (images[i]);
+      images[i] = NULL;
+    }
+  g_mutex_unlock (&mutex);
+
+  g_assert (lp_media_generate_thumbnails (uri, N, WIDTH, HEIGHT,
+                                          collect, NULL));
+
+  g_mutex_lock (&mutex);
+  while (received < N)
+    g_cond_wait (&cond, &mutex);
+  g_mutex_unlock (&mutex);
+}
+
+int
+main (void)
+{
+  guint i;
+
+  /* Video: key frames are sparse, so times may repeat.  */
+  generate (SAMPLE_CLOCK);
+  for (i = 0; i < N; i++)
+    {
+      g_assert_nonnull (images[i]);
+      g_assert (g_bytes_get_size (images[i]) == WIDTH * HEIGHT * 4);
+      if (i > 0)
+        g_assert (times[i] >= times[i - 1]);
+    }
+
+  generate (SAMPLE_ROAD);
+  for (i = 0; i < N; i++)
+    g_assert_nonnull (images[i]);
+
+  /* Still image: N copies.  */
+  generate (SAMPLE_GNU);
+  for (i = 0; i < N; i++)
+    {
+      g_assert_nonnull (images[i]);
+      g_assert (g_bytes_equal (images[i], images[0]));
+    }
+
+  /* Audio only: no images.  */
+  generate (SAMPLE_ARCADE);
+  for (i = 0; i < N; i++)
+    g_assert_null (images[i]);
+
+  for (i = 0; i < N; i++)
+    if (images[i] != NULL)
+      g_bytes_unref (images[i]);
+
+  exit (EXIT_SUCCESS);
+}
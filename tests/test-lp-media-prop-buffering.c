@@ -0,0 +1,103 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+
+  guint bytes = 1;
+  guint buffers = 1;
+  guint64 time = 1;
+  gint buffering = 0;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_LEGO);
+  g_assert_nonnull (media);
+
+  /* Defaults.  */
+  g_object_get (media,
+                "demux-max-bytes", &bytes,
+                "demux-max-buffers", &buffers,
+                "demux-max-time", &time, NULL);
+  g_assert (bytes == 0);
+  g_assert (buffers == 0);
+  g_assert (time == 0);
+
+  g_object_get (media,
+                "decode-max-bytes", &bytes,
+                "decode-max-buffers", &buffers,
+                "decode-max-time", &time,
+                "buffering", &buffering, NULL);
+  g_assert (bytes == 0);
+  g_assert (buffers == 0);
+  g_assert (time == 0);
+  g_assert (buffering == 100);
+
+  g_object_get (media,
+                "decode-level-bytes", &bytes,
+                "decode-level-buffers", &buffers,
+                "decode-level-time", &time, NULL);
+  g_assert (bytes == 0);
+  g_assert (buffers == 0);
+  g_assert (time == 0);
+
+  /* Limits.  */
+  g_object_set (media,
+                "demux-max-bytes", 1024 * 1024,
+                "demux-max-time", (guint64)(2 * GST_SECOND),
+                "decode-max-buffers", 3, NULL);
+
+  g_object_get (media,
+                "demux-max-bytes", &bytes,
+                "demux-max-time", &time,
+                "decode-max-buffers", &buffers, NULL);
+  g_assert (bytes == 1024 * 1024);
+  g_assert (time == 2 * GST_SECOND);
+  g_assert (buffers == 3);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Decode queues never hold more than the configured buffers.  */
+  g_object_get (media, "decode-level-buffers", &buffers, NULL);
+  g_assert (buffers <= 2 * 3);
+
+  /* Limits can be changed while media is playing.  */
+  g_object_set (media, "decode-max-buffers", 1, NULL);
+  g_object_get (media,
+                "decode-level-buffers", &buffers,
+                "buffering", &buffering, NULL);
+  g_assert (buffers <= 2 * 3);
+  g_assert (buffering >= 0 && buffering <= 100);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,72 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  gboolean drained;
+
+  gboolean loop = TRUE;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+
+  g_object_get (media, "loop", &loop, NULL);
+  g_assert (loop == FALSE);     /* default */
+
+  g_object_set (media, "loop", TRUE, NULL);
+  g_object_get (media, "loop", &loop, NULL);
+  g_assert (loop == TRUE);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Loop mode is set by the first segment, so media can be sought right
+     away.  Jump close to the end; media should wrap around instead of
+     stopping.  */
+  g_assert (lp_media_seek (media, FALSE, -GST_SECOND));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_SEEK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  event = await_filtered (scene, 3, LP_EVENT_MASK_TICK
+                          | LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_assert (LP_IS_EVENT_TICK (event));
+  g_object_unref (event);
+
+  /* Disabling loop mode needs no seek and lets media drain as usual.  */
+  g_object_set (media, "loop", FALSE, NULL);
+  g_assert (lp_media_seek (media, FALSE, -GST_SECOND));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_get (event, "eos", &drained, NULL);
+  g_assert (drained);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,120 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+/* Plays @first, which is followed by @second, from near its end.  Checks
+   that @first drains, although @second is prerolled in standby, and that
+   @second then starts and plays.  */
+
+static void
+play_in_sequence (lp_Scene *scene, lp_Media *first, lp_Media *second)
+{
+  lp_Event *event;
+  gboolean started = FALSE;
+  gboolean stopped = FALSE;
+  gint64 time;
+
+  g_assert (lp_media_start (first));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_assert (lp_event_get_source (event) == G_OBJECT (first));
+  g_object_unref (event);
+
+  /* The second media is prerolled in standby; it starts only when the
+     first one ends.  */
+  await_ticks (scene, 1);
+  g_assert (lp_media_seek (first, FALSE, -GST_SECOND));
+
+  while (!started || !stopped)
+    {
+      event = await_filtered (scene, 1, LP_EVENT_MASK_START
+                              | LP_EVENT_MASK_STOP);
+      g_assert_nonnull (event);
+      if (LP_IS_EVENT_START (event))
+        {
+          g_assert (lp_event_get_source (event) == G_OBJECT (second));
+          started = TRUE;
+        }
+      else
+        {
+          gboolean eos;
+
+          g_assert (lp_event_get_source (event) == G_OBJECT (first));
+          g_object_get (event, "eos", &eos, NULL);
+          g_assert (eos);
+          stopped = TRUE;
+        }
+      g_object_unref (event);
+    }
+
+  time = lp_media_get_running_time (second);
+  await_ticks (scene, 3);
+  g_assert (lp_media_get_running_time (second) > time);
+
+  g_assert (lp_media_stop (second));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *first;
+  lp_Media *second;
+
+  lp_Media *next = NULL;
+
+  scene = SCENE_NEW (800, 600, 0);
+  first = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (first);
+  second = lp_media_new (scene, SAMPLE_LEGO);
+  g_assert_nonnull (second);
+
+  g_object_get (first, "next", &next, NULL);
+  g_assert_null (next);         /* default */
+
+  g_object_set (first, "next", first, NULL); /* ignored */
+  g_object_get (first, "next", &next, NULL);
+  g_assert_null (next);
+
+  g_object_set (first, "next", second, NULL);
+  g_object_get (first, "next", &next, NULL);
+  g_assert (next == second);
+  g_object_unref (next);
+
+  g_object_set (second, "next", first, NULL); /* cycle, ignored */
+  g_object_get (second, "next", &next, NULL);
+  g_assert_null (next);
+
+  /* Video media.  */
+  play_in_sequence (scene, first, second);
+
+  /* Audio media, which go through the audio mixer only.  */
+  first = lp_media_new (scene, SAMPLE_COZY);
+  g_assert_nonnull (first);
+  second = lp_media_new (scene, SAMPLE_ARCADE);
+  g_assert_nonnull (second);
+  g_object_set (first, "next", second, NULL);
+  play_in_sequence (scene, first, second);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,77 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+
+  guint64 processed = 1;
+  guint64 dropped = 1;
+  guint64 late = 1;
+  guint64 lateness = 1;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+
+  g_object_get (media,
+                "frames-processed", &processed,
+                "frames-dropped", &dropped,
+                "frames-late", &late,
+                "average-lateness", &lateness, NULL);
+  g_assert (processed == 0);
+  g_assert (dropped == 0);
+  g_assert (late == 0);
+  g_assert (lateness == 0);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  event = await_filtered (scene, 2, LP_EVENT_MASK_TICK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_get (media,
+                "frames-processed", &processed,
+                "frames-dropped", &dropped,
+                "frames-late", &late,
+                "average-lateness", &lateness, NULL);
+  g_assert (processed > 0);
+  g_assert (late <= processed);
+  g_assert (late > 0 || lateness == 0);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Counters restart with each run.  */
+  g_object_get (media, "frames-processed", &processed, NULL);
+  g_assert (processed == 0);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,122 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+/* Asserts that the stream position of @media advances at about @rate
+   times the running time of @scene.  */
+
+static void
+assert_rate (lp_Scene *scene, lp_Media *media, gdouble rate)
+{
+  GstClockTime t0, t1;
+  gint64 p0, p1;
+  gdouble r;
+
+  t0 = _lp_scene_get_running_time (scene);
+  p0 = lp_media_get_running_time (media);
+  await_ticks (scene, 1);
+  t1 = _lp_scene_get_running_time (scene);
+  p1 = lp_media_get_running_time (media);
+
+  g_assert (p0 >= 0);
+  g_assert (p1 >= 0);
+  g_assert (t1 > t0);
+
+  r = (gdouble)(p1 - p0) / (gdouble)(t1 - t0);
+  g_assert_cmpfloat (r, >, rate * .8);
+  g_assert_cmpfloat (r, <, rate * 1.2);
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  gdouble v[] = {.5, 4.0, 1.0};
+  gsize i;
+
+  gdouble rate = G_MAXDOUBLE;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_NIGHT);
+  g_assert_nonnull (media);
+
+  g_object_set (media, "text", "2x", "text-font", "sans 40", NULL);
+  g_object_get (media, "rate", &rate, NULL);
+  g_assert (rate == 1.0);       /* default */
+
+  /* A rate set before start applies to the first segment: no seek
+     follows the start, so the media can be sought right away.  */
+  g_object_set (media, "rate", 2.0, NULL);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START
+                          | LP_EVENT_MASK_SEEK);
+  g_assert_nonnull (event);
+  g_assert (LP_IS_EVENT_START (event));
+  g_object_unref (event);
+  assert_rate (scene, media, 2.0);
+
+  g_assert (lp_media_seek (media, TRUE, 0));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_SEEK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  assert_rate (scene, media, 2.0);
+
+  /* Rate changes are applied via an internal seek to the current
+     position, which is not reported.  */
+  for (i = 0; i < nelementsof (v); i++)
+    {
+      gchar *text = g_strdup_printf ("%gx", v[i]);
+      g_object_set (media, "text", text, "rate", v[i], NULL);
+      g_free (text);
+
+      g_object_get (media, "rate", &rate, NULL);
+      g_assert (rate == v[i]);
+
+      event = await_filtered (scene, 1, LP_EVENT_MASK_TICK
+                              | LP_EVENT_MASK_SEEK);
+      g_assert_nonnull (event);
+      g_assert (LP_IS_EVENT_TICK (event));
+      g_object_unref (event);
+      assert_rate (scene, media, v[i]);
+    }
+
+  /* Rate changes made while paused are applied on resume.  */
+  g_assert (lp_media_pause (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_PAUSE);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_set (media, "text", "2x", "rate", 2.0, NULL);
+  g_assert (lp_media_resume (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  event = await_filtered (scene, 1, LP_EVENT_MASK_TICK
+                          | LP_EVENT_MASK_SEEK);
+  g_assert_nonnull (event);
+  g_assert (LP_IS_EVENT_TICK (event));
+  g_object_unref (event);
+  assert_rate (scene, media, 2.0);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
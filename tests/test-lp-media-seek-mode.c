@@ -0,0 +1,99 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+/* Seeks in @media using @mode and checks the resulting seek events.  */
+
+static void
+check_seek (lp_Scene *scene, lp_Media *media, lp_SeekMode mode,
+            gint64 offset)
+{
+  lp_Event *event;
+  lp_SeekMode expected[2];
+  gsize n;
+  gsize i;
+
+  switch (mode)
+    {
+    case LP_SEEK_MODE_REFINE:
+      expected[0] = LP_SEEK_MODE_KEYFRAME;
+      expected[1] = LP_SEEK_MODE_ACCURATE;
+      n = 2;
+      break;
+    default:
+      expected[0] = mode;
+      n = 1;
+    }
+
+  g_object_set (media, "seek-mode", mode, NULL);
+  g_assert (lp_media_seek (media, FALSE, offset));
+
+  for (i = 0; i < n; i++)
+    {
+      lp_SeekMode got = LP_SEEK_MODE_LAST;
+      guint64 latency = 0;
+      gboolean relative = TRUE;
+      gint64 last = G_MAXINT64;
+
+      event = await_filtered (scene, 1, LP_EVENT_MASK_SEEK);
+      g_assert_nonnull (event);
+      g_object_get (event,
+                    "relative", &relative,
+                    "offset", &last,
+                    "mode", &got,
+                    "latency", &latency, NULL);
+      g_assert (relative == FALSE);
+      g_assert (last == offset);
+      g_assert (got == expected[i]);
+      g_assert (latency > 0);
+      g_object_unref (event);
+    }
+
+  await_ticks (scene, 1);
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+
+  lp_SeekMode mode = LP_SEEK_MODE_LAST;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_NIGHT);
+  g_assert_nonnull (media);
+
+  g_object_get (media, "seek-mode", &mode, NULL);
+  g_assert (mode == LP_SEEK_MODE_ACCURATE); /* default */
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  await_ticks (scene, 1);
+
+  check_seek (scene, media, LP_SEEK_MODE_ACCURATE, 3 * GST_SECOND);
+  check_seek (scene, media, LP_SEEK_MODE_KEYFRAME, 1 * GST_SECOND);
+  check_seek (scene, media, LP_SEEK_MODE_REFINE, 2 * GST_SECOND);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,104 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+/* Returns the number of elements created by factory @name in @scene.  */
+
+static guint
+count_elements (lp_Scene *scene, const gchar *name)
+{
+  GstElement *pipeline;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  guint n;
+
+  pipeline = _lp_scene_get_pipeline (scene);
+  g_assert_nonnull (pipeline);
+
+  n = 0;
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  g_assert_nonnull (it);
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK)
+    {
+      GstElementFactory *factory;
+
+      factory = gst_element_get_factory
+        (GST_ELEMENT (g_value_get_object (&item)));
+      if (factory != NULL
+          && g_str_equal (gst_plugin_feature_get_name (factory), name))
+        n++;
+      g_value_reset (&item);
+    }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return n;
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  guint text;
+
+  scene = SCENE_NEW (800, 600, 0);
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* A plain video has neither crop nor text overlay; the scene has its
+     own text overlay.  */
+  text = count_elements (scene, "textoverlay");
+  g_assert (count_elements (scene, "videocrop") == 0);
+
+  g_object_set (media, "text", "abc", "crop-top", .25, NULL);
+  await_ticks (scene, 1);
+  g_assert (count_elements (scene, "textoverlay") == text + 1);
+  g_assert (count_elements (scene, "videocrop") == 1);
+
+  g_object_set (media, "text", NULL, "crop-top", 0., NULL);
+  await_ticks (scene, 1);
+  g_assert (count_elements (scene, "textoverlay") == text);
+  g_assert (count_elements (scene, "videocrop") == 0);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Non-default properties set before start are applied at start.  */
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_object_set (media, "text", "abc", NULL);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  g_assert (count_elements (scene, "textoverlay") == text + 1);
+  g_assert (count_elements (scene, "videocrop") == 0);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
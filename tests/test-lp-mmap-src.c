@@ -0,0 +1,74 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  GstElement *src;
+  gchar *uri;
+  gchar *str;
+
+  scene = SCENE_NEW (800, 600, 0);
+
+  /* File URIs are still handled by filesrc.  */
+  uri = gst_filename_to_uri (SAMPLE_CLOCK, NULL);
+  g_assert_nonnull (uri);
+  src = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, NULL);
+  g_assert_nonnull (src);
+  g_assert (!LP_IS_MMAP_SRC (src));
+  gst_object_unref (src);
+
+  /* The private URIs given to uridecodebin by LibPlay media are handled
+     by the memory-mapped source.  */
+  str = _lp_mmap_src_get_uri (uri);
+  g_assert_nonnull (str);
+  g_assert_cmpstr (str, !=, uri);
+  src = gst_element_make_from_uri (GST_URI_SRC, str, NULL, NULL);
+  g_assert_nonnull (src);
+  g_assert (LP_IS_MMAP_SRC (src));
+  gst_object_unref (src);
+  g_free (str);
+  g_free (uri);
+
+  /* Media read through it play as usual.  */
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_assert (lp_media_seek (media, TRUE, GST_SECOND));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_SEEK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
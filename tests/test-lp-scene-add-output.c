@@ -0,0 +1,146 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+/* Returns true if element @name of @scene pipeline has received data.  */
+
+static gboolean
+output_has_data (lp_Scene *scene, const gchar *name)
+{
+  GstElement *pipeline;
+  GstElement *sink;
+  GstSample *sample = NULL;
+
+  pipeline = _lp_scene_get_pipeline (scene);
+  g_assert_nonnull (pipeline);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), name);
+  if (sink == NULL)
+    return FALSE;
+
+  g_object_get (sink, "last-sample", &sample, NULL);
+  gst_object_unref (sink);
+  if (sample == NULL)
+    return FALSE;
+
+  gst_sample_unref (sample);
+  return TRUE;
+}
+
+/* Returns true if @scene pipeline has an element named @name.  */
+
+static gboolean
+output_exists (lp_Scene *scene, const gchar *name)
+{
+  GstElement *sink;
+
+  sink = gst_bin_get_by_name (GST_BIN (_lp_scene_get_pipeline (scene)),
+                              name);
+  if (sink == NULL)
+    return FALSE;
+
+  gst_object_unref (sink);
+  return TRUE;
+}
+
+/* Records in @eos that an EOS event has crossed @pad.  */
+
+static GstPadProbeReturn
+eos_probe_callback (arg_unused (GstPad *pad), GstPadProbeInfo *info,
+                    gint *eos)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS)
+    g_atomic_int_set (eos, 1);
+  return GST_PAD_PROBE_OK;
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  guint early;
+  guint video;
+  guint audio;
+  GstElement *sink;
+  GstPad *pad;
+  gint eos = 0;
+  gint i;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 160,
+                                  "height", 120,
+                                  "headless", TRUE,
+                                  NULL));
+  g_assert_nonnull (scene);
+
+  /* Attached before any media starts.  */
+  early = lp_scene_add_output (scene, LP_OUTPUT_VIDEO,
+                               "fakesink name=early sync=false");
+  g_assert (early > 0);
+  g_assert (lp_scene_remove_output (scene, early));
+  g_assert (!lp_scene_remove_output (scene, early));
+  early = lp_scene_add_output (scene, LP_OUTPUT_VIDEO,
+                               "fakesink name=early sync=false");
+  g_assert (early > 0);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Attached while running.  */
+  video = lp_scene_add_output (scene, LP_OUTPUT_VIDEO,
+                               "fakesink name=video sync=false");
+  g_assert (video > 0);
+  g_assert (video != early);
+  audio = lp_scene_add_output (scene, LP_OUTPUT_AUDIO,
+                               "fakesink name=audio sync=false");
+  g_assert (audio > 0);
+
+  await_ticks (scene, 2);
+  g_assert (output_has_data (scene, "early"));
+  g_assert (output_has_data (scene, "video"));
+  g_assert (output_has_data (scene, "audio"));
+
+  /* Detached while running; the output is drained with EOS and the
+     others keep flowing.  */
+  sink = gst_bin_get_by_name (GST_BIN (_lp_scene_get_pipeline (scene)),
+                              "video");
+  g_assert_nonnull (sink);
+  pad = gst_element_get_static_pad (sink, "sink");
+  g_assert_nonnull (pad);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                     (GstPadProbeCallback) eos_probe_callback, &eos, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  g_assert (lp_scene_remove_output (scene, video));
+  for (i = 0; i < 20 && output_exists (scene, "video"); i++)
+    await_ticks (scene, 1);
+  g_assert (!output_exists (scene, "video"));
+  g_assert (g_atomic_int_get (&eos));
+  g_assert (output_exists (scene, "early"));
+  g_assert (output_exists (scene, "audio"));
+
+  g_object_unref (scene);
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+/* Creates a headless scene that shares the clock of @clock_scene.  */
+
+static lp_Scene *
+group_scene_new (lp_Scene *clock_scene)
+{
+  lp_Scene *scene;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 160,
+                                  "height", 120,
+                                  "headless", TRUE,
+                                  "clock-scene", clock_scene,
+                                  NULL));
+  g_assert_nonnull (scene);
+  return scene;
+}
+
+int
+main (void)
+{
+  lp_Scene *scenes[3];
+  lp_Scene *other;
+  guint64 time[3];
+  guint64 last;
+  gint i, j;
+
+  scenes[0] = group_scene_new (NULL);
+  scenes[1] = group_scene_new (scenes[0]);
+  scenes[2] = group_scene_new (scenes[0]);
+  other = group_scene_new (NULL);
+
+  for (i = 0; i < 3; i++)
+    await_ticks (scenes[i], 1);
+  await_ticks (other, 1);
+
+  g_assert (!lp_scene_advance_group (scenes, 3, GST_SECOND));
+  g_assert (!lp_scene_advance_group (scenes, 0, GST_SECOND));
+
+  for (i = 0; i < 3; i++)
+    g_object_set (scenes[i], "lockstep", TRUE, NULL);
+  g_object_set (other, "lockstep", TRUE, NULL);
+
+  /* All scenes run on the same time base.  */
+  for (i = 0; i < 3; i++)
+    g_object_get (scenes[i], "time", &time[i], NULL);
+  g_assert (time[0] == time[1]);
+  g_assert (time[0] == time[2]);
+  last = time[0];
+
+  for (j = 0; j < 30; j++)
+    {
+      g_assert (lp_scene_advance_group (scenes, 3, GST_SECOND / 30));
+      for (i = 0; i < 3; i++)
+        {
+          g_object_get (scenes[i], "time", &time[i], NULL);
+          g_assert (time[i] - last == GST_SECOND / 30);
+        }
+      last = time[0];
+    }
+
+  /* The lock-step mode of the shared clock is changed only through the
+     scene that owns it.  */
+  {
+    gboolean lockstep = FALSE;
+
+    g_object_set (scenes[1], "lockstep", FALSE, NULL);
+    g_object_get (scenes[1], "lockstep", &lockstep, NULL);
+    g_assert (lockstep);
+    g_assert (lp_scene_advance_group (scenes, 3, GST_SECOND / 30));
+    for (i = 0; i < 3; i++)
+      g_object_get (scenes[i], "time", &time[i], NULL);
+    g_assert (time[0] - last == GST_SECOND / 30);
+    g_assert (time[0] == time[1]);
+    g_assert (time[0] == time[2]);
+  }
+
+  /* A scene with its own clock cannot join the group.  */
+  {
+    lp_Scene *mixed[2];
+
+    mixed[0] = scenes[0];
+    mixed[1] = other;
+    g_assert (!lp_scene_advance_group (mixed, 2, GST_SECOND));
+    g_assert (lp_scene_advance_group (&other, 1, GST_SECOND));
+  }
+
+  g_object_unref (other);
+  for (i = 2; i >= 0; i--)
+    g_object_unref (scenes[i]);
+
+  exit (EXIT_SUCCESS);
+}
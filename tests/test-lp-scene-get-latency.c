@@ -0,0 +1,64 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  lp_Latency latency;
+
+  guint64 budget = 1;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene, "latency", &budget, NULL);
+  g_assert (budget == 0);       /* default */
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_assert (lp_scene_get_latency (scene, &latency));
+  g_assert (latency.total >= latency.mixer);
+  g_assert (latency.total >= latency.sink);
+
+  /* Requested budget overrides the computed latency.  */
+  g_object_set (scene, "latency", (guint64)(100 * GST_MSECOND), NULL);
+  g_object_get (scene, "latency", &budget, NULL);
+  g_assert (budget == 100 * GST_MSECOND);
+  g_assert (lp_scene_get_latency (scene, &latency));
+  g_assert (latency.total == 100 * GST_MSECOND);
+
+  g_object_set (scene, "latency", (guint64) 0, NULL);
+  g_assert (lp_scene_get_latency (scene, &latency));
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,71 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  lp_SceneStats stats;
+
+  scene = SCENE_NEW (800, 600, 0);
+  lp_scene_get_stats (scene, &stats);
+  g_assert (stats.events_received == 0);
+  g_assert (stats.media_stopped == 0);
+  g_assert (stats.media_started == 0);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  lp_scene_get_stats (scene, &stats);
+  g_assert (stats.media_stopped == 1);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  event = await_filtered (scene, 2, LP_EVENT_MASK_TICK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  lp_scene_get_stats (scene, &stats);
+  g_assert (stats.media_stopped == 0);
+  g_assert (stats.media_started == 1);
+  g_assert (stats.frames_composed > 0);
+  g_assert (stats.events_dispatched >= stats.events_received);
+  g_assert (stats.events_received > 0);
+  g_assert (stats.events_pending_max > 0);
+  g_assert (stats.lock_time == 0 || stats.lock_contended > 0);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  lp_scene_get_stats (scene, &stats);
+  g_assert (stats.media_stopped == 1);
+  g_assert (stats.media_started == 0);
+  g_assert (stats.media_busy == 0);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
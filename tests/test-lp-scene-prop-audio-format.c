@@ -0,0 +1,133 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  gchar *format = NULL;
+  gint rate = -1;
+  gint channels = -1;
+  gint quality = -1;
+  GstClockTime t0, t1;
+  gint64 p0, p1;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene,
+                "audio-rate", &rate,
+                "audio-channels", &channels,
+                "audio-format", &format,
+                "resample-quality", &quality,
+                NULL);
+  g_assert (rate == 0);         /* default */
+  g_assert (channels == 0);     /* default */
+  g_assert_null (format);       /* default */
+  g_assert (quality == 4);      /* default */
+
+  g_object_set (scene, "resample-quality", 0, NULL);
+  g_object_get (scene, "resample-quality", &quality, NULL);
+  g_assert (quality == 0);
+  g_object_unref (scene);
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 800,
+                                  "height", 600,
+                                  "audio-rate", 8000,
+                                  "audio-channels", 1,
+                                  "audio-format", "S16LE",
+                                  "resample-quality", 2,
+                                  NULL));
+  g_assert_nonnull (scene);
+  g_object_get (scene,
+                "audio-rate", &rate,
+                "audio-channels", &channels,
+                "audio-format", &format,
+                NULL);
+  g_assert (rate == 8000);
+  g_assert (channels == 1);
+  g_assert_cmpstr (format, ==, "S16LE");
+  g_free (format);
+
+  /* Invalid formats are ignored.  */
+  g_object_set (scene, "audio-format", "XYZ", NULL);
+  g_object_get (scene, "audio-format", &format, NULL);
+  g_assert_cmpstr (format, ==, "S16LE");
+  g_free (format);
+
+  /* Decoded audio does not match the pinned format, so it is
+     converted.  */
+  media = lp_media_new (scene, SAMPLE_COZY);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  await_ticks (scene, 2);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  /* Decoded audio matches the pinned format, so conversion is bypassed
+     until a rate change inserts the audio tempo.  */
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 800,
+                                  "height", 600,
+                                  "audio-rate", 48000,
+                                  "audio-channels", 2,
+                                  "audio-format", "F32LE",
+                                  NULL));
+  g_assert_nonnull (scene);
+
+  media = lp_media_new (scene, SAMPLE_COZY);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  await_ticks (scene, 2);
+
+  g_object_set (media, "rate", 2.0, NULL);
+  await_ticks (scene, 2);
+  t0 = _lp_scene_get_running_time (scene);
+  p0 = lp_media_get_running_time (media);
+  await_ticks (scene, 1);
+  t1 = _lp_scene_get_running_time (scene);
+  p1 = lp_media_get_running_time (media);
+  g_assert (t1 > t0);
+  g_assert (p1 - p0 > (gint64)(t1 - t0) * 3 / 2);
+
+  g_object_set (media, "rate", 1.0, "volume", .5, NULL);
+  await_ticks (scene, 2);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP
+                          | LP_EVENT_MASK_ERROR);
+  g_assert_nonnull (event);
+  g_assert (LP_IS_EVENT_STOP (event));
+  g_object_unref (event);
+
+  g_object_unref (scene);
+  exit (EXIT_SUCCESS);
+}
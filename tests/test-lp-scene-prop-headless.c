@@ -0,0 +1,59 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  GstElement *sink;
+  gboolean headless = TRUE;
+
+  scene = SCENE_NEW (800, 600, 2);
+  g_object_get (scene, "headless", &headless, NULL);
+  g_assert (!headless);         /* default */
+  g_object_unref (scene);
+
+  headless = FALSE;
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 800,
+                                  "height", 600,
+                                  "headless", TRUE,
+                                  NULL));
+  g_assert_nonnull (scene);
+  g_object_get (scene, "headless", &headless, NULL);
+  g_assert (headless);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+  await_ticks (scene, 2);
+
+  sink = _lp_scene_get_real_video_sink (scene);
+  g_assert_nonnull (sink);
+  g_assert_cmpstr (G_OBJECT_TYPE_NAME (sink), ==, "GstFakeSink");
+  gst_object_unref (sink);
+
+  g_object_unref (scene);
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,91 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+#define N 8
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media[N];
+  lp_Event *event;
+  guint64 budget = 0;
+  guint64 size = G_MAXUINT64;
+  guint64 last;
+  gsize i;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene,
+                "image-cache-budget", &budget,
+                "image-cache-size", &size, NULL);
+  g_assert (budget > 0);
+  g_assert (size == 0);
+
+  /* First start decodes the image and fills the cache.  */
+  media[0] = lp_media_new (scene, SAMPLE_PNG);
+  g_assert_nonnull (media[0]);
+  g_object_set (media[0], "width", 200, "height", 150, NULL);
+  g_assert (lp_media_start (media[0]));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert (LP_IS_EVENT_START (event));
+  g_object_unref (event);
+  await_ticks (scene, 1);
+
+  g_object_get (scene, "image-cache-size", &size, NULL);
+  g_assert (size > 0);
+  last = size;
+
+  /* Next starts of the same image hit the cache, whatever their size.  */
+  for (i = 1; i < N; i++)
+    {
+      media[i] = lp_media_new (scene, SAMPLE_PNG);
+      g_assert_nonnull (media[i]);
+      g_object_set (media[i],
+                    "x", (gint) (i % 4) * 200,
+                    "y", (gint) (i / 4) * 150,
+                    "width", (i % 2) ? 100 : 200,
+                    "height", (i % 2) ? 75 : 150, NULL);
+      g_assert (lp_media_start (media[i]));
+      event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+      g_assert (LP_IS_EVENT_START (event));
+      g_object_unref (event);
+    }
+
+  await_ticks (scene, 2);
+  g_object_get (scene, "image-cache-size", &size, NULL);
+  g_assert (size == last);
+
+  /* Zero budget empties and disables the cache.  */
+  g_object_set (scene, "image-cache-budget", (guint64) 0, NULL);
+  g_object_get (scene, "image-cache-size", &size, NULL);
+  g_assert (size == 0);
+
+  for (i = 0; i < N; i++)
+    {
+      g_assert (lp_media_stop (media[i]));
+      event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+      g_assert (LP_IS_EVENT_STOP (event));
+      g_object_unref (event);
+    }
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,109 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+static lp_Scene *scene;
+static gint done = 0;
+
+/* Reads published scene and media properties until told to stop.  */
+
+static gpointer
+reader (gpointer data)
+{
+  lp_Media *media;
+  guint64 last_ticks = 0;
+  guint64 last_time = 0;
+  guint n = 0;
+
+  media = LP_MEDIA (data);
+
+  while (!g_atomic_int_get (&done))
+    {
+      guint64 ticks;
+      guint64 time;
+      gint width;
+      gint height;
+      gint x;
+
+      g_object_get (scene, "ticks", &ticks, "time", &time,
+                    "width", &width, "height", &height, NULL);
+      g_assert (ticks >= last_ticks);
+      g_assert (time >= last_time);
+      g_assert (width == 800);
+      g_assert (height == 600);
+      last_ticks = ticks;
+      last_time = time;
+
+      g_object_get (media, "x", &x, "width", &width, NULL);
+      g_assert (x % 10 == 0);
+      g_assert (width == 100);
+      n++;
+    }
+
+  return GUINT_TO_POINTER (n);
+}
+
+int
+main (void)
+{
+  lp_Media *media;
+  lp_Event *event;
+  lp_SceneStats stats;
+  GThread *thread;
+  gint i;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_set (scene, "interval", GST_SECOND / 10, NULL);
+
+  media = lp_media_new (scene, SAMPLE_GNU);
+  g_assert_nonnull (media);
+  g_object_set (media, "width", 100, "height", 100, NULL);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  thread = g_thread_new ("reader", reader, media);
+  g_assert_nonnull (thread);
+
+  for (i = 0; i < 10; i++)
+    {
+      g_object_set (media, "x", i * 10, NULL);
+      event = await_filtered (scene, 1, LP_EVENT_MASK_TICK);
+      g_assert_nonnull (event);
+      g_object_unref (event);
+    }
+
+  g_atomic_int_set (&done, 1);
+  g_assert (GPOINTER_TO_UINT (g_thread_join (thread)) > 0);
+
+  lp_scene_get_stats (scene, &stats);
+  g_assert (stats.lock_time == 0 || stats.lock_contended > 0);
+  g_assert (stats.events_received >= 10);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,132 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+/* Maximum tolerated difference between scene times.  */
+#define FRAME  (GST_SECOND / 30)
+
+/* Creates a headless scene that publishes (if @follow is false) or
+   follows (otherwise) the network clock at @address:@port.  */
+
+static lp_Scene *
+net_scene_new (const gchar *address, gint port, gboolean follow)
+{
+  lp_Scene *scene;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 160,
+                                  "height", 120,
+                                  "headless", TRUE,
+                                  "interval", GST_SECOND / 10,
+                                  follow ? "net-clock-follow"
+                                  : "net-clock-publish", address,
+                                  "net-clock-port", port,
+                                  NULL));
+  g_assert_nonnull (scene);
+  await_ticks (scene, 1);       /* started */
+  return scene;
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Scene *follower;
+  gchar *address = (gchar *) "";
+  gint port = -1;
+  gint i;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene, "net-clock-publish", &address,
+                "net-clock-port", &port, NULL);
+  g_assert_null (address);      /* default */
+  g_assert (port == 0);         /* default */
+  g_object_get (scene, "net-clock-follow", &address, NULL);
+  g_assert_null (address);      /* default */
+  g_object_unref (scene);
+
+  /* Publish on an ephemeral loopback port.  */
+  scene = net_scene_new ("127.0.0.1", 0, FALSE);
+  g_object_get (scene, "net-clock-publish", &address,
+                "net-clock-port", &port, NULL);
+  g_assert_cmpstr (address, ==, "127.0.0.1");
+  g_assert (port > 0);
+  g_free (address);
+
+  /* Start the follower a while later, so that a local clock would
+     disagree.  */
+  g_usleep (500000);
+  follower = net_scene_new ("127.0.0.1", port, TRUE);
+
+  /* The follower does not wait for its clock to synchronize.  */
+  for (i = 0; i < 50; i++)
+    {
+      GstClockTime t0, t;
+
+      t0 = _lp_scene_get_running_time (scene);
+      t = _lp_scene_get_running_time (follower);
+      if (t + FRAME >= t0 && t <= t0 + FRAME)
+        break;
+      g_usleep (100000);
+    }
+
+  for (i = 0; i < 50; i++)
+    {
+      GstClockTime t0, t1, t;
+
+      t0 = _lp_scene_get_running_time (scene);
+      t = _lp_scene_get_running_time (follower);
+      t1 = _lp_scene_get_running_time (scene);
+      g_assert (GST_CLOCK_TIME_IS_VALID (t));
+      g_assert (t1 >= t0);
+      g_assert (t + FRAME >= t0);
+      g_assert (t <= t1 + FRAME);
+      g_usleep (100000);
+    }
+
+  g_object_unref (follower);
+  g_object_unref (scene);
+
+  /* A clock that cannot be published is not reported as published.  */
+  scene = net_scene_new ("192.0.2.1", 0, FALSE);
+  g_object_get (scene, "net-clock-publish", &address, NULL);
+  g_assert_null (address);
+  g_object_unref (scene);
+
+  /* A scene that shares the clock of another scene cannot make it follow
+     a network clock.  */
+  scene = SCENE_NEW (800, 600, 0);
+  follower = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                     "width", 160,
+                                     "height", 120,
+                                     "headless", TRUE,
+                                     "clock-scene", scene,
+                                     "net-clock-follow", "127.0.0.1",
+                                     "net-clock-port", 5637,
+                                     NULL));
+  g_assert_nonnull (follower);
+  g_object_get (follower, "net-clock-follow", &address, NULL);
+  g_assert_null (address);
+  await_ticks (follower, 1);
+  await_ticks (scene, 1);
+  g_object_unref (follower);
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,144 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+#include <unistd.h>
+
+/* Starts a headless scene exporting to @name with @blocking policy.  */
+
+static lp_Scene *
+shm_scene_new (const gchar *name, gboolean blocking)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 160,
+                                  "height", 120,
+                                  "headless", TRUE,
+                                  "shm-export", name,
+                                  "shm-export-blocking", blocking,
+                                  NULL));
+  g_assert_nonnull (scene);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  return scene;
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_ShmReader *reader;
+  gchar *name;
+  gchar *export = (gchar *) "";
+  guint slots = 0;
+  gboolean blocking = TRUE;
+  gconstpointer data;
+  gint width, height, stride;
+  guint seq, last;
+  guint64 pts;
+  gint i;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene, "shm-export", &export,
+                "shm-export-slots", &slots,
+                "shm-export-blocking", &blocking, NULL);
+  g_assert_null (export);       /* default */
+  g_assert (slots == 4);        /* default */
+  g_assert (!blocking);         /* default */
+  g_object_unref (scene);
+
+  name = g_strdup_printf ("/libplay-test-%d", (gint) getpid ());
+  g_assert_null (lp_shm_reader_open (name));
+
+  /* Drop policy: frames are read in place, newest first.  */
+  scene = shm_scene_new (name, FALSE);
+  reader = lp_shm_reader_open (name);
+  g_assert_nonnull (reader);
+
+  lp_shm_reader_get_format (reader, &width, &height, &stride);
+  g_assert (width == 160);
+  g_assert (height == 120);
+  g_assert (stride == 160 * 4);
+
+  last = 0;
+  for (i = 0; i < 3; i++)
+    {
+      data = lp_shm_reader_acquire (reader, 5 * GST_SECOND, &seq, &pts);
+      g_assert_nonnull (data);
+      g_assert (seq > last);
+      g_assert (GST_CLOCK_TIME_IS_VALID (pts));
+      lp_shm_reader_release (reader);
+      last = seq;
+    }
+
+  /* An existing ring is never taken over.  */
+  g_assert_null (_lp_shm_writer_new (name, 4, 160, 120, FALSE));
+  g_assert_nonnull (lp_shm_reader_acquire (reader, 5 * GST_SECOND,
+                                           NULL, NULL));
+  lp_shm_reader_release (reader);
+
+  g_object_unref (scene);       /* closes the ring */
+  g_assert_null (lp_shm_reader_acquire (reader, GST_SECOND, NULL, NULL));
+  lp_shm_reader_close (reader);
+
+  /* Block policy: no frame is skipped.  */
+  scene = shm_scene_new (name, TRUE);
+  reader = lp_shm_reader_open (name);
+  g_assert_nonnull (reader);
+
+  data = lp_shm_reader_acquire (reader, 5 * GST_SECOND, &last, NULL);
+  g_assert_nonnull (data);
+  g_assert (lp_shm_reader_release (reader));
+  for (i = 0; i < 10; i++)
+    {
+      data = lp_shm_reader_acquire (reader, 5 * GST_SECOND, &seq, NULL);
+      g_assert_nonnull (data);
+      g_assert (seq == last + 1);
+      g_assert (lp_shm_reader_release (reader));
+      last = seq;
+    }
+
+  /* Block policy: a stalled reader does not stall the scene forever.  */
+  g_usleep (3 * G_USEC_PER_SEC);
+  data = lp_shm_reader_acquire (reader, 5 * GST_SECOND, &seq, NULL);
+  g_assert_nonnull (data);
+  g_assert (seq > last + 4);
+  lp_shm_reader_release (reader);
+  last = seq;
+  data = lp_shm_reader_acquire (reader, 5 * GST_SECOND, &seq, NULL);
+  g_assert_nonnull (data);
+  g_assert (seq > last);
+  lp_shm_reader_release (reader);
+
+  lp_shm_reader_close (reader);
+  g_object_unref (scene);
+  g_assert_null (lp_shm_reader_open (name));
+
+  g_free (name);
+  exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,210 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+/* Returns true if the video mixer of @scene takes a thread share.  */
+
+static gboolean
+mixer_has_threads (lp_Scene *scene)
+{
+  GstElement *mixer;
+  GParamSpec *pspec;
+
+  mixer = _lp_scene_get_video_mixer (scene);
+  g_assert_nonnull (mixer);
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (mixer),
+                                        "max-threads");
+  return pspec != NULL && pspec->value_type == G_TYPE_UINT;
+}
+
+/* Returns the thread share that @scene with @budget threads and @nvideo
+   video media gives to a media with @area out of a total @total.  */
+
+static guint
+expected_share (lp_Scene *scene, guint budget, guint nvideo,
+                guint64 area, guint64 total)
+{
+  if (mixer_has_threads (scene))
+    {
+      guint share = MAX (budget / (nvideo + 1), 1);
+      budget = budget > share ? budget - share : 1;
+    }
+  return (guint) MAX ((budget * area) / total, 1);
+}
+
+/* Asserts that the decoders and the video converter of the media that
+   plays @path in @scene use a share of @threads threads.  Elements that
+   do not expose a thread count are skipped.  */
+
+static void
+assert_media_threads (lp_Scene *scene, const gchar *path, guint threads)
+{
+  GstElement *pipeline;
+  GstElement *bin = NULL;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gchar *name;
+
+  pipeline = _lp_scene_get_pipeline (scene);
+  g_assert_nonnull (pipeline);
+  name = g_path_get_basename (path);
+
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  g_assert_nonnull (it);
+  while (bin == NULL && gst_iterator_next (it, &item) == GST_ITERATOR_OK)
+    {
+      GstElement *elt;
+      GstElementFactory *factory;
+
+      elt = GST_ELEMENT (g_value_get_object (&item));
+      factory = gst_element_get_factory (elt);
+      if (factory != NULL
+          && g_str_equal (gst_plugin_feature_get_name (factory),
+                          "uridecodebin"))
+        {
+          gchar *uri;
+
+          g_object_get (elt, "uri", &uri, NULL);
+          if (uri != NULL && g_str_has_suffix (uri, name))
+            bin = GST_ELEMENT (gst_element_get_parent (elt));
+          g_free (uri);
+        }
+      g_value_reset (&item);
+    }
+  gst_iterator_free (it);
+  g_free (name);
+  g_assert_nonnull (bin);
+
+  it = gst_bin_iterate_recurse (GST_BIN (bin));
+  g_assert_nonnull (it);
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK)
+    {
+      GObject *elt;
+      GstElementFactory *factory;
+      GParamSpec *pspec;
+
+      elt = G_OBJECT (g_value_get_object (&item));
+      factory = gst_element_get_factory (GST_ELEMENT (elt));
+      if (factory != NULL
+          && g_str_equal (gst_plugin_feature_get_name (factory),
+                          "videoconvert"))
+        {
+          pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (elt),
+                                                "n-threads");
+          if (pspec != NULL && pspec->value_type == G_TYPE_UINT)
+            {
+              guint n;
+
+              g_object_get (elt, "n-threads", &n, NULL);
+              g_assert_cmpuint (n, ==, MAX (threads / 2, 1));
+            }
+        }
+      else
+        {
+          pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (elt),
+                                                "max-threads");
+          if (pspec != NULL && pspec->value_type == G_TYPE_INT)
+            {
+              gint n;
+
+              g_object_get (elt, "max-threads", &n, NULL);
+              g_assert_cmpint (n, ==, MAX (threads - threads / 2, 1));
+            }
+          else if (pspec != NULL && pspec->value_type == G_TYPE_UINT)
+            {
+              guint n;
+
+              g_object_get (elt, "max-threads", &n, NULL);
+              g_assert_cmpuint (n, ==, MAX (threads - threads / 2, 1));
+            }
+        }
+      g_value_reset (&item);
+    }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  gst_object_unref (bin);
+}
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *m1;
+  lp_Media *m2;
+  lp_Event *event;
+
+  guint budget = 1;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_object_get (scene, "thread-budget", &budget, NULL);
+  g_assert (budget == 0);       /* default */
+
+  g_object_set (scene, "thread-budget", 8, NULL);
+  g_object_get (scene, "thread-budget", &budget, NULL);
+  g_assert (budget == 8);
+
+  m1 = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (m1);
+  g_object_set (m1, "width", 600, "height", 400, NULL);
+
+  m2 = lp_media_new (scene, SAMPLE_LEGO);
+  g_assert_nonnull (m2);
+  g_object_set (m2, "width", 200, "height", 200, NULL);
+
+  g_assert (lp_media_start (m1));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_assert (lp_media_start (m2));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Shares are proportional to the displayed area.  */
+  assert_media_threads (scene, SAMPLE_CLOCK, expected_share
+                        (scene, 8, 2, 600 * 400, 600 * 400 + 200 * 200));
+  assert_media_threads (scene, SAMPLE_LEGO, expected_share
+                        (scene, 8, 2, 200 * 200, 600 * 400 + 200 * 200));
+
+  /* Resizing rebalances the shares.  */
+  g_object_set (m2, "width", 800, "height", 600, NULL);
+  assert_media_threads (scene, SAMPLE_CLOCK, expected_share
+                        (scene, 8, 2, 600 * 400, 600 * 400 + 800 * 600));
+  assert_media_threads (scene, SAMPLE_LEGO, expected_share
+                        (scene, 8, 2, 800 * 600, 600 * 400 + 800 * 600));
+
+  /* So does changing the budget.  */
+  g_object_set (scene, "thread-budget", 2, NULL);
+  assert_media_threads (scene, SAMPLE_CLOCK, 1);
+  assert_media_threads (scene, SAMPLE_LEGO, 1);
+
+  g_assert (lp_media_stop (m1));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_set (scene, "thread-budget", 0, NULL);
+  g_object_get (scene, "thread-budget", &budget, NULL);
+  g_assert (budget == 0);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}
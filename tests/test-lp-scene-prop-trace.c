@@ -0,0 +1,79 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "tests.h"
+#include <glib/gstdio.h>
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  gchar *path;
+  gchar *trace;
+  gchar *str;
+  gint fd;
+
+  fd = g_file_open_tmp ("lp-trace-XXXXXX.json", &path, NULL);
+  g_assert (fd >= 0);
+  g_assert (g_close (fd, NULL));
+
+  scene = LP_SCENE (g_object_new (LP_TYPE_SCENE,
+                                  "width", 800,
+                                  "height", 600,
+                                  "trace-file", path,
+                                  NULL));
+  g_assert_nonnull (scene);
+  g_object_get (scene, "trace-file", &str, NULL);
+  g_assert_cmpstr (str, ==, path);
+  g_free (str);
+
+  media = lp_media_new (scene, SAMPLE_CLOCK);
+  g_assert_nonnull (media);
+
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_assert (lp_media_stop (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_STOP);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  g_object_unref (scene);
+
+  g_assert (g_file_get_contents (path, &trace, NULL, NULL));
+  g_assert (g_str_has_prefix (trace, "["));
+  g_assert (g_str_has_suffix (trace, "]\n"));
+  g_assert_nonnull
+    (g_strrstr (trace, "\"name\":\"starting\",\"cat\":\"media\""));
+  g_assert_nonnull
+    (g_strrstr (trace, "\"name\":\"stopping\",\"cat\":\"media\""));
+  g_assert_nonnull
+    (g_strrstr (trace, "\"name\":\"starting\",\"cat\":\"scene\""));
+  g_assert_nonnull (g_strrstr (trace, "\"name\":\"pad-added\""));
+  g_assert_nonnull (g_strrstr (trace, "\"ph\":\"b\""));
+  g_assert_nonnull (g_strrstr (trace, "\"ph\":\"e\""));
+
+  g_free (trace);
+  g_assert (g_unlink (path) == 0);
+  g_free (path);
+
+  exit (EXIT_SUCCESS);
+}
@@ -36,6 +36,11 @@ main (void)
   await_ticks (scene, 1);
   g_object_get (scene, "wave", &wave, NULL);
   g_assert (wave == 0);
+
+  g_object_set (scene, "wave", 4, NULL); /* back to silence */
+  g_object_get (scene, "wave", &wave, NULL);
+  g_assert (wave == 4);
+  await_ticks (scene, 1);
   g_object_unref (scene);
 
   exit (EXIT_SUCCESS);
@@ -0,0 +1,69 @@
+/* Copyright (C) 2015-2018 PUC-Rio/Laboratorio TeleMidia
+
+This file is part of LibPlay.
+
+LibPlay is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+LibPlay is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public
+License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LibPlay.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include "tests.h"
+
+int
+main (void)
+{
+  lp_Scene *scene;
+  lp_Media *media;
+  lp_Event *event;
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size;
+
+  scene = SCENE_NEW (800, 600, 0);
+  g_assert_null (lp_scene_snapshot (scene, "png", 0, 0)); /* stopped */
+
+  media = lp_media_new (scene, SAMPLE_GNU);
+  g_assert_nonnull (media);
+  g_assert (lp_media_start (media));
+  event = await_filtered (scene, 1, LP_EVENT_MASK_START);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  event = await_filtered (scene, 2, LP_EVENT_MASK_TICK);
+  g_assert_nonnull (event);
+  g_object_unref (event);
+
+  /* Raw, scaled.  */
+  bytes = lp_scene_snapshot (scene, "RGBA", 80, 60);
+  g_assert_nonnull (bytes);
+  g_assert (g_bytes_get_size (bytes) == 80 * 60 * 4);
+  g_bytes_unref (bytes);
+
+  /* Encoded, natural size.  */
+  bytes = lp_scene_snapshot (scene, "png", 0, 0);
+  g_assert_nonnull (bytes);
+  data = (const guint8 *) g_bytes_get_data (bytes, &size);
+  g_assert (size > 8);
+  g_assert (memcmp (data, "\x89PNG\r\n\x1a\n", 8) == 0);
+  g_bytes_unref (bytes);
+
+  bytes = lp_scene_snapshot (scene, "jpeg", 160, 120);
+  g_assert_nonnull (bytes);
+  data = (const guint8 *) g_bytes_get_data (bytes, &size);
+  g_assert (size > 2);
+  g_assert (data[0] == 0xff && data[1] == 0xd8);
+  g_bytes_unref (bytes);
+
+  g_object_unref (scene);
+
+  exit (EXIT_SUCCESS);
+}